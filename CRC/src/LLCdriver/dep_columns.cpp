@@ -0,0 +1,388 @@
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "dep_columns.h"
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Columnar dependency files (see dep_columns.h for the format).              //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+static const unsigned char dep_col_padding[ 8 ] = { 0 };
+
+DEP_COLUMN_WRITER::DEP_COLUMN_WRITER()
+{
+    file         = NULL;
+    ok           = false;
+    written      = 0;
+    instructions = 0;
+    offsets      = NULL;
+    numOffsets   = 0;
+    maxOffsets   = 0;
+
+    ops      = new unsigned char [ DEP_COL_BLOCK_SIZE ];
+    srcs     = new unsigned char [ DEP_COL_BLOCK_SIZE * DEP_MAX_SRCS * DEP_COL_MAX_VARINT ];
+    pcs      = new unsigned char [ DEP_COL_BLOCK_SIZE * DEP_COL_MAX_VARINT ];
+    count    = 0;
+    srcBytes = 0;
+    pcBytes  = 0;
+    lastPC   = 0;
+}
+
+DEP_COLUMN_WRITER::~DEP_COLUMN_WRITER()
+{
+    if( file != NULL )
+    {
+        fclose( file );
+    }
+
+    free( offsets );
+    delete [] ops;
+    delete [] srcs;
+    delete [] pcs;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Creates the file with room for the header, which Finish() fills in.        //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+bool DEP_COLUMN_WRITER::Open( const char *name )
+{
+    DEP_COL_HEADER header;
+
+    file = fopen( name, "wb" );
+
+    if( file == NULL )
+    {
+        return false;
+    }
+
+    ok = true;
+
+    memset( &header, 0, sizeof(header) );
+    Write( &header, sizeof(header) );
+
+    return ok;
+}
+
+void DEP_COLUMN_WRITER::Write( const void *data, size_t bytes )
+{
+    if( bytes && fwrite( data, 1, bytes, file ) != bytes )
+    {
+        ok = false;
+    }
+
+    written += bytes;
+}
+
+UINT32 DEP_COLUMN_WRITER::PutVarint( unsigned char *p, Addr_t v )
+{
+    UINT32 n = 0;
+
+    while( v >= 0x80 )
+    {
+        p[ n++ ] = (unsigned char) (v | 0x80);
+        v >>= 7;
+    }
+
+    p[ n++ ] = (unsigned char) v;
+
+    return n;
+}
+
+void DEP_COLUMN_WRITER::Add( const DEP_RECORD *rec )
+{
+    assert( rec->type < DEP_MAX_TYPE && rec->numSrcs <= DEP_MAX_SRCS );
+
+    ops[ count++ ] = (unsigned char) (rec->type | (rec->numSrcs << DEP_COL_SRC_SHIFT));
+
+    for(UINT32 s=0; s<rec->numSrcs; s++)
+    {
+        srcBytes += PutVarint( &srcs[ srcBytes ], rec->srcs[s] );
+    }
+
+    if( rec->type == DEP_TAKEN || rec->type == DEP_NOT_TAKEN )
+    {
+        long long delta = (long long) (rec->PC - lastPC);
+
+        pcBytes += PutVarint( &pcs[ pcBytes ], (Addr_t) ((delta << 1) ^ (delta >> 63)) );
+        lastPC   = rec->PC;
+    }
+
+    instructions++;
+
+    if( count == DEP_COL_BLOCK_SIZE )
+    {
+        WriteBlock();
+    }
+}
+
+// Writes the block being filled, if any, at the next 8-byte boundary
+void DEP_COLUMN_WRITER::WriteBlock()
+{
+    if( count == 0 ) return;
+
+    if( numOffsets == maxOffsets )
+    {
+        maxOffsets = maxOffsets ? 2 * maxOffsets : 1024;
+        offsets    = (COUNTER *) realloc( offsets, (maxOffsets + 1) * sizeof(COUNTER) );
+        assert( offsets );
+    }
+
+    offsets[ numOffsets++ ] = written;
+
+    DEP_COL_BLOCK_HEADER header = { count, srcBytes, pcBytes, 0 };
+
+    Write( &header, sizeof(header) );
+    Write( ops, count );
+    Write( srcs, srcBytes );
+    Write( pcs, pcBytes );
+    Write( dep_col_padding, (8 - (written & 7)) & 7 );
+
+    count    = 0;
+    srcBytes = 0;
+    pcBytes  = 0;
+    lastPC   = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Writes the last block, the index after it and the header at the start,     //
+// and closes the file.                                                       //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+bool DEP_COLUMN_WRITER::Finish()
+{
+    DEP_COL_HEADER header;
+
+    WriteBlock();
+
+    if( offsets == NULL )
+    {
+        offsets = (COUNTER *) malloc( sizeof(COUNTER) );
+        assert( offsets );
+    }
+
+    memset( &header, 0, sizeof(header) );
+    memcpy( header.magic, DEP_COL_MAGIC, sizeof(header.magic) );
+    header.blockSize    = DEP_COL_BLOCK_SIZE;
+    header.numBlocks    = numOffsets;
+    header.instructions = instructions;
+    header.indexOffset  = written;
+
+    offsets[ numOffsets ] = written;
+    Write( offsets, (numOffsets + 1) * sizeof(COUNTER) );
+
+    if( fseek( file, 0, SEEK_SET ) != 0 || fwrite( &header, sizeof(header), 1, file ) != 1 )
+    {
+        ok = false;
+    }
+
+    if( fclose( file ) != 0 )
+    {
+        ok = false;
+    }
+
+    file = NULL;
+
+    return ok;
+}
+
+DEP_COLUMN_READER::DEP_COLUMN_READER()
+{
+    map     = NULL;
+    mapSize = 0;
+    header  = NULL;
+    index   = NULL;
+
+    Rewind();
+}
+
+DEP_COLUMN_READER::~DEP_COLUMN_READER()
+{
+    Close();
+}
+
+bool DEP_COLUMN_READER::IsColumnar( const char *name )
+{
+    FILE *file = fopen( name, "rb" );
+    char  magic[ 8 ];
+    bool  columnar = false;
+
+    if( file == NULL )
+    {
+        return false;
+    }
+
+    columnar = (fread( magic, sizeof(magic), 1, file ) == 1 && memcmp( magic, DEP_COL_MAGIC, sizeof(magic) ) == 0);
+    fclose( file );
+
+    return columnar;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Maps the whole file read-only; the blocks are decoded where they lie.      //
+// Returns false if the file cannot be mapped or its header, index or block   //
+// headers do not hold together.                                              //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+bool DEP_COLUMN_READER::Open( const char *name )
+{
+    struct stat st;
+
+    Close();
+
+    filename = name;
+
+    int fd = open( name, O_RDONLY );
+
+    if( fd < 0 )
+    {
+        return false;
+    }
+
+    if( fstat( fd, &st ) != 0 || st.st_size < (off_t) sizeof(DEP_COL_HEADER) )
+    {
+        close( fd );
+        return false;
+    }
+
+    void *addr = mmap( NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+
+    close( fd );
+
+    if( addr == MAP_FAILED )
+    {
+        return false;
+    }
+
+    map     = (const unsigned char *) addr;
+    mapSize = st.st_size;
+    header  = (const DEP_COL_HEADER *) map;
+
+    madvise( addr, mapSize, MADV_SEQUENTIAL );
+
+    if( !Check() )
+    {
+        cerr<<"Corrupt columnar dependency file "<<filename<<endl;
+        Close();
+        return false;
+    }
+
+    index = (const COUNTER *) &map[ header->indexOffset ];
+
+    Rewind();
+
+    return true;
+}
+
+// The header, the index and every block header against the file size
+bool DEP_COLUMN_READER::Check()
+{
+    if( memcmp( header->magic, DEP_COL_MAGIC, sizeof(header->magic) ) != 0 || header->blockSize == 0 )
+    {
+        return false;
+    }
+
+    COUNTER blocks = (header->instructions + header->blockSize - 1) / header->blockSize;
+
+    if( header->numBlocks != blocks || (header->indexOffset & 7)
+        || header->indexOffset < sizeof(DEP_COL_HEADER) || header->indexOffset > mapSize
+        || (mapSize - header->indexOffset) / sizeof(COUNTER) < (COUNTER) header->numBlocks + 1 )
+    {
+        return false;
+    }
+
+    const COUNTER *offsets = (const COUNTER *) &map[ header->indexOffset ];
+
+    if( offsets[ header->numBlocks ] != header->indexOffset )
+    {
+        return false;
+    }
+
+    for(UINT32 b=0; b<header->numBlocks; b++)
+    {
+        COUNTER start = offsets[b];
+        COUNTER end   = offsets[ b+1 ];
+
+        if( (start & 7) || start < sizeof(DEP_COL_HEADER) || start > end
+            || end - start < sizeof(DEP_COL_BLOCK_HEADER) )
+        {
+            return false;
+        }
+
+        const DEP_COL_BLOCK_HEADER *block = (const DEP_COL_BLOCK_HEADER *) &map[ start ];
+        COUNTER                     count = (b + 1 < header->numBlocks) ? header->blockSize
+                                            : header->instructions - (COUNTER) b * header->blockSize;
+
+        if( block->count != count
+            || sizeof(DEP_COL_BLOCK_HEADER) + (COUNTER) block->count + block->srcBytes + block->pcBytes > end - start )
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void DEP_COLUMN_READER::Rewind()
+{
+    block         = 0;
+    pos           = 0;
+    current.count = 0;
+    src           = NULL;
+    pc            = NULL;
+    lastPC        = 0;
+}
+
+void DEP_COLUMN_READER::Close()
+{
+    if( map != NULL )
+    {
+        munmap( (void *) map, mapSize );
+    }
+
+    map     = NULL;
+    mapSize = 0;
+    header  = NULL;
+    index   = NULL;
+
+    Rewind();
+}
+
+void DEP_COLUMN_READER::Block( UINT32 b, DEP_COL_BLOCK *view )
+{
+    assert( header && b < header->numBlocks );
+
+    const DEP_COL_BLOCK_HEADER *block = (const DEP_COL_BLOCK_HEADER *) &map[ index[b] ];
+
+    view->count   = block->count;
+    view->ops     = (const unsigned char *) (block + 1);
+    view->srcs    = view->ops + block->count;
+    view->srcsEnd = view->srcs + block->srcBytes;
+    view->pcs     = view->srcsEnd;
+    view->pcsEnd  = view->pcs + block->pcBytes;
+}
+
+// Moves on to the next block, false after the last
+bool DEP_COLUMN_READER::NextBlock()
+{
+    if( header == NULL || block == header->numBlocks )
+    {
+        return false;
+    }
+
+    Block( block++, &current );
+
+    pos    = 0;
+    src    = current.srcs;
+    pc     = current.pcs;
+    lastPC = 0;
+
+    return true;
+}
@@ -0,0 +1,211 @@
+#ifndef DEP_COLUMNS_H
+#define DEP_COLUMNS_H
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Columnar dependency files (*.dep.col), a binary form of the ASCII          //
+// dependency files that a reader maps into memory and decodes in place,      //
+// without gunzipping or tokenizing them.                                     //
+//                                                                            //
+// The instructions go in blocks of DEP_COL_BLOCK_SIZE, so instruction i of   //
+// the trace is in block i / DEP_COL_BLOCK_SIZE and every block can be found  //
+// through the index without decoding the ones before it. A block holds its   //
+// instructions in three columns:                                             //
+//                                                                            //
+//     ops      one byte per instruction: the type in bits 0-2 and the        //
+//              number of producer distances in bits 3-5                      //
+//     srcs     the producer distances of all its instructions, in order,     //
+//              as varints (7 bits per byte, low bits first)                  //
+//     pcs      the PCs of its branches, as zigzag encoded varint deltas to   //
+//              the previous branch of the block (to 0 for the first)         //
+//                                                                            //
+// The file is a header, the blocks and the index, in host byte order:        //
+//                                                                            //
+//     header   DEP_COL_HEADER, magic "DEPCOL01"                              //
+//     blocks   DEP_COL_BLOCK_HEADER, ops, srcs, pcs, padded to 8 bytes       //
+//     index    the file offset of every block and of the index itself        //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#include <cstdio>
+#include <cassert>
+#include <cstring>
+#include "utils.h"
+#include "dep_reader.h"
+
+#define DEP_COL_MAGIC       "DEPCOL01"
+#define DEP_COL_BLOCK_SIZE  4096        // instructions per block
+#define DEP_COL_MAX_VARINT  10
+#define DEP_COL_SRC_SHIFT   3
+
+typedef struct
+{
+    char        magic[ 8 ];
+    UINT32      blockSize;      // instructions per block
+    UINT32      numBlocks;
+    COUNTER     instructions;
+    COUNTER     indexOffset;
+} DEP_COL_HEADER;
+
+typedef struct
+{
+    UINT32      count;          // instructions, blockSize but in the last block
+    UINT32      srcBytes;
+    UINT32      pcBytes;
+    UINT32      pad;
+} DEP_COL_BLOCK_HEADER;
+
+// One block in place in the mapped file
+typedef struct
+{
+    UINT32                  count;
+    const unsigned char    *ops;
+    const unsigned char    *srcs;
+    const unsigned char    *srcsEnd;
+    const unsigned char    *pcs;
+    const unsigned char    *pcsEnd;
+} DEP_COL_BLOCK;
+
+// Converts dependency records to a columnar file
+class DEP_COLUMN_WRITER
+{
+  private:
+
+    FILE           *file;
+    bool            ok;
+    COUNTER         written;        // bytes, the offset of the next block
+    COUNTER         instructions;
+    COUNTER        *offsets;        // of the blocks written
+    UINT32          numOffsets;
+    UINT32          maxOffsets;
+
+    // the block being filled
+    unsigned char  *ops;
+    unsigned char  *srcs;
+    unsigned char  *pcs;
+    UINT32          count;
+    UINT32          srcBytes;
+    UINT32          pcBytes;
+    Addr_t          lastPC;
+
+  public:
+
+    DEP_COLUMN_WRITER();
+    ~DEP_COLUMN_WRITER();
+
+    bool        Open( const char *name );
+    void        Add( const DEP_RECORD *rec );
+    // Writes the last block and the index, false if anything failed
+    bool        Finish();
+
+    COUNTER     Instructions() { return instructions; }
+
+  private:
+
+    void        WriteBlock();
+    void        Write( const void *data, size_t bytes );
+    static UINT32 PutVarint( unsigned char *p, Addr_t v );
+};
+
+// Maps a columnar file and decodes it
+class DEP_COLUMN_READER
+{
+  private:
+
+    string                  filename;
+    const unsigned char    *map;
+    size_t                  mapSize;
+    const DEP_COL_HEADER   *header;
+    const COUNTER          *index;
+
+    // decoding position
+    UINT32                  block;
+    DEP_COL_BLOCK           current;
+    UINT32                  pos;
+    const unsigned char    *src;
+    const unsigned char    *pc;
+    Addr_t                  lastPC;
+
+  public:
+
+    DEP_COLUMN_READER();
+    ~DEP_COLUMN_READER();
+
+    // Whether name is a columnar file, by its magic
+    static bool IsColumnar( const char *name );
+
+    bool        Open( const char *name );
+    void        Rewind();
+    void        Close();
+
+    COUNTER     Instructions() { return header ? header->instructions : 0; }
+    UINT32      NumBlocks() { return header ? header->numBlocks : 0; }
+
+    // Block b in place, valid until Close
+    void        Block( UINT32 b, DEP_COL_BLOCK *view );
+
+    // Decodes the next instruction, returns false at the end of the file
+    inline bool Next( DEP_RECORD *rec );
+
+  private:
+
+    bool        Check();
+    bool        NextBlock();
+
+    static inline Addr_t GetVarint( const unsigned char **p, const unsigned char *end );
+};
+
+// 7 bits per byte, low bits first. A varint cut off by the end of its
+// column is corrupt
+inline Addr_t DEP_COLUMN_READER::GetVarint( const unsigned char **p, const unsigned char *end )
+{
+    Addr_t v     = 0;
+    UINT32 shift = 0;
+
+    for(;;)
+    {
+        assert( *p < end );
+
+        unsigned char byte = *(*p)++;
+
+        v |= (Addr_t) (byte & 0x7f) << shift;
+
+        if( !(byte & 0x80) ) return v;
+
+        shift += 7;
+    }
+}
+
+inline bool DEP_COLUMN_READER::Next( DEP_RECORD *rec )
+{
+    if( pos == current.count && !NextBlock() )
+    {
+        return false;
+    }
+
+    unsigned char op = current.ops[ pos++ ];
+
+    rec->type    = op & ((1 << DEP_COL_SRC_SHIFT) - 1);
+    rec->numSrcs = op >> DEP_COL_SRC_SHIFT;
+    rec->PC      = 0;
+
+    assert( rec->type < DEP_MAX_TYPE && rec->numSrcs <= DEP_MAX_SRCS );
+
+    for(UINT32 s=0; s<rec->numSrcs; s++)
+    {
+        rec->srcs[s] = (UINT32) GetVarint( &src, current.srcsEnd );
+    }
+
+    if( rec->type == DEP_TAKEN || rec->type == DEP_NOT_TAKEN )
+    {
+        Addr_t delta = GetVarint( &pc, current.pcsEnd );
+
+        lastPC += (Addr_t) ((long long) (delta >> 1) ^ -(long long) (delta & 1));
+        rec->PC = lastPC;
+    }
+
+    return true;
+}
+
+#endif
@@ -0,0 +1,223 @@
+#include <cctype>
+#include "dep_reader.h"
+#include "dep_columns.h"
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Reader for the instruction dependency files. See dep_reader.h for the      //
+// line format.                                                               //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+DEP_READER::DEP_READER()
+{
+    file     = NULL;
+    columns  = NULL;
+    buf      = new char [ DEP_BUFFER_SIZE ];
+    bufPos   = 0;
+    bufLen   = 0;
+    fileDone = true;
+
+    instructions = 0;
+}
+
+DEP_READER::~DEP_READER()
+{
+    Close();
+    delete [] buf;
+}
+
+bool DEP_READER::Open( const char *name )
+{
+    Close();
+
+    filename = name;
+
+    if( DEP_COLUMN_READER::IsColumnar( name ) )
+    {
+        columns = new DEP_COLUMN_READER;
+
+        if( !columns->Open( name ) )
+        {
+            delete columns;
+            columns = NULL;
+            return false;
+        }
+
+        instructions = 0;
+
+        return true;
+    }
+
+    file = gzopen( name, "rb" );
+
+    if( file == NULL )
+    {
+        return false;
+    }
+
+    gzbuffer( file, DEP_BUFFER_SIZE );
+
+    bufPos   = 0;
+    bufLen   = 0;
+    fileDone = false;
+
+    instructions = 0;
+
+    return true;
+}
+
+bool DEP_READER::Rewind()
+{
+    string name = filename;
+
+    return Open( name.c_str() );
+}
+
+void DEP_READER::Close()
+{
+    if( file != NULL )
+    {
+        gzclose( file );
+        file = NULL;
+    }
+
+    delete columns;
+    columns = NULL;
+
+    fileDone = true;
+    bufPos   = 0;
+    bufLen   = 0;
+}
+
+bool DEP_READER::DepName( const string &traceName, const char *suffix, string *depName )
+{
+    static const string traceSuffix = ".trace.gz";
+
+    if( traceName.size() <= traceSuffix.size()
+        || traceName.compare( traceName.size() - traceSuffix.size(), traceSuffix.size(), traceSuffix ) != 0 )
+    {
+        return false;
+    }
+
+    *depName = traceName.substr( 0, traceName.size() - traceSuffix.size() ) + suffix;
+
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Decodes one instruction: from the columns of a columnar file, or one line  //
+// of text. The buffer always holds a whole line (DEP_MAX_LINE) unless the    //
+// file ends first; a last line without a newline is accepted.                //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+bool DEP_READER::Next( DEP_RECORD *rec )
+{
+    if( columns )
+    {
+        if( !columns->Next( rec ) ) return false;
+
+        instructions++;
+        return true;
+    }
+
+    if( bufLen - bufPos < DEP_MAX_LINE && !fileDone )
+    {
+        Refill();
+    }
+
+    if( bufPos >= bufLen )
+    {
+        return false;
+    }
+
+    const char *p   = &buf[ bufPos ];
+    const char *end = &buf[ bufLen ];
+
+    switch( *p )
+    {
+      case 'A': rec->type = DEP_ALU;        break;
+      case 'L': rec->type = DEP_LOAD;       break;
+      case 'S': rec->type = DEP_STORE;      break;
+      case 'C': rec->type = DEP_CALL;       break;
+      case 'T': rec->type = DEP_TAKEN;      break;
+      case 'N': rec->type = DEP_NOT_TAKEN;  break;
+
+      default:
+        cerr<<"Corrupt dependency record '"<<*p<<"' in "<<filename<<endl;
+        assert(0);
+        bufPos = bufLen;
+        return false;
+    }
+
+    rec->numSrcs = 0;
+    rec->PC      = 0;
+
+    for(p++; p < end && *p != '\n'; )
+    {
+        if( *p == ' ' )
+        {
+            p++;
+        }
+        else if( *p >= '0' && *p <= '9' )
+        {
+            UINT32 distance = 0;
+
+            for(; p < end && *p >= '0' && *p <= '9'; p++)
+            {
+                distance = distance * 10 + (*p - '0');
+            }
+
+            if( rec->numSrcs < DEP_MAX_SRCS )
+            {
+                rec->srcs[ rec->numSrcs++ ] = distance;
+            }
+        }
+        else if( end - p >= 3 && strncmp( p, "PC:", 3 ) == 0 )
+        {
+            for(p += 3; p < end && *p == ' '; p++);
+
+            for(; p < end && isxdigit( *p ); p++)
+            {
+                rec->PC = (rec->PC << 4) | (isdigit( *p ) ? *p - '0' : (tolower( *p ) - 'a' + 10));
+            }
+        }
+        else
+        {
+            cerr<<"Corrupt dependency line in "<<filename<<" after "<<instructions<<" instructions"<<endl;
+            assert(0);
+            bufPos = bufLen;
+            return false;
+        }
+    }
+
+    // past the newline
+    bufPos = (p - buf) + (p < end);
+    instructions++;
+
+    return true;
+}
+
+void DEP_READER::Refill()
+{
+    UINT32 left = bufLen - bufPos;
+
+    memmove( buf, &buf[ bufPos ], left );
+    bufPos = 0;
+    bufLen = left;
+
+    while( !fileDone && bufLen < DEP_BUFFER_SIZE )
+    {
+        int got = gzread( file, &buf[ bufLen ], DEP_BUFFER_SIZE - bufLen );
+
+        if( got <= 0 )
+        {
+            fileDone = true;
+            break;
+        }
+
+        bufLen += got;
+    }
+}
@@ -0,0 +1,104 @@
+#ifndef DEP_READER_H
+#define DEP_READER_H
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Reader for the instruction dependency files (*.dep.gz) that                //
+// CMPsim.gentrace writes next to the binary trace, for out-of-order          //
+// timing models. The reader also takes their columnar conversion (see        //
+// dep_columns.h), which it tells apart by its magic.                         //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#include <zlib.h>
+#include <cassert>
+#include <cstring>
+#include "utils.h"
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// The file is gzip'ed ASCII, one line per instruction in the order of the    //
+// trace's instruction stream:                                                //
+//                                                                            //
+//     <type> [<distance>...] [ PC: <hex>]                                    //
+//                                                                            //
+// type is A (ALU), L (load), S (store), C (call, which stores its return     //
+// address), T (taken branch) or N (branch not taken). Each distance names    //
+// a producer of the instruction's sources, that many instructions back.      //
+// Branches end with their PC:                                                //
+//                                                                            //
+//     L 15 1                                                                 //
+//     T 2 1  PC: 7f95c2d831b8                                                //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+typedef enum
+{
+    DEP_ALU         = 0,
+    DEP_LOAD        = 1,
+    DEP_STORE       = 2,
+    DEP_CALL        = 3,
+    DEP_TAKEN       = 4,
+    DEP_NOT_TAKEN   = 5,
+    DEP_MAX_TYPE    = 6
+} DepRecordTypes;
+
+#define DEP_MAX_SRCS        4       // further sources are dropped
+#define DEP_BUFFER_SIZE     (1 << 20)
+#define DEP_MAX_LINE        256
+
+#define DEP_TEXT_SUFFIX     ".dep.gz"
+#define DEP_COLUMN_SUFFIX   ".dep.col"
+
+// One decoded instruction
+typedef struct
+{
+    UINT32  type;
+    UINT32  numSrcs;
+    UINT32  srcs[ DEP_MAX_SRCS ];   // distances back to the producers
+    Addr_t  PC;                     // branches only, 0 otherwise
+} DEP_RECORD;
+
+class DEP_COLUMN_READER;
+
+class DEP_READER
+{
+  private:
+    string          filename;
+    gzFile          file;
+    DEP_COLUMN_READER *columns;     // a columnar file, NULL for text
+
+    // decompressed bytes not yet decoded are buf[bufPos..bufLen)
+    char           *buf;
+    UINT32          bufPos;
+    UINT32          bufLen;
+    bool            fileDone;
+
+    COUNTER         instructions;
+
+  public:
+
+    DEP_READER();
+    ~DEP_READER();
+
+    bool    Open( const char *name );
+    bool    Rewind();
+    void    Close();
+
+    // Decodes the next instruction, returns false at the end of the file
+    bool    Next( DEP_RECORD *rec );
+
+    const string & Name() { return filename; }
+    COUNTER Instructions() { return instructions; }
+
+    // A dependency file of a binary trace: X.trace.gz -> X<suffix>. False
+    // if the trace name does not end in .trace.gz
+    static bool DepName( const string &traceName, const char *suffix, string *depName );
+
+  private:
+
+    void    Refill();
+};
+
+#endif
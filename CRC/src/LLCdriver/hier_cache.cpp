@@ -0,0 +1,237 @@
+#include <iomanip>
+#include "hier_cache.h"
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Private upper-level caches of the open driver (see hier_cache.h).          //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+static const char *hier_access_names[] =
+{
+    "iFetch",
+    "Load",
+    "Store",
+    "-NOP0-",
+    "-NOP1-",
+    "Prefetch",
+    "WriteBack"
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// The constructor for the cache with appropriate cache parameters as args    //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+HIER_CACHE::HIER_CACHE( const char *_name, UINT32 _level, UINT32 _core, UINT32 _cacheSize, UINT32 _assoc, UINT32 _linesize )
+{
+    name      = _name;
+    level     = _level;
+    core      = _core;
+    numsets   = _cacheSize / (_linesize * _assoc);
+    assoc     = _assoc;
+    linesize  = _linesize;
+
+    // upper levels keep their LRU stacks packed
+    assert(assoc <= CRC_PACKED_LRU_MAX_ASSOC);
+
+    lineShift = CRC_FloorLog2( linesize );
+    indexMask = numsets - 1;
+    wayMask   = CRC_WayMask( assoc );
+
+    tags  = (Addr_t *) CRC_AlignedCalloc( numsets * assoc, sizeof(Addr_t) );
+    valid = (BITVECTOR *) CRC_AlignedCalloc( numsets, sizeof(BITVECTOR) );
+    dirty = (BITVECTOR *) CRC_AlignedCalloc( numsets, sizeof(BITVECTOR) );
+    lru   = (CRC_LRU_STACK *) CRC_AlignedCalloc( numsets, sizeof(CRC_LRU_STACK) );
+
+    assert(tags && valid && dirty && lru);
+
+    for(UINT32 setIndex=0; setIndex<numsets; setIndex++) 
+    {
+        lru[ setIndex ] = CRC_PackedLRU_Init( assoc );
+    }
+
+    for(UINT32 a=0; a<ACCESS_MAX; a++) 
+    {
+        hits[a]   = 0;
+        misses[a] = 0;
+    }
+
+    writebacks = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Looks up a line and fills it on a miss. Returns true on a hit. If the      //
+// fill displaced a valid line, victim describes it so the caller can         //
+// write it back. Writebacks from the level above mark the line dirty         //
+// but do not change its LRU position.                                        //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+bool HIER_CACHE::Access( Addr_t addr, UINT32 accessType, HIER_VICTIM *victim )
+{
+    Addr_t     line     = addr >> lineShift;
+    UINT32     setIndex = line & indexMask;
+    Addr_t    *currSet  = &tags[ setIndex * assoc ];
+    bool       isStore  = (accessType == ACCESS_STORE) || (accessType == ACCESS_WRITEBACK);
+    INT32      hitWay   = Find( setIndex, line );
+
+    victim->valid = false;
+
+    if( hitWay != -1 ) 
+    {
+        UINT32 way = hitWay;
+
+        if( isStore ) 
+        {
+            dirty[ setIndex ] |= 1ULL << way;
+        }
+
+        if( accessType != ACCESS_WRITEBACK ) 
+        {
+            lru[ setIndex ] = CRC_PackedLRU_Promote( lru[ setIndex ], way );
+        }
+
+        hits[ accessType ]++;
+        return true;
+    }
+
+    misses[ accessType ]++;
+
+    // Fill invalid ways first, then replace the LRU line
+    BITVECTOR invalid = ~valid[ setIndex ] & wayMask;
+    UINT32    way;
+
+    if( invalid ) 
+    {
+        way = CRC_CountTrailingZeros64( invalid );
+    }
+    else 
+    {
+        way = CRC_PackedLRU_Find( lru[ setIndex ], assoc-1 );
+
+        victim->valid = true;
+        victim->dirty = (dirty[ setIndex ] >> way) & 1;
+        victim->addr  = currSet[ way ] << lineShift;
+
+        if( victim->dirty ) 
+        {
+            writebacks++;
+        }
+    }
+
+    currSet[ way ]     = line;
+    valid[ setIndex ] |= 1ULL << way;
+
+    if( isStore ) 
+    {
+        dirty[ setIndex ] |= 1ULL << way;
+    }
+    else 
+    {
+        dirty[ setIndex ] &= ~(1ULL << way);
+    }
+
+    lru[ setIndex ] = CRC_PackedLRU_Promote( lru[ setIndex ], way );
+
+    return false;
+}
+
+// The valid way that holds line in its set, -1 if none
+inline INT32 HIER_CACHE::Find( UINT32 setIndex, Addr_t line )
+{
+    Addr_t    *currSet = &tags[ setIndex * assoc ];
+    BITVECTOR  match   = 0;
+
+    for(UINT32 way=0; way<assoc; way++) 
+    {
+        match |= (BITVECTOR) (currSet[ way ] == line) << way;
+    }
+
+    match &= valid[ setIndex ];
+
+    return match ? (INT32) CRC_CountTrailingZeros64( match ) : -1;
+}
+
+bool HIER_CACHE::Invalidate( Addr_t addr, bool *wasDirty )
+{
+    Addr_t line     = addr >> lineShift;
+    UINT32 setIndex = line & indexMask;
+    INT32  way      = Find( setIndex, line );
+
+    if( way == -1 ) return false;
+
+    *wasDirty          = (dirty[ setIndex ] >> way) & 1;
+    valid[ setIndex ] &= ~(1ULL << way);
+    dirty[ setIndex ] &= ~(1ULL << way);
+
+    return true;
+}
+
+void HIER_CACHE::MarkDirty( Addr_t addr )
+{
+    Addr_t line     = addr >> lineShift;
+    UINT32 setIndex = line & indexMask;
+    INT32  way      = Find( setIndex, line );
+
+    if( way != -1 ) 
+    {
+        dirty[ setIndex ] |= 1ULL << way;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// The function prints the statistics for the cache in the layout of the      //
+// CMPsim stats files                                                         //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+ostream & HIER_CACHE::PrintStats( ostream &out )
+{
+    COUNTER totHits = 0, totMisses = 0;
+
+    out<<"Experiment: 0 Level: "<<level<<" CacheID: "<<core<<endl;
+    out<<name<<":   "<<endl;
+    out<<endl;
+    out<<"  Cache Size: "<<(numsets*assoc*linesize/1024)<<"K ("<<(numsets*assoc*linesize)<<" bytes)"<<endl;
+    out<<"  Line Size: "<<linesize<<"B"<<endl;
+    out<<"  Associativity: "<<assoc<<endl;
+    out<<"  Number of Banks: 1"<<endl;
+    out<<"  Replacement Type: -- True LRU --"<<endl;
+    out<<endl;
+
+    for(UINT32 a=0; a<ACCESS_MAX; a++) 
+    {
+        COUNTER accesses = hits[a] + misses[a];
+
+        if( accesses == 0 ) continue;
+
+        out<<setw(18)<<hier_access_names[a]<<" Hits:    "<<setw(12)<<hits[a]<<endl;
+        out<<setw(18)<<hier_access_names[a]<<" Misses:  "<<setw(12)<<misses[a]<<endl;
+        out<<setw(18)<<hier_access_names[a]<<" Accesses:"<<setw(12)<<accesses<<endl;
+        out<<setw(18)<<hier_access_names[a]<<" Miss Rate:"<<setw(11)<<(misses[a]*100/accesses)<<"%"<<endl;
+        out<<endl;
+
+        totHits   += hits[a];
+        totMisses += misses[a];
+    }
+
+    COUNTER totAccesses = totHits + totMisses;
+
+    out<<"        Total Hits:    "<<setw(12)<<totHits<<endl;
+    out<<"        Total Misses:  "<<setw(12)<<totMisses<<endl;
+    out<<"        Total Accesses:"<<setw(12)<<totAccesses<<endl;
+    out<<"        Total Miss Rate:"<<setw(11)<<(totAccesses ? totMisses*100/totAccesses : 0)<<"%"<<endl;
+    out<<endl;
+    out<<endl;
+    out<<"Per Thread Access Statistics:"<<endl;
+    out<<"\tThread "<<core<<": Accesses: "<<setw(13)<<totAccesses<<" Misses: "<<setw(13)<<totMisses
+       <<" Miss Rate: "<<setw(13)<<(totAccesses ? totMisses*100/totAccesses : 0)<<"%"<<endl;
+    out<<endl;
+    out<<"Total Number of Write Backs: "<<writebacks<<endl;
+    out<<endl;
+    out<<endl;
+
+    return out;
+}
@@ -0,0 +1,75 @@
+#ifndef HIER_CACHE_H
+#define HIER_CACHE_H
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Private upper-level caches (IL1, DL1, MLC) of the open driver. These are   //
+// fixed true-LRU, write-back, write-allocate caches that only exist to       //
+// produce the LLC reference stream, so they are kept as lean as possible.    //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#include <cassert>
+#include "utils.h"
+#include "crc_cache_defs.h"
+
+// Line pushed out of a cache by a fill
+typedef struct
+{
+    bool    valid;
+    bool    dirty;
+    Addr_t  addr;
+} HIER_VICTIM;
+
+class HIER_CACHE
+{
+  private:
+
+    // parameters
+    string  name;
+    UINT32  level;
+    UINT32  core;
+    UINT32  numsets;
+    UINT32  assoc;
+    UINT32  linesize;
+
+    // Lookup Parameters
+    UINT32  lineShift;
+    UINT32  indexMask;
+    BITVECTOR wayMask;
+
+    // set-major line addresses, valid/dirty masks and packed LRU stacks
+    Addr_t        *tags;
+    BITVECTOR     *valid;
+    BITVECTOR     *dirty;
+    CRC_LRU_STACK *lru;
+
+    // statistics
+    COUNTER hits[ ACCESS_MAX ];
+    COUNTER misses[ ACCESS_MAX ];
+    COUNTER writebacks;
+
+  public:
+
+    HIER_CACHE( const char *_name, UINT32 _level, UINT32 _core, UINT32 _cacheSize, UINT32 _assoc, UINT32 _linesize=64 );
+
+    bool    Access( Addr_t addr, UINT32 accessType, HIER_VICTIM *victim );
+    void    CountHits( UINT32 accessType, COUNTER n ) { hits[ accessType ] += n; }
+
+    // Back-invalidation from an inclusive LLC: drops the line if present.
+    // Returns true if it was, with wasDirty telling whether it was dirty
+    bool    Invalidate( Addr_t addr, bool *wasDirty );
+    // A line that came up dirty from an exclusive LLC
+    void    MarkDirty( Addr_t addr );
+
+    ostream &   PrintStats( ostream &out );
+
+    UINT32  LineShift() { return lineShift; }
+
+  private:
+
+    inline INT32 Find( UINT32 setIndex, Addr_t line );
+};
+
+#endif
@@ -0,0 +1,215 @@
+#include "interval_sampler.h"
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Interval time series of the LLC instances (see interval_sampler.h).        //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+static const char *interval_side_names[][2] =
+{
+    { "LRU",   "CLOCK" },   // CONTESTANT
+    { "SRRIP", "BRRIP" }    // DRRIP
+};
+
+INTERVAL_SAMPLER::INTERVAL_SAMPLER( LLC_GROUP *_llcs, UINT32 _threads, UINT32 _unit, COUNTER _interval )
+{
+    assert( _interval > 0 );
+
+    llcs     = _llcs;
+    threads  = _threads;
+    unit     = _unit;
+    interval = _interval;
+
+    file = NULL;
+    csv  = false;
+    ok   = false;
+
+    samples          = 0;
+    lastInstructions = 0;
+    last             = new INTERVAL_TOTALS[ llcs->NumLLCs() ];
+
+    memset( last, 0, llcs->NumLLCs() * sizeof(INTERVAL_TOTALS) );
+}
+
+INTERVAL_SAMPLER::~INTERVAL_SAMPLER()
+{
+    if( file != NULL )
+    {
+        fclose( file );
+    }
+
+    delete [] last;
+}
+
+bool INTERVAL_SAMPLER::ParseInterval( const char *arg, UINT32 *unit, COUNTER *interval )
+{
+    char *end;
+
+    *interval = strtoull( arg, &end, 10 );
+    *unit     = INTERVAL_INSTRUCTIONS;
+
+    if( end == arg || *interval == 0 )
+    {
+        return false;
+    }
+
+    if( *end == '\0' || strcmp( end, ":instrs" ) == 0 )
+    {
+        return true;
+    }
+
+    *unit = INTERVAL_REFERENCES;
+
+    return strcmp( end, ":refs" ) == 0;
+}
+
+bool INTERVAL_SAMPLER::Open( const char *name )
+{
+    size_t length = strlen( name );
+
+    csv  = (length >= 4 && strcmp( name + length - 4, ".csv" ) == 0);
+    file = fopen( name, csv ? "w" : "wb" );
+
+    if( file == NULL )
+    {
+        return false;
+    }
+
+    ok = true;
+
+    if( csv )
+    {
+        ok = fprintf( file, "interval,instructions,llc,name,lookups,misses,miss_rate,mpki,writebacks,"
+                            "psel,follower_side,leader0_misses,leader1_misses\n" ) > 0;
+        return ok;
+    }
+
+    INTERVAL_HEADER header;
+
+    memset( &header, 0, sizeof(header) );
+    memcpy( header.magic, INTERVAL_MAGIC, sizeof(header.magic) );
+    header.numLLCs  = llcs->NumLLCs();
+    header.unit     = unit;
+    header.interval = interval;
+
+    ok = (fwrite( &header, sizeof(header), 1, file ) == 1);
+
+    for(UINT32 i=0; i<llcs->NumLLCs() && ok; i++)
+    {
+        char llcName[ INTERVAL_NAME_SIZE ];
+
+        memset( llcName, 0, sizeof(llcName) );
+        strncpy( llcName, llcs->Name(i).c_str(), sizeof(llcName) - 1 );
+
+        ok = (fwrite( llcName, sizeof(llcName), 1, file ) == 1);
+    }
+
+    return ok;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// One row per instance: its counters since the last sample and the state of  //
+// its set duel now. MPKI is over the instructions of all threads.            //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+void INTERVAL_SAMPLER::Sample( COUNTER instructions )
+{
+    COUNTER kilo = instructions - lastInstructions;
+
+    for(UINT32 i=0; i<llcs->NumLLCs(); i++)
+    {
+        CRC_CACHE               *llc   = llcs->LLC(i);
+        CACHE_REPLACEMENT_STATE *state = llc->ReplacementState();
+        INTERVAL_TOTALS         *prev  = &last[i];
+        INTERVAL_TOTALS          now;
+        INTERVAL_RECORD          rec;
+
+        memset( &now, 0, sizeof(now) );
+
+        for(UINT32 t=0; t<threads; t++)
+        {
+            now.lookups    += llc->ThreadDemandLookupStats(t);
+            now.misses     += llc->ThreadDemandMissStats(t);
+            now.writebacks += llc->ThreadWritebackStats(t);
+        }
+
+        memset( &rec, 0, sizeof(rec) );
+        rec.interval     = samples;
+        rec.instructions = instructions;
+        rec.llc          = i;
+        rec.lookups      = (now.lookups - prev->lookups) * llc->SampleRatio();
+        rec.misses       = (now.misses - prev->misses) * llc->SampleRatio();
+        rec.writebacks   = (now.writebacks - prev->writebacks) * llc->SampleRatio();
+
+        if( state->Dueling() )
+        {
+            now.leaderMisses[0] = state->LeaderMisses(0);
+            now.leaderMisses[1] = state->LeaderMisses(1);
+
+            rec.psel            = state->Psel();
+            rec.side            = state->FollowerSide();
+            rec.leaderMisses[0] = now.leaderMisses[0] - prev->leaderMisses[0];
+            rec.leaderMisses[1] = now.leaderMisses[1] - prev->leaderMisses[1];
+        }
+
+        *prev = now;
+
+        if( !ok ) continue;
+
+        if( !csv )
+        {
+            ok = (fwrite( &rec, sizeof(rec), 1, file ) == 1);
+            continue;
+        }
+
+        const char *side = "-";
+
+        if( state->Dueling() )
+        {
+            side = interval_side_names[ llcs->Config(i)->replPolicy == CRC_REPL_DRRIP ][ rec.side ];
+        }
+
+        ok = fprintf( file, "%llu,%llu,%u,%s,%llu,%llu,%.4f,%.4f,%llu,%u,%s,%llu,%llu\n",
+                      rec.interval, rec.instructions, i, llcs->Name(i).c_str(), rec.lookups, rec.misses,
+                      rec.lookups ? (double) rec.misses / (double) rec.lookups * 100.0 : 0.0,
+                      kilo ? (double) rec.misses * 1000.0 / (double) kilo : 0.0,
+                      rec.writebacks, rec.psel, side, rec.leaderMisses[0], rec.leaderMisses[1] ) > 0;
+    }
+
+    lastInstructions = instructions;
+    samples++;
+}
+
+bool INTERVAL_SAMPLER::Finish( COUNTER instructions )
+{
+    bool pending = (instructions != lastInstructions);
+
+    for(UINT32 i=0; i<llcs->NumLLCs() && !pending; i++)
+    {
+        COUNTER lookups = 0;
+
+        for(UINT32 t=0; t<threads; t++)
+        {
+            lookups += llcs->LLC(i)->ThreadDemandLookupStats(t);
+        }
+
+        pending = (lookups != last[i].lookups);
+    }
+
+    if( pending )
+    {
+        Sample( instructions );
+    }
+
+    if( fclose( file ) != 0 )
+    {
+        ok = false;
+    }
+
+    file = NULL;
+
+    return ok;
+}
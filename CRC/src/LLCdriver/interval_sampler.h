@@ -0,0 +1,111 @@
+#ifndef INTERVAL_SAMPLER_H
+#define INTERVAL_SAMPLER_H
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Interval time series of the LLC instances: every interval instructions     //
+// (of all threads) or LLC references, one row per instance with its demand   //
+// lookups, misses, miss rate, MPKI and writebacks in the interval and, for   //
+// the set-dueling policies (CONTESTANT and DRRIP), PSEL at its end, the      //
+// side the follower sets run and the misses of each side's leader sets in    //
+// the interval. The rows show phase changes next to the policy switches.     //
+// Sampled instances count their sampled sets, scaled up to all sets.         //
+//                                                                            //
+// A file named *.csv gets one line per row under a header line. Any other    //
+// name gets the binary form, in host byte order:                             //
+//                                                                            //
+//     header   INTERVAL_HEADER, magic "LLCIVL01", then the name of every     //
+//              instance in INTERVAL_NAME_SIZE bytes, NUL padded              //
+//     rows     INTERVAL_RECORD                                               //
+//                                                                            //
+// The hierarchy counts down to the next sample, so without a sampler the     //
+// cost is one branch that is never taken.                                    //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#include <cstdio>
+#include "utils.h"
+#include "llc_group.h"
+
+#define INTERVAL_MAGIC      "LLCIVL01"
+#define INTERVAL_NAME_SIZE  64
+
+typedef enum
+{
+    INTERVAL_INSTRUCTIONS = 0,
+    INTERVAL_REFERENCES   = 1
+} IntervalUnits;
+
+typedef struct
+{
+    char        magic[ 8 ];
+    UINT32      numLLCs;
+    UINT32      unit;           // IntervalUnits
+    COUNTER     interval;       // instructions or references
+} INTERVAL_HEADER;
+
+typedef struct
+{
+    COUNTER     interval;       // number, from 0
+    COUNTER     instructions;   // all threads, at its end
+    COUNTER     lookups;        // demand, in the interval
+    COUNTER     misses;
+    COUNTER     writebacks;
+    COUNTER     leaderMisses[ 2 ];
+    UINT32      llc;
+    UINT32      psel;           // 0 and side 0 unless the policy duels
+    UINT32      side;           // SWITCHABLE_POLICY or RRIP_INSERTION
+    UINT32      pad;
+} INTERVAL_RECORD;
+
+// The counters of an instance at the end of the last interval
+typedef struct
+{
+    COUNTER     lookups;
+    COUNTER     misses;
+    COUNTER     writebacks;
+    COUNTER     leaderMisses[ 2 ];
+} INTERVAL_TOTALS;
+
+class INTERVAL_SAMPLER
+{
+  private:
+
+    LLC_GROUP  *llcs;
+    UINT32      threads;
+    UINT32      unit;
+    COUNTER     interval;
+
+    FILE       *file;
+    bool        csv;
+    bool        ok;
+
+    COUNTER     samples;
+    COUNTER     lastInstructions;
+    INTERVAL_TOTALS *last;      // per instance
+
+  public:
+
+    INTERVAL_SAMPLER( LLC_GROUP *_llcs, UINT32 _threads, UINT32 _unit, COUNTER _interval );
+    ~INTERVAL_SAMPLER();
+
+    // Creates the file and writes its header, CSV if name ends in .csv
+    bool        Open( const char *name );
+
+    // Parses <n>[:instrs|:refs], instructions if no unit is given
+    static bool ParseInterval( const char *arg, UINT32 *unit, COUNTER *interval );
+
+    UINT32      Unit() { return unit; }
+    COUNTER     Interval() { return interval; }
+
+    // Writes the rows of the interval that ends at instructions
+    void        Sample( COUNTER instructions );
+    // Writes the rows of the last, partial interval if it saw anything,
+    // and closes the file; false if anything failed
+    bool        Finish( COUNTER instructions );
+
+    COUNTER     Samples() { return samples; }
+};
+
+#endif
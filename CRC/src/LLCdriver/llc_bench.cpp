@@ -0,0 +1,253 @@
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Microbenchmark of the LLC access path. Feeds the same synthetic stream     //
+// of LLC references to one CRC_CACHE per replacement policy and reports      //
+// the accesses per second of each:                                           //
+//                                                                            //
+//   LLCbench [-cache UL3:1024:64:16] [-refs <millions>] [-runs <n>]          //
+//            [-LLCrepl <policy>[,<policy>...]]                               //
+//                                                                            //
+// The stream mixes a working set half the size of the cache, one four        //
+// times its size and a scan, from a few hundred PCs, with loads, stores,     //
+// instruction fetches and writebacks, so every policy takes both its hit     //
+// and its victim path. It is generated before the timed loop, and the        //
+// OPT index is built from it outside the timing as well. Each policy runs    //
+// the stream -runs times on a fresh cache and the fastest run is reported.   //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#include <cstdio>
+#include <sstream>
+#include <sys/time.h>
+#include <unistd.h>
+#include "utils.h"
+#include "crc_cache.h"
+#include "llc_group.h"
+
+#define BENCH_PCS           256
+#define BENCH_MAX_POLICIES  (CRC_REPL_UCP + 1)
+
+typedef struct
+{
+    Addr_t *PC;
+    Addr_t *paddr;
+    UINT8  *accessType;
+    COUNTER refs;
+} BENCH_STREAM;
+
+static void Usage( const char *prog )
+{
+    cerr<<"Usage: "<<prog<<" [-cache UL3:<KB>:<linesize>:<assoc>] [-refs <millions>] [-runs <n>]"<<endl;
+    cerr<<"       [-LLCrepl <policy>[,<policy>...]]"<<endl;
+}
+
+static double Seconds()
+{
+    struct timeval tv;
+    gettimeofday( &tv, NULL );
+    return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Generates the reference stream for a cache of cacheLines lines. Each       //
+// reference draws one hash: 50% go to the small working set, 30% to the      //
+// large one and 20% continue the scan.                                       //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+static void MakeStream( BENCH_STREAM *stream, COUNTER refs, UINT32 cacheLines, UINT32 linesize )
+{
+    stream->refs       = refs;
+    stream->PC         = (Addr_t *) malloc( refs * sizeof(Addr_t) );
+    stream->paddr      = (Addr_t *) malloc( refs * sizeof(Addr_t) );
+    stream->accessType = (UINT8 *) malloc( refs );
+
+    assert( stream->PC && stream->paddr && stream->accessType );
+
+    Addr_t small = cacheLines / 2;
+    Addr_t large = cacheLines * 4;
+    Addr_t scan  = 0;
+
+    for(COUNTER i=0; i<refs; i++)
+    {
+        Addr_t h    = CRC_Mix64( i );
+        UINT32 pick = h % 100;
+        UINT32 pc   = (h >> 8) % BENCH_PCS;
+        Addr_t line;
+
+        if( pick < 50 )      line = (h >> 16) % small;
+        else if( pick < 80 ) line = (1ULL << 32) + (h >> 16) % large;
+        else                 line = (2ULL << 32) + scan++;
+
+        UINT32 type = (h >> 40) % 10;
+
+        stream->PC[i]         = 0x400000 + pc * 16 + (pick < 80 ? 0 : 8);
+        stream->paddr[i]      = line * linesize;
+        stream->accessType[i] = (type < 5) ? ACCESS_LOAD : (type < 7) ? ACCESS_STORE
+                                : (type < 9) ? ACCESS_IFETCH : ACCESS_WRITEBACK;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Writes the next-use index of the stream to indexName for the OPT caches.   //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+static bool BuildOptIndex( const BENCH_STREAM *stream, UINT32 linesize, const char *indexName )
+{
+    OPT_INDEX_WRITER *writer = new OPT_INDEX_WRITER;
+    UINT32            shift  = CRC_FloorLog2( linesize );
+    bool              ok     = writer->Open( indexName );
+
+    for(COUNTER i=0; ok && i<stream->refs; i++)
+    {
+        writer->Add( stream->paddr[i] >> shift );
+    }
+
+    ok = ok && writer->Finish();
+    delete writer;
+
+    return ok;
+}
+
+int main( int argc, char *argv[] )
+{
+    UINT32  sizeKB   = 1024;
+    UINT32  linesize = 64;
+    UINT32  assoc    = 16;
+    COUNTER refs     = 20000000;
+    UINT32  runs     = 3;
+    UINT32  policies[ BENCH_MAX_POLICIES ];
+    UINT32  numPolicies = 0;
+
+    for(int i=1; i<argc; i++)
+    {
+        string opt = argv[i];
+        char  *arg = (i+1 < argc) ? argv[i+1] : NULL;
+
+        if( arg == NULL )
+        {
+            Usage( argv[0] );
+            return 1;
+        }
+
+        if( opt == "-cache" )
+        {
+            if( sscanf( arg, "UL3:%u:%u:%u", &sizeKB, &linesize, &assoc ) != 3 )
+            {
+                Usage( argv[0] );
+                return 1;
+            }
+        }
+        else if( opt == "-refs" ) refs = strtoull( arg, NULL, 10 ) * 1000000ULL;
+        else if( opt == "-runs" ) runs = atoi( arg );
+        else if( opt == "-LLCrepl" )
+        {
+            for(char *pol = arg; pol; )
+            {
+                if( numPolicies == BENCH_MAX_POLICIES || (UINT32) atoi( pol ) >= BENCH_MAX_POLICIES )
+                {
+                    Usage( argv[0] );
+                    return 1;
+                }
+
+                policies[ numPolicies++ ] = atoi( pol );
+
+                pol = strchr( pol, ',' );
+                if( pol ) pol++;
+            }
+        }
+        else
+        {
+            Usage( argv[0] );
+            return 1;
+        }
+
+        i++;
+    }
+
+    // Every policy by default
+    if( numPolicies == 0 )
+    {
+        for( ; numPolicies < BENCH_MAX_POLICIES; numPolicies++)
+        {
+            policies[ numPolicies ] = numPolicies;
+        }
+    }
+
+    if( refs == 0 || runs == 0 || linesize == 0 || assoc == 0 || assoc > 64 )
+    {
+        Usage( argv[0] );
+        return 1;
+    }
+
+    BENCH_STREAM stream;
+    MakeStream( &stream, refs, sizeKB * 1024 / linesize, linesize );
+
+    ostringstream indexName;
+    indexName<<P_tmpdir<<"/LLCbench."<<getpid()<<".opt";
+
+    bool haveIndex = false;
+
+    cout<<"UL3:"<<sizeKB<<":"<<linesize<<":"<<assoc<<", "<<refs<<" references, best of "<<runs<<" runs"<<endl;
+
+    for(UINT32 p=0; p<numPolicies; p++)
+    {
+        bool    opt    = (policies[p] == CRC_REPL_OPT || policies[p] == CRC_REPL_OPT_BYPASS);
+        COUNTER misses = 0;
+        double  best   = 0;
+
+        if( opt && !haveIndex )
+        {
+            if( !BuildOptIndex( &stream, linesize, indexName.str().c_str() ) )
+            {
+                cerr<<"Cannot build the OPT index "<<indexName.str()<<endl;
+                return 1;
+            }
+
+            haveIndex = true;
+        }
+
+        for(UINT32 r=0; r<runs; r++)
+        {
+            CRC_CACHE llc( sizeKB * 1024, assoc, 1, linesize, policies[p] );
+
+            if( opt )
+            {
+                OPT_INDEX_READER *index = new OPT_INDEX_READER;
+
+                if( !index->Open( indexName.str().c_str() ) )
+                {
+                    cerr<<"Cannot open the OPT index "<<indexName.str()<<endl;
+                    return 1;
+                }
+
+                llc.ReplacementState()->SetNextUseIndex( index );
+            }
+
+            misses = 0;
+
+            double start = Seconds();
+
+            for(COUNTER i=0; i<stream.refs; i++)
+            {
+                misses += !llc.LookupAndFillCache( 0, stream.PC[i], stream.paddr[i], stream.accessType[i] );
+            }
+
+            double elapsed = Seconds() - start;
+
+            if( r == 0 || elapsed < best ) best = elapsed;
+        }
+
+        printf( "%-12s %12llu misses %8.2fM accesses/s\n", LLC_GROUP::PolicyName( policies[p] ),
+                (unsigned long long) misses, refs / best / 1e6 );
+    }
+
+    if( haveIndex )
+    {
+        remove( indexName.str().c_str() );
+    }
+
+    return 0;
+}
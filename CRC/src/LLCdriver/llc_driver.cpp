@@ -0,0 +1,1253 @@
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Open trace-driven driver for the LLCsim replacement code. Reads CMPsim     //
+// binary traces, models the IL1/DL1/MLC hierarchy of the kit and feeds       //
+// the LLC references to CRC_CACHE::LookupAndFillCache. Accepts the           //
+// command line of CMPsim.usetrace for the options it supports:               //
+//                                                                            //
+//   LLCdriver -threads 1 -t ../traces/ls.out.trace.gz -o ls.stats            //
+//             -cache UL3:1024:64:16 -LLCrepl 0 [-icount 100]                 //
+//                                                                            //
+// -cache may be repeated and -LLCrepl takes a comma separated list; every    //
+// combination becomes one LLC instance and all of them are simulated in      //
+// the same pass over the trace:                                              //
+//                                                                            //
+//   LLCdriver -threads 1 -t ../traces/ls.out.trace.gz -cache UL3:1024:64:16  //
+//             -cache UL3:4096:64:16 -LLCrepl 0,1,2                           //
+//                                                                            //
+// -mrc <maxsets>:<maxassoc> adds an LRU stack-distance profile of the LLC    //
+// references with the miss ratio of every power-of-two size and              //
+// associativity up to those limits; -shards <rate> samples that fraction     //
+// of the lines for it.                                                       //
+//                                                                            //
+// Policies 3 (OPT) and 4 (OPT with bypass) first run a pre-scan pass that    //
+// builds the next-use index of the LLC references; -optindex <file> keeps    //
+// it in that file instead of a temporary one.                                //
+//                                                                            //
+// -llcsample <ratio> is a fast estimate: every LLC instance models only 1    //
+// of every <ratio> sets (picked by a hash) and extrapolates its misses to    //
+// all sets, with 95% confidence intervals in the LLC statistics.             //
+//                                                                            //
+// -llcthreads <n> splits the LLC sets over n worker threads (a power of      //
+// two). The results are the same for every n, but can differ slightly from   //
+// a run without workers for policies with state shared by all sets, which    //
+// then changes once per epoch instead of on every miss. Not for OPT.         //
+//                                                                            //
+// -llcdiag adds reuse and dead-block diagnostics to the replacement          //
+// statistics of every LLC: hits per fill, dead fills, eviction ages, the     //
+// recency position of hits, the PCs with the most dead fills and, for the    //
+// set-dueling policies, the flips and the trajectory of PSEL.                //
+//                                                                            //
+// -filter <file> runs the trace through the upper levels once and writes     //
+// the LLC references to an LLC-filtered trace; -llctrace <file> then         //
+// replays it in place of -t, with the same results as a run over the trace:  //
+//                                                                            //
+//   LLCdriver -threads 1 -t ../traces/ls.out.trace.gz -filter ls.llc.gz      //
+//   LLCdriver -threads 1 -llctrace ls.llc.gz -cache UL3:1024:64:16           //
+//             -LLCrepl 0                                                     //
+//                                                                            //
+// -mix <file> runs the traces listed in the file, one path per line, as the  //
+// threads of a multi-programmed mix that share the LLCs, one per core        //
+// (-threads gives their number, up to 8). -mixsched icount|cpi interleaves   //
+// them by instructions or by cycles and -autorewind 1 restarts a trace that  //
+// ends before the others reach -icount. Every trace is also run alone, and   //
+// the stats end with the weighted speedup and fairness of the mix. A trace   //
+// may be listed more than once; every core relocates its addresses:          //
+//                                                                            //
+//   printf '../traces/ls.out.trace.gz\n../traces/ls.out.trace.gz\n' > ls.mix //
+//   LLCdriver -threads 2 -mix ls.mix -icount 1 -autorewind 1                 //
+//             -cache UL3:4096:64:16 -LLCrepl 0,7                             //
+//                                                                            //
+// -prefetch nextline|stride|stream[:<degree>[:<distance>]] puts a hardware   //
+// prefetcher in front of the LLCs that trains on their demand references;    //
+// every LLC then reports the accuracy, coverage and pollution of the         //
+// prefetches. Not for OPT.                                                   //
+//                                                                            //
+// -dram <channels>:<banks>[:<rowbytes>] puts a DRAM model behind every LLC   //
+// instance: its misses and writebacks go to banks with open rows, and the    //
+// cycles and CPIs take the stalls of its reads in place of a fixed memory    //
+// latency. It needs every set and the order of the references, so not with   //
+// -llcsample, -llcthreads, -filter or -llctrace.                             //
+//                                                                            //
+// -inclusion nine|inclusive|exclusive sets the inclusion of the LLC (nine,   //
+// non-inclusive non-exclusive, by default). The private caches then depend   //
+// on the LLC, so inclusive and exclusive runs take one -cache and one        //
+// policy that does not bypass (not OPT or SHIP_BYPASS), and not with         //
+// -llcsample, -llcthreads, -filter or -llctrace.                             //
+//                                                                            //
+// -ooo <rob>[:<width>] adds an out-of-order core model (width 4 by default)  //
+// driven by the dependency file next to every trace, X.dep.gz for            //
+// X.trace.gz, that overlaps independent misses; every thread then reports    //
+// its cycles, IPC and MLP under each LLC instance. It needs the trace and    //
+// the outcome of every blocking miss as it happens, so not with              //
+// -llcsample, -llcthreads, -filter or -llctrace.                             //
+//                                                                            //
+// -depcol <file> converts the dependency file of the trace to columnar       //
+// form, which -ooo then reads in place of it as X.dep.col:                   //
+//                                                                            //
+//   LLCdriver -threads 1 -t ../traces/ls.out.trace.gz                        //
+//             -depcol ../traces/ls.out.dep.col                               //
+//                                                                            //
+// -llcsave <file> writes the state of every LLC instance at the end of the   //
+// run to a warm-cache snapshot, and -llcload <file> starts every instance    //
+// from the snapshot of its geometry and policy, or of its geometry and       //
+// another policy (with its own replacement state cold), so a single warm-up  //
+// run serves many policy runs. Statistics count from the load. Not for OPT,  //
+// -llcthreads or -llcdiag, and -llcload not for -mix.                        //
+//                                                                            //
+//   LLCdriver -threads 1 -t ../traces/ls.out.trace.gz -LLCrepl 0             //
+//             -llcsave ls.snap                                               //
+//   LLCdriver -threads 1 -t ../traces/ls.out.trace.gz -LLCrepl 0,5,7         //
+//             -llcload ls.snap                                               //
+//                                                                            //
+// -interval <n>[:instrs|:refs] -intervalout <file> writes a time series of   //
+// every LLC instance, a row every n instructions (the default) or LLC        //
+// references: its miss rate, MPKI and writebacks in the interval and the     //
+// set duel of CONTESTANT and DRRIP (see interval_sampler.h). CSV if the file //
+// ends in .csv, binary otherwise. Not with -llcthreads, -filter, -llctrace   //
+// or -depcol.                                                                //
+//                                                                            //
+//   LLCdriver -threads 1 -t ../traces/ls.out.trace.gz -LLCrepl 5,7           //
+//             -interval 100000 -intervalout ls.csv                           //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#include <cstdio>
+#include <sstream>
+#include <sys/time.h>
+#include <unistd.h>
+#include <zlib.h>
+#include "utils.h"
+#include "llc_group.h"
+#include "trace_reader.h"
+#include "memory_hierarchy.h"
+#include "llc_filter.h"
+#include "trace_mix.h"
+#include "dep_columns.h"
+
+#define LLC_MIN_SAMPLED_SETS    64
+
+// Options of a driver run
+typedef struct
+{
+    UINT32      threads;
+    const char *traceName;
+    const char *outName;
+    COUNTER     icount;      // instructions per thread, 0 = whole trace
+
+    // LLC geometries and policies; the instances are their cross product
+    UINT32      numCaches;
+    LLC_CONFIG  caches[ LLC_GROUP_MAX ];
+    UINT32      numPolicies;
+    UINT32      policies[ LLC_GROUP_MAX ];
+
+    // stack-distance profile, mrcSets = 0 for none
+    UINT32      mrcSets;
+    UINT32      mrcAssoc;
+    double      shardsRate;
+
+    const char *optIndex;    // next-use index file for OPT, NULL = temporary
+
+    UINT32      sampleRatio; // LLC set sampling, 1 = every set
+    UINT32      llcThreads;  // LLC worker threads, 0 = none
+
+    const char *filterName;  // LLC-filtered trace to write, NULL = simulate
+    const char *llcTraceName;// LLC-filtered trace to replay instead of -t
+    bool        diagnostics; // replacement diagnostics of every LLC
+
+    const char *mixName;     // trace mix to run instead of -t, one trace per thread
+    UINT32      mixSchedule;
+    bool        autorewind;  // restart mix traces that end early
+
+    UINT32      prefetcher;  // PrefetcherTypes in front of every LLC
+    UINT32      pfDegree;    // 0 = the prefetcher's default
+    UINT32      pfDistance;
+
+    UINT32      dramChannels;// DRAM model behind every LLC, 0 = none
+    UINT32      dramBanks;
+    UINT32      dramRowSize;
+
+    UINT32      inclusion;   // LLCInclusion of the LLC
+
+    UINT32      oooRob;      // out-of-order core model, 0 = none
+    UINT32      oooWidth;
+    const char *depColName;  // columnar dependency file to write, NULL = simulate
+
+    const char *snapSave;    // warm-cache snapshot to write at the end, NULL = none
+    const char *snapLoad;    // ... to start from, NULL = cold
+
+    UINT32      intervalUnit;// IntervalUnits of the time series
+    COUNTER     interval;    // 0 = no time series
+    const char *intervalName;
+} DRIVER_CONFIG;
+
+static void Usage( const char *prog )
+{
+    cerr<<"Usage: "<<prog<<" -threads 1 (-t <trace.gz> | -llctrace <llc.gz>) [-icount <millions>] [-o <stats>]"<<endl;
+    cerr<<"       "<<prog<<" -threads <n> -mix <file> [-mixsched icount|cpi] [-autorewind 0|1] ..."<<endl;
+    cerr<<"       [-cache UL3:<KB>:<linesize>:<assoc>]... [-LLCrepl <policy>[,<policy>...]]"<<endl;
+    cerr<<"       [-mrc <maxsets>:<maxassoc>] [-shards <rate>] [-optindex <file>]"<<endl;
+    cerr<<"       [-llcsample <ratio>] [-llcthreads <n>] [-filter <llc.gz>] [-llcdiag]"<<endl;
+    cerr<<"       [-prefetch nextline|stride|stream[:<degree>[:<distance>]]]"<<endl;
+    cerr<<"       [-dram <channels>:<banks>[:<rowbytes>]] [-inclusion nine|inclusive|exclusive]"<<endl;
+    cerr<<"       [-ooo <rob>[:<width>]] [-depcol <file>] [-llcsave <file>] [-llcload <file>]"<<endl;
+    cerr<<"       [-interval <n>[:instrs|:refs] -intervalout <file>]"<<endl;
+}
+
+// Parses the next unsigned field of arg, which must end in sep
+static bool ParseField( const char **arg, char sep, UINT32 *value )
+{
+    char          *end;
+    unsigned long  v = strtoul( *arg, &end, 10 );
+
+    if( end == *arg || *end != sep || v > 0xffffffffUL ) 
+    {
+        return false;
+    }
+
+    *value = v;
+    *arg   = end + 1;
+
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Parses an LLC geometry, UL3:<KB>:<linesize>:<assoc>. The cache tracks the  //
+// ways of a set in a 64-bit mask and indexes its sets with a mask, so the    //
+// line size and the number of sets must be powers of two.                    //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+static bool ParseCache( const char *arg, LLC_CONFIG *cache )
+{
+    if( strncmp( arg, "UL3:", 4 ) != 0 ) 
+    {
+        return false;
+    }
+
+    arg += 4;
+
+    if( !ParseField( &arg, ':', &cache->size ) || !ParseField( &arg, ':', &cache->linesize )
+        || !ParseField( &arg, '\0', &cache->assoc ) ) 
+    {
+        return false;
+    }
+
+    if( cache->assoc == 0 || cache->assoc > 64 || cache->linesize == 0
+        || (cache->linesize & (cache->linesize - 1)) ) 
+    {
+        return false;
+    }
+
+    COUNTER bytes   = (COUNTER) cache->size * 1024;
+    COUNTER setSize = (COUNTER) cache->linesize * cache->assoc;
+    COUNTER numsets = bytes / setSize;
+
+    return bytes % setSize == 0 && numsets && (numsets & (numsets - 1)) == 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Parses the command line. Returns false on any malformed option.            //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+static bool ParseArgs( int argc, char *argv[], DRIVER_CONFIG *cfg )
+{
+    cfg->threads   = 1;
+    cfg->traceName = NULL;
+    cfg->outName   = NULL;
+    cfg->icount    = 0;
+
+    cfg->numCaches   = 0;
+    cfg->numPolicies = 0;
+
+    cfg->mrcSets     = 0;
+    cfg->mrcAssoc    = 0;
+    cfg->shardsRate  = 1.0;
+    cfg->optIndex    = NULL;
+    cfg->sampleRatio = 1;
+    cfg->llcThreads  = 0;
+    cfg->filterName  = NULL;
+    cfg->llcTraceName = NULL;
+    cfg->diagnostics  = false;
+    cfg->mixName      = NULL;
+    cfg->mixSchedule  = MIX_SCHEDULE_ICOUNT;
+    cfg->autorewind   = false;
+    cfg->prefetcher   = PF_NONE;
+    cfg->pfDegree     = 0;
+    cfg->pfDistance   = 0;
+    cfg->dramChannels = 0;
+    cfg->dramBanks    = 0;
+    cfg->dramRowSize  = 8192;
+    cfg->inclusion    = LLC_NINE;
+    cfg->oooRob       = 0;
+    cfg->oooWidth     = 4;
+    cfg->depColName   = NULL;
+    cfg->snapSave     = NULL;
+    cfg->snapLoad     = NULL;
+    cfg->intervalUnit = INTERVAL_INSTRUCTIONS;
+    cfg->interval     = 0;
+    cfg->intervalName = NULL;
+
+    for(int i=1; i<argc; i++) 
+    {
+        string opt  = argv[i];
+        char  *arg  = (i+1 < argc) ? argv[i+1] : NULL;
+
+        // The one option without an argument
+        if( opt == "-llcdiag" ) 
+        {
+            cfg->diagnostics = true;
+            continue;
+        }
+
+        if( arg == NULL ) 
+        {
+            cerr<<"Missing argument for "<<opt<<endl;
+            return false;
+        }
+
+        if( opt == "-threads" )      cfg->threads   = atoi( arg );
+        else if( opt == "-t" )       cfg->traceName = arg;
+        else if( opt == "-o" )       cfg->outName   = arg;
+        else if( opt == "-icount" )  cfg->icount    = strtoull( arg, NULL, 10 ) * 1000000ULL;
+        else if( opt == "-LLCrepl" ) 
+        {
+            char *pol = arg;
+
+            while( true ) 
+            {
+                char          *end;
+                unsigned long  policy = strtoul( pol, &end, 10 );
+
+                if( cfg->numPolicies == LLC_GROUP_MAX ) 
+                {
+                    cerr<<"Too many LLC policies"<<endl;
+                    return false;
+                }
+
+                if( end == pol || (*end != ',' && *end != '\0') || policy > CRC_REPL_UCP
+                    || strcmp( LLC_GROUP::PolicyName( policy ), "UNKNOWN" ) == 0 ) 
+                {
+                    cerr<<"Bad LLC policy list "<<arg<<" (policies 0 to "<<CRC_REPL_UCP<<")"<<endl;
+                    return false;
+                }
+
+                cfg->policies[ cfg->numPolicies++ ] = policy;
+
+                if( *end == '\0' ) break;
+                pol = end + 1;
+            }
+        }
+        else if( opt == "-shards" )  cfg->shardsRate = atof( arg );
+        else if( opt == "-optindex" ) cfg->optIndex = arg;
+        else if( opt == "-llcsample" ) cfg->sampleRatio = atoi( arg );
+        else if( opt == "-llcthreads" ) cfg->llcThreads = atoi( arg );
+        else if( opt == "-filter" ) cfg->filterName = arg;
+        else if( opt == "-depcol" ) cfg->depColName = arg;
+        else if( opt == "-llcsave" ) cfg->snapSave = arg;
+        else if( opt == "-llcload" ) cfg->snapLoad = arg;
+        else if( opt == "-intervalout" ) cfg->intervalName = arg;
+        else if( opt == "-interval" ) 
+        {
+            if( !INTERVAL_SAMPLER::ParseInterval( arg, &cfg->intervalUnit, &cfg->interval ) ) 
+            {
+                cerr<<"Malformed interval "<<arg<<" (<n>[:instrs|:refs])"<<endl;
+                return false;
+            }
+        }
+        else if( opt == "-llctrace" ) cfg->llcTraceName = arg;
+        else if( opt == "-mix" ) cfg->mixName = arg;
+        else if( opt == "-autorewind" ) cfg->autorewind = (atoi( arg ) != 0);
+        else if( opt == "-mixsched" ) 
+        {
+            if( !TRACE_MIX::ParseSchedule( arg, &cfg->mixSchedule ) ) 
+            {
+                cerr<<"Unknown mix schedule "<<arg<<" (icount or cpi)"<<endl;
+                return false;
+            }
+        }
+        else if( opt == "-prefetch" ) 
+        {
+            string type  = arg;
+            size_t colon = type.find( ':' );
+
+            if( !LLC_PREFETCHER::ParseType( type.substr( 0, colon ).c_str(), &cfg->prefetcher ) 
+                || (colon != string::npos 
+                    && sscanf( type.c_str() + colon + 1, "%u:%u", &cfg->pfDegree, &cfg->pfDistance ) < 1)
+                || cfg->pfDegree > PF_MAX_DEGREE || cfg->pfDistance > PF_MAX_DISTANCE ) 
+            {
+                cerr<<"Bad prefetcher "<<arg<<" (nextline, stride or stream, degree up to "<<PF_MAX_DEGREE
+                    <<", distance up to "<<PF_MAX_DISTANCE<<")"<<endl;
+                return false;
+            }
+        }
+        else if( opt == "-dram" ) 
+        {
+            if( sscanf( arg, "%u:%u:%u", &cfg->dramChannels, &cfg->dramBanks, &cfg->dramRowSize ) < 2
+                || !cfg->dramChannels || cfg->dramChannels > DRAM_MAX_CHANNELS
+                || (cfg->dramChannels & (cfg->dramChannels - 1))
+                || !cfg->dramBanks || cfg->dramBanks > DRAM_MAX_BANKS || (cfg->dramBanks & (cfg->dramBanks - 1))
+                || !cfg->dramRowSize || cfg->dramRowSize > DRAM_MAX_ROW_SIZE
+                || (cfg->dramRowSize & (cfg->dramRowSize - 1)) ) 
+            {
+                cerr<<"Bad DRAM configuration "<<arg<<" (powers of two, up to "<<DRAM_MAX_CHANNELS<<" channels, "
+                    <<DRAM_MAX_BANKS<<" banks and "<<DRAM_MAX_ROW_SIZE<<"B rows)"<<endl;
+                return false;
+            }
+        }
+        else if( opt == "-inclusion" ) 
+        {
+            if( !LLC_GROUP::ParseInclusion( arg, &cfg->inclusion ) ) 
+            {
+                cerr<<"Unknown inclusion "<<arg<<" (nine, inclusive or exclusive)"<<endl;
+                return false;
+            }
+        }
+        else if( opt == "-ooo" ) 
+        {
+            if( sscanf( arg, "%u:%u", &cfg->oooRob, &cfg->oooWidth ) < 1
+                || !cfg->oooWidth || cfg->oooWidth > OOO_MAX_WIDTH
+                || cfg->oooRob < cfg->oooWidth || cfg->oooRob > OOO_MAX_ROB ) 
+            {
+                cerr<<"Bad out-of-order core "<<arg<<" (width 1 to "<<OOO_MAX_WIDTH<<", ROB from the width to "
+                    <<OOO_MAX_ROB<<")"<<endl;
+                return false;
+            }
+        }
+        else if( opt == "-mrc" ) 
+        {
+            if( sscanf( arg, "%u:%u", &cfg->mrcSets, &cfg->mrcAssoc ) != 2
+                || !cfg->mrcSets || (cfg->mrcSets & (cfg->mrcSets - 1))
+                || !cfg->mrcAssoc || (cfg->mrcAssoc & (cfg->mrcAssoc - 1)) ) 
+            {
+                cerr<<"Bad profile limits "<<arg<<" (powers of two expected)"<<endl;
+                return false;
+            }
+        }
+        else if( opt == "-cache" ) 
+        {
+            LLC_CONFIG *cache = &cfg->caches[ cfg->numCaches ];
+
+            if( cfg->numCaches == LLC_GROUP_MAX ) 
+            {
+                cerr<<"Too many LLC configurations"<<endl;
+                return false;
+            }
+
+            if( !ParseCache( arg, cache ) ) 
+            {
+                cerr<<"Bad cache configuration "<<arg<<" (UL3:<KB>:<linesize>:<assoc>, 1 to 64 ways, "
+                    <<"a power-of-two line size and number of sets)"<<endl;
+                return false;
+            }
+
+            cfg->numCaches++;
+        }
+        else 
+        {
+            cerr<<"Unknown option "<<opt<<endl;
+            return false;
+        }
+
+        i++;
+    }
+
+    if( (cfg->traceName != NULL) + (cfg->llcTraceName != NULL) + (cfg->mixName != NULL) != 1 ) 
+    {
+        return false;
+    }
+
+    if( cfg->mixName ? (cfg->threads == 0 || cfg->threads > MIX_MAX_THREADS) : cfg->threads != 1 ) 
+    {
+        cerr<<"-threads must be 1 for a trace, 1 to "<<MIX_MAX_THREADS<<" for a trace mix"<<endl;
+        return false;
+    }
+
+    if( cfg->mixName == NULL && (cfg->autorewind || cfg->mixSchedule != MIX_SCHEDULE_ICOUNT) ) 
+    {
+        cerr<<"-autorewind and -mixsched apply to -mix"<<endl;
+        return false;
+    }
+
+    if( cfg->filterName && cfg->traceName == NULL ) 
+    {
+        cerr<<"-filter needs a trace (-t)"<<endl;
+        return false;
+    }
+
+    if( cfg->depColName && (cfg->traceName == NULL || cfg->filterName) ) 
+    {
+        cerr<<"-depcol needs a trace (-t) and no -filter"<<endl;
+        return false;
+    }
+
+    // The filter pass already stopped at its instruction limit
+    if( cfg->llcTraceName && cfg->icount ) 
+    {
+        cerr<<"-icount applies when filtering, not to -llctrace"<<endl;
+        return false;
+    }
+
+    if( cfg->shardsRate <= 0.0 || cfg->shardsRate > 1.0 ) 
+    {
+        cerr<<"Sample rate must be in (0, 1]"<<endl;
+        return false;
+    }
+
+    if( cfg->numCaches == 0 ) 
+    {
+        cfg->caches[0].size     = 1024;
+        cfg->caches[0].linesize = 64;
+        cfg->caches[0].assoc    = 16;
+        cfg->numCaches = 1;
+    }
+
+    if( cfg->numPolicies == 0 ) 
+    {
+        cfg->policies[0] = CRC_REPL_LRU;
+        cfg->numPolicies = 1;
+    }
+
+    if( cfg->numCaches * cfg->numPolicies > LLC_GROUP_MAX ) 
+    {
+        cerr<<"At most "<<LLC_GROUP_MAX<<" LLC instances are supported"<<endl;
+        return false;
+    }
+
+    // The upper levels share the LLC line size
+    for(UINT32 c=1; c<cfg->numCaches; c++) 
+    {
+        if( cfg->caches[c].linesize != cfg->caches[0].linesize ) 
+        {
+            cerr<<"All LLC configurations must use the same line size"<<endl;
+            return false;
+        }
+    }
+
+    if( !cfg->sampleRatio || (cfg->sampleRatio & (cfg->sampleRatio - 1)) ) 
+    {
+        cerr<<"Set sampling ratio must be a power of two"<<endl;
+        return false;
+    }
+
+    for(UINT32 c=0; c<cfg->numCaches; c++) 
+    {
+        LLC_CONFIG *cache = &cfg->caches[c];
+        UINT32      sets  = cache->size * 1024 / (cache->linesize * cache->assoc);
+
+        if( cfg->sampleRatio > sets ) 
+        {
+            cerr<<"Set sampling ratio exceeds the sets of "<<cache->size<<"KB"<<endl;
+            return false;
+        }
+
+        // A handful of sets leaves the estimate at the mercy of a few hot sets
+        if( cfg->sampleRatio > 1 && sets / cfg->sampleRatio < LLC_MIN_SAMPLED_SETS ) 
+        {
+            cerr<<"Warning: only "<<sets / cfg->sampleRatio<<" sets of "<<cache->size
+                <<"KB are sampled, the estimate may be unreliable"<<endl;
+        }
+
+        cache->sampleRatio = cfg->sampleRatio;
+        cache->diagnostics = cfg->diagnostics;
+        cache->prefetcher  = cfg->prefetcher;
+        cache->pfDegree    = cfg->pfDegree;
+        cache->pfDistance  = cfg->pfDistance;
+
+        cache->dramChannels = cfg->dramChannels;
+        cache->dramBanks    = cfg->dramBanks;
+        cache->dramRowSize  = cfg->dramRowSize;
+        cache->inclusion    = cfg->inclusion;
+
+        if( cfg->dramChannels && cfg->dramRowSize < cache->linesize ) 
+        {
+            cerr<<"DRAM rows are smaller than the "<<cache->linesize<<"B lines"<<endl;
+            return false;
+        }
+
+        // Every set must belong to one worker
+        if( cfg->llcThreads > sets ) 
+        {
+            cerr<<"More LLC worker threads than sets of "<<cache->size<<"KB"<<endl;
+            return false;
+        }
+    }
+
+    if( cfg->llcThreads > LLC_WORKERS_MAX || (cfg->llcThreads & (cfg->llcThreads - 1)) ) 
+    {
+        cerr<<"LLC worker threads must be a power of two up to "<<LLC_WORKERS_MAX<<endl;
+        return false;
+    }
+
+    // The DRAM models see the references of every set in trace order, with
+    // the cycle count of the core that sends them
+    if( cfg->dramChannels 
+        && (cfg->sampleRatio > 1 || cfg->llcThreads || cfg->filterName || cfg->llcTraceName) ) 
+    {
+        cerr<<"-dram does not apply to -llcsample, -llcthreads, -filter or -llctrace"<<endl;
+        return false;
+    }
+
+    // The out-of-order models take the latency of every blocking access under
+    // every instance when it is made, and follow the trace's instructions
+    if( cfg->oooRob 
+        && (cfg->sampleRatio > 1 || cfg->llcThreads || cfg->filterName || cfg->llcTraceName) ) 
+    {
+        cerr<<"-ooo does not apply to -llcsample, -llcthreads, -filter or -llctrace"<<endl;
+        return false;
+    }
+
+    // A snapshot holds the state of the instances alone: not of the copies of
+    // the workers, of the diagnostics or of an OPT index stream, nor of the
+    // caches that a mix runs its traces alone on
+    if( cfg->snapSave || cfg->snapLoad ) 
+    {
+        if( cfg->llcThreads || cfg->diagnostics || cfg->filterName || cfg->depColName ) 
+        {
+            cerr<<"-llcsave and -llcload do not apply to -llcthreads, -llcdiag, -filter or -depcol"<<endl;
+            return false;
+        }
+
+        if( cfg->snapLoad && cfg->mixName ) 
+        {
+            cerr<<"-llcload does not apply to -mix"<<endl;
+            return false;
+        }
+
+        for(UINT32 p=0; p<cfg->numPolicies; p++) 
+        {
+            if( cfg->policies[p] == CRC_REPL_OPT || cfg->policies[p] == CRC_REPL_OPT_BYPASS ) 
+            {
+                cerr<<"OPT policies cannot be saved to or loaded from a snapshot"<<endl;
+                return false;
+            }
+        }
+    }
+
+    // The sampler reads the statistics of the instances as the hierarchy
+    // runs, which the workers update behind it, and counts the instructions
+    // that a replayed trace does not have
+    if( (cfg->interval != 0) != (cfg->intervalName != NULL) ) 
+    {
+        cerr<<"-interval and -intervalout go together"<<endl;
+        return false;
+    }
+
+    if( cfg->interval && (cfg->llcThreads || cfg->filterName || cfg->llcTraceName || cfg->depColName) ) 
+    {
+        cerr<<"-interval does not apply to -llcthreads, -filter, -llctrace or -depcol"<<endl;
+        return false;
+    }
+
+    // The private caches follow the contents of an inclusive or exclusive
+    // LLC, which must hold every line it keeps, in every set
+    if( cfg->inclusion != LLC_NINE ) 
+    {
+        if( cfg->numCaches * cfg->numPolicies != 1 ) 
+        {
+            cerr<<"-inclusion "<<LLC_GROUP::InclusionName( cfg->inclusion )<<" takes a single LLC instance"<<endl;
+            return false;
+        }
+
+        if( cfg->sampleRatio > 1 || cfg->llcThreads || cfg->filterName || cfg->llcTraceName ) 
+        {
+            cerr<<"-inclusion "<<LLC_GROUP::InclusionName( cfg->inclusion )
+                <<" does not apply to -llcsample, -llcthreads, -filter or -llctrace"<<endl;
+            return false;
+        }
+
+        if( cfg->policies[0] == CRC_REPL_OPT || cfg->policies[0] == CRC_REPL_OPT_BYPASS 
+            || cfg->policies[0] == CRC_REPL_SHIP_BYPASS ) 
+        {
+            cerr<<"-inclusion "<<LLC_GROUP::InclusionName( cfg->inclusion )<<" cannot run "
+                <<LLC_GROUP::PolicyName( cfg->policies[0] )<<endl;
+            return false;
+        }
+    }
+
+    // OPT follows the next-use index in the order of all references
+    for(UINT32 p=0; p<cfg->numPolicies && cfg->llcThreads; p++) 
+    {
+        if( cfg->policies[p] == CRC_REPL_OPT || cfg->policies[p] == CRC_REPL_OPT_BYPASS ) 
+        {
+            cerr<<"OPT policies cannot run on LLC worker threads"<<endl;
+            return false;
+        }
+    }
+
+    // The prefetches are not part of the recorded reference stream
+    for(UINT32 p=0; p<cfg->numPolicies && cfg->prefetcher != PF_NONE; p++) 
+    {
+        if( cfg->policies[p] == CRC_REPL_OPT || cfg->policies[p] == CRC_REPL_OPT_BYPASS ) 
+        {
+            cerr<<"OPT policies cannot run with a prefetcher"<<endl;
+            return false;
+        }
+    }
+
+    // A mix takes each core's cycles, and schedules by them, while it runs,
+    // and its single-thread runs would each need an OPT index of their own
+    if( cfg->mixName ) 
+    {
+        if( cfg->filterName || cfg->llcThreads ) 
+        {
+            cerr<<"-filter and -llcthreads do not apply to -mix"<<endl;
+            return false;
+        }
+
+        for(UINT32 p=0; p<cfg->numPolicies; p++) 
+        {
+            if( cfg->policies[p] == CRC_REPL_OPT || cfg->policies[p] == CRC_REPL_OPT_BYPASS ) 
+            {
+                cerr<<"OPT policies cannot run on a trace mix"<<endl;
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Streams one trace through the hierarchy until it ends or the               //
+// instruction limit is reached. Returns false if the trace fails to read.    //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+static bool RunTrace( TRACE_READER *reader, MEMORY_HIERARCHY *hier, UINT32 tid, COUNTER icount )
+{
+    TRACE_RECORD rec;
+
+    while( reader->Next( &rec ) ) 
+    {
+        hier->Retire( tid, rec.icount );
+
+        switch( rec.accessType ) 
+        {
+          case ACCESS_IFETCH:
+            hier->Fetch( tid, rec.addr );
+            break;
+
+          case ACCESS_LOAD:
+          case ACCESS_STORE:
+            hier->DataAccess( tid, rec.PC, rec.addr, rec.accessType );
+            break;
+
+          default:
+            break;
+        }
+
+        if( icount && hier->Instructions( tid ) >= icount ) 
+        {
+            break;
+        }
+    }
+
+    return !reader->Failed();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Replays the references of an LLC-filtered trace to the LLCs.               //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+static void ReplayLLCTrace( LLC_FILTER_READER *reader, MEMORY_HIERARCHY *hier )
+{
+    LLC_REF ref;
+
+    while( reader->Next( &ref ) ) 
+    {
+        hier->ReplayLLC( &ref );
+    }
+}
+
+// The input of a run: a trace, an LLC-filtered trace if llcReader is set
+// or a trace mix if mix is
+typedef struct
+{
+    TRACE_READER      *reader;
+    LLC_FILTER_READER *llcReader;
+    TRACE_MIX         *mix;
+} DRIVER_INPUT;
+
+// False if a trace of the input fails to read
+static bool RunInput( DRIVER_INPUT *input, MEMORY_HIERARCHY *hier, COUNTER icount )
+{
+    if( input->llcReader ) 
+    {
+        ReplayLLCTrace( input->llcReader, hier );
+        return true;
+    }
+
+    if( input->mix ) 
+    {
+        return input->mix->Run( hier, icount );
+    }
+
+    return RunTrace( input->reader, hier, 0, icount );
+}
+
+static bool RewindInput( DRIVER_INPUT *input )
+{
+    return input->llcReader ? input->llcReader->Rewind() : input->reader->Rewind();
+}
+
+static double Seconds()
+{
+    struct timeval tv;
+    gettimeofday( &tv, NULL );
+    return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Filter pass: streams the trace through the upper levels alone and writes   //
+// their LLC references and statistics to the LLC-filtered trace. If the      //
+// trace fails to read, the filtered trace is left without its statistics,    //
+// which a replay rejects as truncated.                                       //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+static bool FilterTrace( TRACE_READER *reader, const DRIVER_CONFIG *cfg, COUNTER *references )
+{
+    MEMORY_HIERARCHY   filter( cfg->threads, NULL, cfg->caches[0].linesize );
+    LLC_FILTER_WRITER  writer;
+    LLC_FILTER_SUMMARY summary;
+
+    if( !writer.Open( cfg->filterName, reader->Name(), cfg->caches[0].linesize, cfg->threads ) ) 
+    {
+        cerr<<"Cannot write the LLC-filtered trace "<<cfg->filterName<<endl;
+        return false;
+    }
+
+    filter.SetFilter( &writer );
+
+    if( !RunTrace( reader, &filter, 0, cfg->icount ) ) 
+    {
+        return false;
+    }
+
+    filter.Summarize( &summary );
+    *references = writer.References();
+
+    if( !writer.Finish( &summary ) ) 
+    {
+        cerr<<"Cannot write the LLC-filtered trace "<<cfg->filterName<<endl;
+        return false;
+    }
+
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Converts the dependency file of the trace, X.dep.gz for X.trace.gz, to     //
+// columnar form, then reads the whole trace to check that the two count      //
+// the same instructions, which the blocks of the columns follow.             //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+static bool ConvertDependencies( TRACE_READER *reader, const char *colName )
+{
+    DEP_READER        dep;
+    DEP_COLUMN_WRITER writer;
+    DEP_RECORD        rec;
+    TRACE_RECORD      traceRec;
+    string            depName;
+    double            start = Seconds();
+
+    if( !DEP_READER::DepName( reader->Name(), DEP_TEXT_SUFFIX, &depName ) || !dep.Open( depName.c_str() ) ) 
+    {
+        cerr<<"Cannot open the dependency file of "<<reader->Name()<<" (X"<<DEP_TEXT_SUFFIX<<" for X.trace.gz)"<<endl;
+        return false;
+    }
+
+    if( !writer.Open( colName ) ) 
+    {
+        cerr<<"Cannot create the columnar dependency file "<<colName<<endl;
+        return false;
+    }
+
+    while( dep.Next( &rec ) ) 
+    {
+        writer.Add( &rec );
+    }
+
+    if( !writer.Finish() ) 
+    {
+        cerr<<"Cannot write the columnar dependency file "<<colName<<endl;
+        return false;
+    }
+
+    while( reader->Next( &traceRec ) );
+
+    if( reader->Failed() ) 
+    {
+        return false;
+    }
+
+    if( reader->Instructions() != writer.Instructions() ) 
+    {
+        cerr<<"Warning: "<<depName<<" has "<<writer.Instructions()<<" instructions, "<<reader->Name()<<" "
+            <<reader->Instructions()<<endl;
+    }
+
+    cerr<<"Converted "<<writer.Instructions()<<" instructions of "<<depName<<" to "<<colName<<" in "
+        <<(Seconds() - start)<<"s"<<endl;
+
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Pre-scan pass for OPT: streams the input through the upper levels alone,   //
+// records the LLC references and builds their next-use index in              //
+// indexName. The LLC reference stream does not depend on the LLC, so the     //
+// simulation pass sees exactly the recorded references. Leaves the input     //
+// rewound.                                                                   //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+static bool BuildOptIndex( DRIVER_INPUT *input, const DRIVER_CONFIG *cfg, const char *indexName )
+{
+    MEMORY_HIERARCHY  prescan( cfg->threads, NULL, cfg->caches[0].linesize );
+    OPT_INDEX_WRITER *writer = new OPT_INDEX_WRITER;
+    bool              ok     = writer->Open( indexName );
+
+    if( ok ) 
+    {
+        prescan.SetRecorder( writer );
+
+        if( RunInput( input, &prescan, cfg->icount ) ) 
+        {
+            ok = writer->Finish() && RewindInput( input );
+        }
+        else 
+        {
+            writer->Abort();
+            ok = false;
+        }
+    }
+
+    delete writer;
+
+    return ok;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Writes the stats, gzip'ed to <name>.gz like CMPsim, or to stdout.          //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+static bool WriteStats( const char *outName, const string &stats )
+{
+    if( outName == NULL ) 
+    {
+        cout<<stats;
+        return true;
+    }
+
+    string gzName = string( outName ) + ".gz";
+    gzFile out    = gzopen( gzName.c_str(), "wb" );
+
+    if( out == NULL ) 
+    {
+        return false;
+    }
+
+    gzwrite( out, stats.data(), stats.size() );
+    gzclose( out );
+
+    return true;
+}
+
+int main( int argc, char *argv[] )
+{
+    DRIVER_CONFIG cfg;
+
+    if( !ParseArgs( argc, argv, &cfg ) ) 
+    {
+        Usage( argv[0] );
+        return 1;
+    }
+
+    TRACE_READER      reader;
+    LLC_FILTER_READER llcReader;
+    TRACE_MIX         mix( cfg.mixSchedule, cfg.autorewind );
+    DRIVER_INPUT      input = { &reader, NULL, NULL };
+
+    if( cfg.llcTraceName ) 
+    {
+        if( !llcReader.Open( cfg.llcTraceName ) ) 
+        {
+            cerr<<"Cannot open LLC-filtered trace "<<cfg.llcTraceName<<endl;
+            return 1;
+        }
+
+        // The upper levels were simulated with the LLC line size
+        if( llcReader.LineSize() != cfg.caches[0].linesize || llcReader.Threads() != cfg.threads ) 
+        {
+            cerr<<cfg.llcTraceName<<" was filtered for "<<llcReader.Threads()<<" threads and "
+                <<llcReader.LineSize()<<"B lines"<<endl;
+            return 1;
+        }
+
+        input.llcReader = &llcReader;
+    }
+    else if( cfg.mixName ) 
+    {
+        if( !mix.Open( cfg.mixName ) ) 
+        {
+            return 1;
+        }
+
+        if( mix.NumCores() != cfg.threads ) 
+        {
+            cerr<<cfg.mixName<<" lists "<<mix.NumCores()<<" traces for "<<cfg.threads<<" threads"<<endl;
+            return 1;
+        }
+
+        input.mix = &mix;
+    }
+    else if( !reader.Open( cfg.traceName ) ) 
+    {
+        cerr<<"Cannot open trace "<<cfg.traceName<<endl;
+        return 1;
+    }
+
+    if( cfg.filterName ) 
+    {
+        COUNTER references;
+        double  start = Seconds();
+
+        if( !FilterTrace( &reader, &cfg, &references ) ) 
+        {
+            return 1;
+        }
+
+        cerr<<"Filtered "<<reader.Instructions()<<" instructions ("<<reader.Records()<<" trace records) to "
+            <<references<<" LLC references in "<<(Seconds() - start)<<"s"<<endl;
+
+        return 0;
+    }
+
+    if( cfg.depColName ) 
+    {
+        return ConvertDependencies( &reader, cfg.depColName ) ? 0 : 1;
+    }
+
+    // Instances of the same geometry are adjacent
+    LLC_CONFIG llcConfigs[ LLC_GROUP_MAX ];
+    UINT32     numLLCs = 0;
+
+    for(UINT32 c=0; c<cfg.numCaches; c++) 
+    {
+        for(UINT32 p=0; p<cfg.numPolicies; p++) 
+        {
+            llcConfigs[ numLLCs ]            = cfg.caches[c];
+            llcConfigs[ numLLCs ].replPolicy = cfg.policies[p];
+            numLLCs++;
+        }
+    }
+
+    LLC_GROUP        *llcs = new LLC_GROUP( cfg.threads, numLLCs, llcConfigs, cfg.llcThreads );
+    MEMORY_HIERARCHY  hier( cfg.threads, llcs, cfg.caches[0].linesize );
+
+    bool needsOpt = false;
+
+    for(UINT32 p=0; p<cfg.numPolicies; p++) 
+    {
+        needsOpt |= (cfg.policies[p] == CRC_REPL_OPT || cfg.policies[p] == CRC_REPL_OPT_BYPASS);
+    }
+
+    if( needsOpt ) 
+    {
+        ostringstream tmpName;
+        tmpName<<P_tmpdir<<"/LLCdriver."<<getpid()<<".opt";
+
+        string indexName = cfg.optIndex ? cfg.optIndex : tmpName.str();
+        double start     = Seconds();
+
+        if( !BuildOptIndex( &input, &cfg, indexName.c_str() ) ) 
+        {
+            cerr<<"Cannot build the OPT index "<<indexName<<endl;
+            return 1;
+        }
+
+        // Every OPT instance streams its own copy of the index
+        for(UINT32 i=0; i<numLLCs; i++) 
+        {
+            if( llcConfigs[i].replPolicy != CRC_REPL_OPT && llcConfigs[i].replPolicy != CRC_REPL_OPT_BYPASS ) continue;
+
+            OPT_INDEX_READER *index = new OPT_INDEX_READER;
+
+            if( !index->Open( indexName.c_str() ) ) 
+            {
+                cerr<<"Cannot open the OPT index "<<indexName<<endl;
+                return 1;
+            }
+
+            llcs->LLC(i)->ReplacementState()->SetNextUseIndex( index );
+        }
+
+        // The open readers keep a temporary index alive
+        if( cfg.optIndex == NULL ) 
+        {
+            remove( indexName.c_str() );
+        }
+
+        cerr<<"Built the OPT index in "<<(Seconds() - start)<<"s"<<endl;
+    }
+
+    if( cfg.snapLoad ) 
+    {
+        double start = Seconds();
+
+        if( !llcs->LoadSnapshot( cfg.snapLoad ) ) 
+        {
+            cerr<<"Cannot load the cache snapshot "<<cfg.snapLoad<<endl;
+            return 1;
+        }
+
+        cerr<<"Loaded the cache snapshot "<<cfg.snapLoad<<" in "<<(Seconds() - start)<<"s"<<endl;
+    }
+
+    // Every thread's model reads the dependency file of its trace, the
+    // columnar one if there is one
+    for(UINT32 c=0; c<cfg.threads && cfg.oooRob; c++) 
+    {
+        string    traceName = cfg.mixName ? mix.TraceName(c) : string( cfg.traceName );
+        string    depName;
+        OOO_CORE *ooo = new OOO_CORE( numLLCs, cfg.oooRob, cfg.oooWidth );
+
+        if( !DEP_READER::DepName( traceName, DEP_COLUMN_SUFFIX, &depName ) || access( depName.c_str(), R_OK ) != 0 ) 
+        {
+            DEP_READER::DepName( traceName, DEP_TEXT_SUFFIX, &depName );
+        }
+
+        if( depName.empty() || !ooo->Open( depName.c_str() ) ) 
+        {
+            cerr<<"Cannot open the dependency file of "<<traceName<<" (X"<<DEP_COLUMN_SUFFIX<<" or X"
+                <<DEP_TEXT_SUFFIX<<" for X.trace.gz)"<<endl;
+            return 1;
+        }
+
+        hier.SetTiming( c, ooo );
+    }
+
+    if( cfg.mrcSets ) 
+    {
+        hier.SetProfiler( new STACK_PROFILER( cfg.caches[0].linesize, cfg.mrcSets, cfg.mrcAssoc, cfg.shardsRate ) );
+    }
+
+    INTERVAL_SAMPLER *sampler = NULL;
+
+    if( cfg.interval ) 
+    {
+        sampler = new INTERVAL_SAMPLER( llcs, cfg.threads, cfg.intervalUnit, cfg.interval );
+
+        if( !sampler->Open( cfg.intervalName ) ) 
+        {
+            cerr<<"Cannot write the interval time series "<<cfg.intervalName<<endl;
+            return 1;
+        }
+
+        hier.SetSampler( sampler );
+    }
+
+    double start = Seconds();
+
+    // The trace already said what went wrong
+    if( !RunInput( &input, &hier, cfg.icount ) ) 
+    {
+        return 1;
+    }
+
+    if( !hier.Finish() ) 
+    {
+        cerr<<"Cannot write the interval time series "<<cfg.intervalName<<endl;
+        return 1;
+    }
+
+    llcs->Finish();
+
+    double elapsed = Seconds() - start;
+
+    if( cfg.snapSave && !llcs->SaveSnapshot( cfg.snapSave ) ) 
+    {
+        cerr<<"Cannot write the cache snapshot "<<cfg.snapSave<<endl;
+        return 1;
+    }
+
+    double aloneStart = Seconds();
+
+    if( cfg.mixName && !mix.RunAlone( llcConfigs, numLLCs ) ) 
+    {
+        return 1;
+    }
+
+    double aloneElapsed = Seconds() - aloneStart;
+
+    if( cfg.llcTraceName ) 
+    {
+        if( llcReader.Summary() == NULL ) 
+        {
+            cerr<<"LLC-filtered trace "<<cfg.llcTraceName<<" is truncated"<<endl;
+            return 1;
+        }
+
+        hier.SetUpperLevels( llcReader.Summary() );
+    }
+
+    ostringstream stats;
+
+    if( cfg.mixName ) 
+    {
+        for(UINT32 c=0; c<mix.NumCores(); c++) 
+        {
+            stats<<"Opened Binary Trace File: "<<mix.TraceName(c)<<endl;
+        }
+    }
+    else 
+    {
+        stats<<"Opened Binary Trace File: "<<(cfg.llcTraceName ? llcReader.TraceName().c_str() : cfg.traceName)<<endl;
+    }
+
+    hier.PrintStats( stats );
+
+    if( cfg.mixName ) 
+    {
+        mix.PrintSummary( stats, llcs );
+    }
+
+    if( !WriteStats( cfg.outName, stats.str() ) ) 
+    {
+        cerr<<"Cannot write stats to "<<cfg.outName<<endl;
+        return 1;
+    }
+
+    if( cfg.llcTraceName ) 
+    {
+        cerr<<"Replayed "<<llcReader.References()<<" LLC references in "<<elapsed<<"s, "
+            <<(llcReader.References() / elapsed / 1e6)<<"M references/s"<<endl;
+    }
+    else if( cfg.mixName ) 
+    {
+        COUNTER instructions = 0;
+
+        for(UINT32 c=0; c<cfg.threads; c++) 
+        {
+            instructions += hier.Instructions(c);
+        }
+
+        cerr<<"Simulated "<<instructions<<" instructions ("<<mix.Records()<<" trace records) of "<<cfg.threads
+            <<" threads in "<<elapsed<<"s, "<<(mix.Records() / elapsed / 1e6)<<"M records/s; ran them alone in "
+            <<aloneElapsed<<"s"<<endl;
+    }
+    else 
+    {
+        cerr<<"Simulated "<<reader.Instructions()<<" instructions ("<<reader.Records()<<" trace records) in "
+            <<elapsed<<"s, "<<(reader.Records() / elapsed / 1e6)<<"M records/s"<<endl;
+    }
+
+    return 0;
+}
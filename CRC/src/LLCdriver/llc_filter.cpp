@@ -0,0 +1,300 @@
+#include "llc_filter.h"
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// LLC-filtered traces (see llc_filter.h for the format).                     //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+LLC_FILTER_WRITER::LLC_FILTER_WRITER()
+{
+    file       = NULL;
+    buf        = new unsigned char [ LLC_FILTER_BUFFER_SIZE ];
+    bufLen     = 0;
+    ok         = false;
+    lastAddr   = 0;
+    lastPC     = 0;
+    references = 0;
+}
+
+LLC_FILTER_WRITER::~LLC_FILTER_WRITER()
+{
+    if( file != NULL ) 
+    {
+        gzclose( file );
+    }
+
+    delete [] buf;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Creates the filtered trace and writes its header.                          //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+bool LLC_FILTER_WRITER::Open( const char *name, const string &traceName, UINT32 linesize, UINT32 threads )
+{
+    assert( threads <= LLC_FILTER_MAX_THREADS );
+
+    file = gzopen( name, "wb" );
+
+    if( file == NULL ) 
+    {
+        return false;
+    }
+
+    ok = true;
+
+    memcpy( buf, LLC_FILTER_MAGIC, strlen( LLC_FILTER_MAGIC ) );
+    bufLen = strlen( LLC_FILTER_MAGIC );
+
+    PutVarint( linesize );
+    PutVarint( threads );
+    PutString( traceName );
+
+    return ok;
+}
+
+void LLC_FILTER_WRITER::Flush()
+{
+    if( bufLen && gzwrite( file, buf, bufLen ) != (int) bufLen ) 
+    {
+        ok = false;
+    }
+
+    bufLen = 0;
+}
+
+void LLC_FILTER_WRITER::PutString( const string &s )
+{
+    PutVarint( s.size() );
+    Flush();
+
+    if( s.size() && gzwrite( file, s.data(), s.size() ) != (int) s.size() ) 
+    {
+        ok = false;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Ends the references with the trailer and closes the file. Returns false    //
+// if anything could not be written.                                          //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+bool LLC_FILTER_WRITER::Finish( const LLC_FILTER_SUMMARY *summary )
+{
+    Flush();
+
+    buf[ bufLen++ ] = LLC_FILTER_END;
+
+    PutVarint( summary->threads );
+
+    for(UINT32 t=0; t<summary->threads; t++) 
+    {
+        PutVarint( summary->instructions[t] );
+        PutVarint( summary->cycles[t] );
+    }
+
+    PutString( summary->upperStats );
+    Flush();
+
+    if( gzclose( file ) != Z_OK ) 
+    {
+        ok = false;
+    }
+
+    file = NULL;
+
+    return ok;
+}
+
+LLC_FILTER_READER::LLC_FILTER_READER()
+{
+    file        = NULL;
+    buf         = new unsigned char [ LLC_FILTER_BUFFER_SIZE ];
+    bufPos      = 0;
+    bufLen      = 0;
+    fileDone    = true;
+    lastAddr    = 0;
+    lastPC      = 0;
+    references  = 0;
+    linesize    = 0;
+    threads     = 0;
+    haveSummary = false;
+}
+
+LLC_FILTER_READER::~LLC_FILTER_READER()
+{
+    Close();
+    delete [] buf;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Opens a filtered trace and reads its header. Returns false if the file     //
+// could not be opened or is not a filtered trace.                            //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+bool LLC_FILTER_READER::Open( const char *name )
+{
+    Close();
+
+    filename = name;
+    file     = gzopen( name, "rb" );
+
+    if( file == NULL ) 
+    {
+        return false;
+    }
+
+    gzbuffer( file, LLC_FILTER_BUFFER_SIZE );
+
+    fileDone    = false;
+    lastAddr    = 0;
+    lastPC      = 0;
+    references  = 0;
+    haveSummary = false;
+
+    Refill();
+
+    UINT32 magicLen = strlen( LLC_FILTER_MAGIC );
+    Addr_t lineValue, threadValue;
+
+    if( bufLen < magicLen || memcmp( buf, LLC_FILTER_MAGIC, magicLen ) != 0 ) 
+    {
+        return false;
+    }
+
+    bufPos = magicLen;
+
+    if( !GetNumber( &lineValue ) || !GetNumber( &threadValue ) || !GetString( &traceName )
+        || threadValue == 0 || threadValue > LLC_FILTER_MAX_THREADS ) 
+    {
+        return false;
+    }
+
+    linesize = lineValue;
+    threads  = threadValue;
+
+    return true;
+}
+
+bool LLC_FILTER_READER::Rewind()
+{
+    string name = filename;
+
+    return Open( name.c_str() );
+}
+
+void LLC_FILTER_READER::Close()
+{
+    if( file != NULL ) 
+    {
+        gzclose( file );
+        file = NULL;
+    }
+
+    fileDone = true;
+    bufPos   = 0;
+    bufLen   = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Moves the undecoded tail of the buffer to the front and fills the rest     //
+// from the decompressor.                                                     //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+void LLC_FILTER_READER::Refill()
+{
+    UINT32 left = bufLen - bufPos;
+
+    memmove( buf, &buf[ bufPos ], left );
+    bufPos = 0;
+    bufLen = left;
+
+    while( !fileDone && bufLen < LLC_FILTER_BUFFER_SIZE ) 
+    {
+        int got = gzread( file, &buf[ bufLen ], LLC_FILTER_BUFFER_SIZE - bufLen );
+
+        if( got <= 0 ) 
+        {
+            fileDone = true;
+            break;
+        }
+
+        bufLen += got;
+    }
+}
+
+// A varint of the header or trailer, which may straddle a refill
+bool LLC_FILTER_READER::GetNumber( Addr_t *v )
+{
+    if( bufLen - bufPos < LLC_FILTER_MAX_RECORD && !fileDone ) 
+    {
+        Refill();
+    }
+
+    return GetVarint( v );
+}
+
+bool LLC_FILTER_READER::GetString( string *s )
+{
+    Addr_t len;
+
+    if( !GetNumber( &len ) ) 
+    {
+        return false;
+    }
+
+    s->clear();
+
+    while( s->size() < len ) 
+    {
+        if( bufPos == bufLen ) 
+        {
+            if( fileDone ) return false;
+
+            Refill();
+            continue;
+        }
+
+        UINT32 n = bufLen - bufPos;
+
+        if( n > len - s->size() ) n = len - s->size();
+
+        s->append( (const char *) &buf[ bufPos ], n );
+        bufPos += n;
+    }
+
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Reads the trailer that follows the end marker.                             //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+void LLC_FILTER_READER::ReadSummary()
+{
+    Addr_t value;
+
+    if( !GetNumber( &value ) || value == 0 || value > LLC_FILTER_MAX_THREADS ) 
+    {
+        return;
+    }
+
+    summary.threads = value;
+
+    for(UINT32 t=0; t<summary.threads; t++) 
+    {
+        if( !GetNumber( &summary.instructions[t] ) || !GetNumber( &summary.cycles[t] ) ) 
+        {
+            return;
+        }
+    }
+
+    haveSummary = GetString( &summary.upperStats );
+}
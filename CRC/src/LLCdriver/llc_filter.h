@@ -0,0 +1,261 @@
+#ifndef LLC_FILTER_H
+#define LLC_FILTER_H
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// LLC-filtered traces. The upper levels of the driver do not depend on the   //
+// LLC, so one pass of a trace through the IL1/DL1/MLC hierarchy can record   //
+// every reference it sends to the LLC, in order, and LLC experiments can     //
+// replay that much shorter stream instead of the trace. Along with the       //
+// references the filter keeps what a run reports about the levels above      //
+// the LLC (instructions and cycles per core, the IL1/DL1/MLC statistics),    //
+// so a replay prints the same statistics as a run over the trace.            //
+//                                                                            //
+// A filtered trace is a gzip'ed byte stream:                                 //
+//                                                                            //
+//     header   "LLCFILT1", linesize, threads, trace name                     //
+//     records  [flags:1] [address delta] [PC delta]                          //
+//     trailer  [0xff] per core instructions and cycles, upper-level stats    //
+//                                                                            //
+// Bits 0-2 of the flags hold the access type, bits 3-5 the thread and bit    //
+// 6 says that a PC delta follows. The address delta is to the previous       //
+// record and the PC delta to the previous explicit PC. Without a PC delta    //
+// the PC is the address for instruction fetches, 0 for writebacks and the    //
+// previous explicit PC otherwise. Deltas are zigzag encoded varints (7       //
+// bits per byte, low bits first), as are the numbers in the header and the   //
+// trailer; strings are a varint length and the bytes.                        //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#include <zlib.h>
+#include <cassert>
+#include <cstring>
+#include "utils.h"
+#include "crc_cache_defs.h"
+#include "llc_group.h"
+
+#define LLC_FILTER_MAGIC        "LLCFILT1"
+#define LLC_FILTER_BUFFER_SIZE  (1 << 20)
+#define LLC_FILTER_MAX_RECORD   21          // flags and two 10-byte varints
+#define LLC_FILTER_END          0xff
+#define LLC_FILTER_HAS_PC       0x40
+#define LLC_FILTER_MAX_THREADS  8
+
+// What the filter pass reports about the levels above the LLC
+typedef struct
+{
+    UINT32  threads;
+    COUNTER instructions[ LLC_FILTER_MAX_THREADS ];
+    COUNTER cycles[ LLC_FILTER_MAX_THREADS ];     // without memory stalls
+    string  upperStats;                           // IL1/DL1/MLC of every core
+} LLC_FILTER_SUMMARY;
+
+// Records the LLC references of a filter pass
+class LLC_FILTER_WRITER
+{
+  private:
+
+    gzFile          file;
+    unsigned char  *buf;
+    UINT32          bufLen;
+    bool            ok;
+
+    Addr_t          lastAddr;
+    Addr_t          lastPC;
+    COUNTER         references;
+
+  public:
+
+    LLC_FILTER_WRITER();
+    ~LLC_FILTER_WRITER();
+
+    bool        Open( const char *name, const string &traceName, UINT32 linesize, UINT32 threads );
+    inline void Add( UINT32 tid, Addr_t PC, Addr_t addr, UINT32 accessType );
+    bool        Finish( const LLC_FILTER_SUMMARY *summary );
+
+    COUNTER     References() { return references; }
+
+  private:
+
+    void        Flush();
+    void        PutVarint( Addr_t v );
+    void        PutString( const string &s );
+};
+
+// Replays the LLC references of a filtered trace
+class LLC_FILTER_READER
+{
+  private:
+
+    string          filename;
+    gzFile          file;
+
+    // decompressed bytes not yet decoded are buf[bufPos..bufLen)
+    unsigned char  *buf;
+    UINT32          bufPos;
+    UINT32          bufLen;
+    bool            fileDone;
+
+    Addr_t          lastAddr;
+    Addr_t          lastPC;
+    COUNTER         references;
+
+    // header, and the trailer once Next() has reached it
+    string          traceName;
+    UINT32          linesize;
+    UINT32          threads;
+    bool            haveSummary;
+    LLC_FILTER_SUMMARY summary;
+
+  public:
+
+    LLC_FILTER_READER();
+    ~LLC_FILTER_READER();
+
+    bool    Open( const char *name );
+    bool    Rewind();
+    void    Close();
+
+    // Decodes the next reference, returns false at the end of the stream
+    inline bool Next( LLC_REF *ref );
+
+    const string & TraceName() { return traceName; }
+    UINT32  LineSize() { return linesize; }
+    UINT32  Threads() { return threads; }
+    COUNTER References() { return references; }
+
+    // The trailer, NULL until the last reference has been read (or if the
+    // stream is truncated)
+    const LLC_FILTER_SUMMARY * Summary() { return haveSummary ? &summary : NULL; }
+
+  private:
+
+    void    Refill();
+    bool    GetVarint( Addr_t *v );
+    bool    GetNumber( Addr_t *v );
+    bool    GetString( string *s );
+    void    ReadSummary();
+
+    static long long Unzigzag( Addr_t v ) { return (long long) (v >> 1) ^ -(long long) (v & 1); }
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Appends one LLC reference. Runs once per LLC reference of the filter       //
+// pass, so it only encodes into the buffer.                                  //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+inline void LLC_FILTER_WRITER::Add( UINT32 tid, Addr_t PC, Addr_t addr, UINT32 accessType )
+{
+    assert( tid < LLC_FILTER_MAX_THREADS && accessType < ACCESS_MAX );
+
+    if( bufLen > LLC_FILTER_BUFFER_SIZE - LLC_FILTER_MAX_RECORD )
+    {
+        Flush();
+    }
+
+    Addr_t implicitPC = (accessType == ACCESS_IFETCH) ? addr : (accessType == ACCESS_WRITEBACK) ? 0 : lastPC;
+    bool   hasPC      = (PC != implicitPC);
+
+    buf[ bufLen++ ] = accessType | (tid << 3) | (hasPC ? LLC_FILTER_HAS_PC : 0);
+
+    long long delta = (long long) (addr - lastAddr);
+    PutVarint( ((Addr_t) delta << 1) ^ (Addr_t) (delta >> 63) );
+    lastAddr = addr;
+
+    if( hasPC )
+    {
+        delta = (long long) (PC - lastPC);
+        PutVarint( ((Addr_t) delta << 1) ^ (Addr_t) (delta >> 63) );
+        lastPC = PC;
+    }
+
+    references++;
+}
+
+inline void LLC_FILTER_WRITER::PutVarint( Addr_t v )
+{
+    while( v >= 0x80 )
+    {
+        buf[ bufLen++ ] = (unsigned char) (v | 0x80);
+        v >>= 7;
+    }
+
+    buf[ bufLen++ ] = (unsigned char) v;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Decodes one LLC reference. Reaching the end marker reads the trailer.      //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+inline bool LLC_FILTER_READER::Next( LLC_REF *ref )
+{
+    if( bufLen - bufPos < LLC_FILTER_MAX_RECORD && !fileDone )
+    {
+        Refill();
+    }
+
+    if( bufPos >= bufLen )
+    {
+        return false;
+    }
+
+    UINT32 flags = buf[ bufPos++ ];
+
+    if( flags == LLC_FILTER_END )
+    {
+        ReadSummary();
+        return false;
+    }
+
+    Addr_t v;
+
+    if( !GetVarint( &v ) ) return false;
+
+    lastAddr += Unzigzag( v );
+
+    ref->accessType = flags & 7;
+    ref->tid        = (flags >> 3) & 7;
+    ref->paddr      = lastAddr;
+    ref->blocking   = (ref->accessType == ACCESS_IFETCH || ref->accessType == ACCESS_LOAD);
+
+    if( flags & LLC_FILTER_HAS_PC )
+    {
+        if( !GetVarint( &v ) ) return false;
+
+        lastPC += Unzigzag( v );
+        ref->PC = lastPC;
+    }
+    else
+    {
+        ref->PC = (ref->accessType == ACCESS_IFETCH) ? lastAddr : (ref->accessType == ACCESS_WRITEBACK) ? 0 : lastPC;
+    }
+
+    references++;
+
+    return true;
+}
+
+inline bool LLC_FILTER_READER::GetVarint( Addr_t *v )
+{
+    Addr_t value = 0;
+
+    for(UINT32 shift=0; shift<64 && bufPos < bufLen; shift+=7)
+    {
+        unsigned char b = buf[ bufPos++ ];
+
+        value |= (Addr_t) (b & 0x7f) << shift;
+
+        if( !(b & 0x80) )
+        {
+            *v = value;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+#endif
@@ -0,0 +1,467 @@
+#include <sstream>
+#include "llc_group.h"
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// A group of CRC_CACHE instances fed from one pass (see llc_group.h).        //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+static const char *llc_policy_names[] =
+{
+    "LRU",
+    "RANDOM",
+    "CONTESTANT",
+    "OPT",
+    "OPT_BYPASS",
+    "SRRIP",
+    "BRRIP",
+    "DRRIP",
+    "SHIP",
+    "SHIP_BYPASS",
+    "UCP"
+};
+
+static const char *llc_inclusion_names[] =
+{
+    "nine",
+    "inclusive",
+    "exclusive"
+};
+
+static void *WorkerMain( void *arg )
+{
+    LLC_WORKER *worker = (LLC_WORKER *) arg;
+
+    worker->group->RunWorker( worker->id );
+
+    return NULL;
+}
+
+LLC_GROUP::LLC_GROUP( UINT32 _threads, UINT32 _count, const LLC_CONFIG *_configs, UINT32 _workers )
+{
+    assert( _count > 0 && _count <= LLC_GROUP_MAX );
+    assert( _workers <= LLC_WORKERS_MAX && (_workers & (_workers - 1)) == 0 );
+
+    numLLCs    = _count;
+    threads    = _threads;
+    numWorkers = _workers;
+    lineShift  = CRC_FloorLog2( _configs[0].linesize );
+    epochRefs  = 0;
+    arrived    = 0;
+    epoch      = 0;
+    finished   = false;
+    workers    = NULL;
+
+    UINT32 copies = numWorkers ? numWorkers : 1;
+
+    llcs           = (CRC_CACHE *) CRC_AlignedCalloc( copies * numLLCs, sizeof(CRC_CACHE) );
+    blockingMisses = (COUNTER *) CRC_AlignedCalloc( copies * threads * numLLCs, sizeof(COUNTER) );
+
+    assert( llcs && blockingMisses );
+
+    for(UINT32 i=0; i<numLLCs; i++)
+    {
+        configs[i] = _configs[i];
+
+        assert( configs[i].prefetcher == configs[0].prefetcher );
+        assert( configs[i].dramChannels == configs[0].dramChannels );
+    }
+
+    inclusion    = configs[0].inclusion;
+    numEvictions = 0;
+    movedDirty   = false;
+
+    // The private caches above an inclusive or exclusive LLC follow its
+    // contents, which only one instance can set
+    assert( inclusion == LLC_NINE || (numLLCs == 1 && numWorkers == 0) );
+
+    prefetcher = NULL;
+
+    if( configs[0].prefetcher != PF_NONE ) 
+    {
+        prefetcher = new LLC_PREFETCHER( configs[0].prefetcher, configs[0].pfDegree, configs[0].pfDistance,
+                                         configs[0].linesize );
+    }
+
+    for(UINT32 c=0; c<copies * numLLCs; c++)
+    {
+        LLC_CONFIG *config = &configs[ c % numLLCs ];
+
+        new( &llcs[c] ) CRC_CACHE( config->size*1024, config->assoc, threads,
+                                   config->linesize, config->replPolicy, config->sampleRatio );
+
+        if( numWorkers ) 
+        {
+            llcs[c].ReplacementState()->SetEpochMode();
+        }
+
+        if( config->diagnostics ) 
+        {
+            llcs[c].EnableDiagnostics();
+        }
+
+        if( prefetcher ) 
+        {
+            llcs[c].EnablePrefetchStats();
+        }
+
+        if( inclusion != LLC_NINE ) 
+        {
+            llcs[c].EnableInclusion( inclusion );
+        }
+    }
+
+    drams    = NULL;
+    missMask = 0;
+
+    for(UINT32 i=0; i<LLC_GROUP_MAX; i++)
+    {
+        readLatency[i] = 0;
+    }
+
+    // The DRAM models take the references in the order of the reference
+    // stream, which the workers do not keep
+    if( configs[0].dramChannels ) 
+    {
+        assert( numWorkers == 0 );
+
+        drams = (DRAM_MODEL *) CRC_AlignedCalloc( numLLCs, sizeof(DRAM_MODEL) );
+        assert( drams );
+
+        for(UINT32 i=0; i<numLLCs; i++)
+        {
+            new( &drams[i] ) DRAM_MODEL( configs[i].dramChannels, configs[i].dramBanks, configs[i].dramRowSize,
+                                         threads, configs[i].linesize );
+        }
+    }
+
+    if( numWorkers == 0 ) return;
+
+    workers = (LLC_WORKER *) CRC_AlignedCalloc( numWorkers, sizeof(LLC_WORKER) );
+    assert( workers );
+
+    for(UINT32 w=0; w<numWorkers; w++)
+    {
+        workers[w].group      = this;
+        workers[w].id         = w;
+        workers[w].queue.ring = (LLC_REF *) CRC_AlignedCalloc( LLC_QUEUE_SIZE, sizeof(LLC_REF) );
+        assert( workers[w].queue.ring );
+
+        int rc = pthread_create( &workers[w].thread, NULL, WorkerMain, &workers[w] );
+        assert( rc == 0 );
+        (void) rc;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// A worker simulates the references in its queue on its own row of copies    //
+// until it reads the stop marker. At an epoch marker it waits at the         //
+// barrier until the producer has merged the epoch.                           //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+void LLC_GROUP::RunWorker( UINT32 w )
+{
+    LLC_QUEUE *queue  = &workers[w].queue;
+    CRC_CACHE *caches = &llcs[ w * numLLCs ];
+    COUNTER   *stalls = &blockingMisses[ w * threads * numLLCs ];
+    COUNTER    head   = 0;
+
+    for(;;)
+    {
+        COUNTER tail = __atomic_load_n( &queue->tail, __ATOMIC_ACQUIRE );
+
+        if( head == tail ) 
+        {
+            sched_yield();
+            continue;
+        }
+
+        for( ; head != tail; head++ )
+        {
+            const LLC_REF *ref = &queue->ring[ head & (LLC_QUEUE_SIZE - 1) ];
+
+            if( ref->accessType == LLC_REF_STOP ) 
+            {
+                return;
+            }
+
+            if( ref->accessType == LLC_REF_EPOCH ) 
+            {
+                COUNTER ended = __atomic_load_n( &epoch, __ATOMIC_ACQUIRE );
+
+                __atomic_store_n( &queue->head, head + 1, __ATOMIC_RELEASE );
+                __atomic_add_fetch( &arrived, 1, __ATOMIC_ACQ_REL );
+
+                while( __atomic_load_n( &epoch, __ATOMIC_ACQUIRE ) == ended ) 
+                {
+                    sched_yield();
+                }
+
+                continue;
+            }
+
+            for(UINT32 i=0; i<numLLCs; i++)
+            {
+                if( !caches[i].LookupAndFillCache( ref->tid, ref->PC, ref->paddr, ref->accessType ) && ref->blocking )
+                {
+                    stalls[ ref->tid * numLLCs + i ]++;
+                }
+            }
+        }
+
+        __atomic_store_n( &queue->head, head, __ATOMIC_RELEASE );
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Ends an epoch: every worker finishes the references queued so far and      //
+// waits while the deltas of its copies to the state shared by all sets are   //
+// merged, instance by instance and always in worker order.                   //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+void LLC_GROUP::EndEpoch()
+{
+    LLC_REF marker = { 0, 0, 0, LLC_REF_EPOCH, 0 };
+
+    for(UINT32 w=0; w<numWorkers; w++)
+    {
+        Push( &workers[w].queue, marker );
+        Publish( &workers[w].queue );
+    }
+
+    while( __atomic_load_n( &arrived, __ATOMIC_ACQUIRE ) != numWorkers ) 
+    {
+        sched_yield();
+    }
+
+    CACHE_REPLACEMENT_STATE *states[ LLC_WORKERS_MAX ];
+
+    for(UINT32 i=0; i<numLLCs; i++)
+    {
+        for(UINT32 w=0; w<numWorkers; w++)
+        {
+            states[w] = llcs[ w * numLLCs + i ].ReplacementState();
+        }
+
+        CACHE_REPLACEMENT_STATE::MergeEpoch( states, numWorkers );
+    }
+
+    epochRefs = 0;
+    __atomic_store_n( &arrived, 0, __ATOMIC_RELAXED );
+    __atomic_add_fetch( &epoch, 1, __ATOMIC_ACQ_REL );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Drains and stops the workers and merges every instance's copies into the   //
+// first row, which LLC() and BlockingMisses() return. Must be called before  //
+// the statistics are read; does nothing without workers.                     //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+void LLC_GROUP::Finish()
+{
+    if( numWorkers == 0 || finished ) return;
+
+    EndEpoch();
+
+    LLC_REF stop = { 0, 0, 0, LLC_REF_STOP, 0 };
+
+    for(UINT32 w=0; w<numWorkers; w++)
+    {
+        Push( &workers[w].queue, stop );
+        Publish( &workers[w].queue );
+        pthread_join( workers[w].thread, NULL );
+    }
+
+    for(UINT32 w=1; w<numWorkers; w++)
+    {
+        for(UINT32 i=0; i<numLLCs; i++)
+        {
+            llcs[i].MergeStats( &llcs[ w * numLLCs + i ] );
+        }
+
+        for(UINT32 s=0; s<threads * numLLCs; s++)
+        {
+            blockingMisses[s] += blockingMisses[ w * threads * numLLCs + s ];
+        }
+    }
+
+    finished = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Writes the file header and the snapshot of every instance, in order.       //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+bool LLC_GROUP::SaveSnapshot( const char *name )
+{
+    CRC_SNAPSHOT_FILE header;
+    FILE             *file = fopen( name, "wb" );
+    bool              ok;
+
+    assert( numWorkers == 0 );
+
+    if( file == NULL ) 
+    {
+        return false;
+    }
+
+    memset( &header, 0, sizeof(header) );
+    memcpy( header.magic, CRC_SNAPSHOT_MAGIC, sizeof(header.magic) );
+    header.version = CRC_SNAPSHOT_VERSION;
+    header.count   = numLLCs;
+
+    ok = (fwrite( &header, sizeof(header), 1, file ) == 1);
+
+    for(UINT32 i=0; i<numLLCs && ok; i++)
+    {
+        ok = llcs[i].SaveSnapshot( file );
+    }
+
+    return (fclose( file ) == 0) && ok;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Reads the headers of the snapshots in the file, then loads every           //
+// instance from the first one of its geometry and policy, or else the        //
+// first one of its geometry, which leaves its policy's own state cold.       //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+bool LLC_GROUP::LoadSnapshot( const char *name )
+{
+    CRC_SNAPSHOT_FILE header;
+    FILE             *file = fopen( name, "rb" );
+    bool              ok;
+
+    assert( numWorkers == 0 );
+
+    if( file == NULL ) 
+    {
+        return false;
+    }
+
+    ok = fread( &header, sizeof(header), 1, file ) == 1
+         && memcmp( header.magic, CRC_SNAPSHOT_MAGIC, sizeof(header.magic) ) == 0
+         && header.version == CRC_SNAPSHOT_VERSION && header.count <= LLC_GROUP_MAX;
+
+    if( !ok ) 
+    {
+        cerr<<name<<" is not a version "<<CRC_SNAPSHOT_VERSION<<" cache snapshot"<<endl;
+        fclose( file );
+        return false;
+    }
+
+    CRC_SNAPSHOT_HEADER *snapshots = new CRC_SNAPSHOT_HEADER[ header.count ];
+    off_t               *offsets   = new off_t[ header.count ];
+
+    for(UINT32 k=0; k<header.count && ok; k++)
+    {
+        ok = fread( &snapshots[k], sizeof(snapshots[k]), 1, file ) == 1
+             && (offsets[k] = ftello( file )) >= 0
+             && fseeko( file, snapshots[k].bytes, SEEK_CUR ) == 0;
+    }
+
+    if( !ok ) 
+    {
+        cerr<<"Truncated cache snapshot "<<name<<endl;
+    }
+
+    for(UINT32 i=0; i<numLLCs && ok; i++)
+    {
+        INT32 match = -1;
+
+        for(UINT32 k=0; k<header.count; k++)
+        {
+            if( !llcs[i].SnapshotMatches( &snapshots[k] ) ) continue;
+
+            if( match < 0 || (snapshots[k].replPolicy == configs[i].replPolicy 
+                              && snapshots[ match ].replPolicy != configs[i].replPolicy) ) 
+            {
+                match = k;
+            }
+        }
+
+        if( match < 0 ) 
+        {
+            cerr<<name<<" holds no cache of the geometry of "<<Name(i)<<endl;
+            ok = false;
+            break;
+        }
+
+        if( snapshots[ match ].replPolicy != configs[i].replPolicy ) 
+        {
+            cerr<<"Warning: "<<Name(i)<<" takes the lines of the "<<PolicyName( snapshots[ match ].replPolicy )
+                <<" cache in "<<name<<", its own replacement state starts cold"<<endl;
+        }
+
+        ok = fseeko( file, offsets[ match ], SEEK_SET ) == 0 && llcs[i].LoadSnapshot( file, &snapshots[ match ] );
+
+        if( !ok ) 
+        {
+            cerr<<"Truncated cache snapshot "<<name<<endl;
+        }
+    }
+
+    delete [] snapshots;
+    delete [] offsets;
+    fclose( file );
+
+    return ok;
+}
+
+const char * LLC_GROUP::PolicyName( UINT32 replPolicy )
+{
+    if( replPolicy < sizeof(llc_policy_names) / sizeof(llc_policy_names[0]) )
+    {
+        return llc_policy_names[ replPolicy ];
+    }
+
+    return "UNKNOWN";
+}
+
+const char * LLC_GROUP::InclusionName( UINT32 inclusion )
+{
+    return (inclusion < LLC_INCLUSION_MAX) ? llc_inclusion_names[ inclusion ] : "unknown";
+}
+
+bool LLC_GROUP::ParseInclusion( const char *name, UINT32 *inclusion )
+{
+    for(UINT32 m=0; m<LLC_INCLUSION_MAX; m++)
+    {
+        if( string( name ) == llc_inclusion_names[m] )
+        {
+            *inclusion = m;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// e.g. "UL3:1024:64:16 LRU", "UL3:1024:64:16 LRU 1/32" for a sampled one,
+// "UL3:1024:64:16 LRU inclusive" for an inclusive one
+string LLC_GROUP::Name( UINT32 i )
+{
+    ostringstream name;
+
+    name<<"UL3:"<<configs[i].size<<":"<<configs[i].linesize<<":"<<configs[i].assoc
+        <<" "<<PolicyName( configs[i].replPolicy );
+
+    if( configs[i].sampleRatio > 1 ) 
+    {
+        name<<" 1/"<<configs[i].sampleRatio;
+    }
+
+    if( configs[i].inclusion != LLC_NINE ) 
+    {
+        name<<" "<<InclusionName( configs[i].inclusion );
+    }
+
+    return name.str();
+}
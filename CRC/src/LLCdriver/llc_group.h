@@ -0,0 +1,374 @@
+#ifndef LLC_GROUP_H
+#define LLC_GROUP_H
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// A group of CRC_CACHE instances with different geometries and replacement   //
+// policies that see the same LLC reference stream, so several LLC            //
+// configurations are evaluated from a single pass over a trace.              //
+//                                                                            //
+// With worker threads the sets are split among the workers by the low bits   //
+// of the line address. Every worker runs a copy of every instance and gets   //
+// the references to its sets through a single-producer single-consumer       //
+// queue; the copies run their replacement state in epoch mode, and every     //
+// LLC_EPOCH_REFS references all workers stop at a barrier where their        //
+// changes to the state shared by all sets are merged. Finish() merges the    //
+// statistics of the copies into the first one.                               //
+//                                                                            //
+// An optional prefetcher trains on the demand references on the calling      //
+// thread and sends its prefetches to every instance after the reference      //
+// that triggered them, so all instances and worker counts see the same       //
+// prefetches.                                                                //
+//                                                                            //
+// Without workers every instance can have a DRAM model of its own behind     //
+// it, which takes the instance's fills and writebacks at the cycle count of  //
+// the thread under that instance and gives the stalls of its reads.          //
+//                                                                            //
+// Without workers the instances can be saved to a warm-cache snapshot at     //
+// the end of a warm-up run and loaded from it before later runs.             //
+//                                                                            //
+// An inclusive or exclusive group has a single instance on the calling       //
+// thread, as the private caches above it depend on its contents. Access      //
+// then collects the lines the inclusive LLC evicted, for the caller to       //
+// back-invalidate, and an exclusive LLC takes the private caches' victims    //
+// through InsertVictim.                                                      //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#include <new>
+#include <pthread.h>
+#include <sched.h>
+#include "utils.h"
+#include "crc_cache.h"
+#include "llc_prefetcher.h"
+#include "dram_model.h"
+
+#define LLC_GROUP_MAX       32
+#define LLC_WORKERS_MAX     64
+#define LLC_EPOCH_REFS      1024       // references between merges
+#define LLC_QUEUE_SIZE      (1 << 14)   // references per worker queue
+#define LLC_QUEUE_BATCH     256         // references published at once
+
+// Valid lines one Access can evict: the reference and its prefetches
+#define LLC_MAX_EVICTIONS   (1 + PF_MAX_DEGREE)
+
+// Queue markers in place of an access type
+#define LLC_REF_EPOCH       (ACCESS_MAX + 1)
+#define LLC_REF_STOP        (ACCESS_MAX + 2)
+
+// Geometry and policy of one LLC instance
+typedef struct
+{
+    UINT32  size;       // KB
+    UINT32  linesize;
+    UINT32  assoc;
+    UINT32  replPolicy;
+    UINT32  sampleRatio;    // 1 of every sampleRatio sets modelled
+    bool    diagnostics;    // reuse and dead-block diagnostics
+    UINT32  prefetcher;     // PrefetcherTypes, the same for every instance
+    UINT32  pfDegree;       // 0 = the prefetcher's default
+    UINT32  pfDistance;
+    UINT32  dramChannels;   // 0 = no DRAM model, the same for every instance
+    UINT32  dramBanks;      // per channel
+    UINT32  dramRowSize;    // bytes
+    UINT32  inclusion;      // LLCInclusion, NINE unless the group has one instance
+} LLC_CONFIG;
+
+// A line an inclusive LLC evicted, and the threads that may hold it above
+typedef struct
+{
+    Addr_t      paddr;
+    BITVECTOR   presence;
+} LLC_EVICTION;
+
+// One LLC reference on its way to a worker
+typedef struct
+{
+    Addr_t  PC;
+    Addr_t  paddr;
+    UINT32  tid;
+    UINT32  accessType;
+    UINT32  blocking;
+} LLC_REF;
+
+// Single-producer single-consumer ring. The producer fills entries up to
+// pending and publishes them in batches by advancing tail; the worker
+// advances head. The two sides' counters sit on separate host lines
+typedef struct
+{
+    LLC_REF    *ring;
+    COUNTER     pending;
+    COUNTER     tail;
+    char        pad[ 64 - sizeof(LLC_REF *) - 2 * sizeof(COUNTER) ];
+    COUNTER     head;
+    char        pad2[ 64 - sizeof(COUNTER) ];
+} LLC_QUEUE;
+
+class LLC_GROUP;
+
+typedef struct
+{
+    LLC_GROUP  *group;
+    UINT32      id;
+    pthread_t   thread;
+    LLC_QUEUE   queue;
+} LLC_WORKER;
+
+class LLC_GROUP
+{
+  private:
+
+    UINT32      numLLCs;
+    UINT32      threads;
+    LLC_CONFIG  configs[ LLC_GROUP_MAX ];
+
+    // The instances live side by side in one aligned block and are visited
+    // in order on every reference, so the per-reference walk touches
+    // adjacent objects instead of scattered heap allocations. With workers
+    // there is one such row of copies per worker (numWorkers x numLLCs)
+    CRC_CACHE  *llcs;
+
+    // Demand misses that stall the core, thread-major (threads x numLLCs)
+    // so one reference updates one contiguous row, one block per worker
+    COUNTER    *blockingMisses;
+
+    LLC_PREFETCHER *prefetcher;    // NULL for none
+    DRAM_MODEL     *drams;         // one per instance, NULL for none
+
+    // The instances the last blocking Access missed in and, with DRAM
+    // models, the latencies of their reads
+    UINT32      missMask;
+    UINT32      readLatency[ LLC_GROUP_MAX ];
+
+    // Inclusion of the only instance, and what the last Access evicted
+    // from it or, exclusive, moved up from it
+    UINT32       inclusion;
+    LLC_EVICTION evictions[ LLC_MAX_EVICTIONS ];
+    UINT32       numEvictions;
+    bool         movedDirty;
+
+    // Worker threads, 0 to simulate on the calling thread
+    UINT32      numWorkers;
+    UINT32      lineShift;
+    LLC_WORKER *workers;
+    COUNTER     epochRefs;
+    UINT32      arrived;     // workers waiting at the epoch barrier
+    COUNTER     epoch;       // epochs ended
+    bool        finished;
+
+  public:
+
+    LLC_GROUP( UINT32 _threads, UINT32 _count, const LLC_CONFIG *_configs, UINT32 _workers=0 );
+
+    inline void Access( UINT32 tid, Addr_t PC, Addr_t paddr, UINT32 accessType, bool blocking, COUNTER now=0 );
+    inline void InsertVictim( UINT32 tid, Addr_t paddr, bool dirty, COUNTER now=0 );
+    inline void WriteMemory( UINT32 tid, Addr_t paddr, COUNTER now=0 );
+    void        Finish();
+
+    // Writes a warm-cache snapshot of every instance (see crc_snapshot.h)
+    bool        SaveSnapshot( const char *name );
+    // Loads every instance from the snapshot of its geometry and policy,
+    // or of its geometry and another policy, false if the file has none
+    // or is not a snapshot
+    bool        LoadSnapshot( const char *name );
+
+    UINT32      NumLLCs() { return numLLCs; }
+    LLC_PREFETCHER * Prefetcher() { return prefetcher; }
+    DRAM_MODEL * DRAM( UINT32 i ) { return drams ? &drams[ i ] : NULL; }
+
+    UINT32      Inclusion() { return inclusion; }
+    // The lines the last Access evicted from an inclusive LLC
+    UINT32      Evictions( const LLC_EVICTION **list ) 
+    { 
+        *list = evictions; 
+        return numEvictions; 
+    }
+    // Without workers, the instances the last blocking Access missed in
+    UINT32      BlockingMissMask() { return missMask; }
+    // ... and the latency of the DRAM read of instance i's miss
+    UINT32      ReadLatency( UINT32 i ) { return readLatency[ i ]; }
+    // Whether the line the last Access hit in an exclusive LLC came up dirty
+    bool        MovedDirty() { return movedDirty; }
+    CRC_CACHE * LLC( UINT32 i ) { return &llcs[ i ]; }
+    const LLC_CONFIG * Config( UINT32 i ) { return &configs[ i ]; }
+    // Sampled instances only see the misses of their sampled sets, so their
+    // count is scaled up to all sets
+    COUNTER     BlockingMisses( UINT32 tid, UINT32 i ) 
+    { 
+        return blockingMisses[ tid * numLLCs + i ] * configs[i].sampleRatio; 
+    }
+
+    string      Name( UINT32 i );
+    static const char * PolicyName( UINT32 replPolicy );
+    static const char * InclusionName( UINT32 inclusion );
+    static bool ParseInclusion( const char *name, UINT32 *inclusion );
+
+    void        RunWorker( UINT32 w );
+
+  private:
+
+    inline void Send( UINT32 tid, Addr_t PC, Addr_t paddr, UINT32 accessType, bool blocking, COUNTER now );
+    inline void AccessMemory( UINT32 i, UINT32 tid, Addr_t paddr, UINT32 accessType, bool blocking, bool hit,
+                              COUNTER now );
+    inline void Push( LLC_QUEUE *queue, const LLC_REF &ref );
+    void        Publish( LLC_QUEUE *queue ) 
+    { 
+        __atomic_store_n( &queue->tail, queue->pending, __ATOMIC_RELEASE ); 
+    }
+
+    void        EndEpoch();
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// One LLC reference, followed by the prefetches a demand reference           //
+// triggers. blocking marks references the core waits on (instruction         //
+// fetches and loads); now is the thread's cycle count without memory         //
+// stalls, for the DRAM models.                                               //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+inline void LLC_GROUP::Access( UINT32 tid, Addr_t PC, Addr_t paddr, UINT32 accessType, bool blocking, COUNTER now )
+{
+    if( inclusion != LLC_NINE ) 
+    {
+        numEvictions = 0;
+        movedDirty   = false;
+    }
+
+    if( blocking ) 
+    {
+        missMask = 0;
+    }
+
+    Send( tid, PC, paddr, accessType, blocking, now );
+
+    if( prefetcher && accessType <= ACCESS_STORE ) 
+    {
+        Addr_t pf[ PF_MAX_DEGREE ];
+        UINT32 n = prefetcher->Train( PC, paddr, accessType, pf );
+
+        for(UINT32 p=0; p<n; p++)
+        {
+            Send( tid, PC, pf[p], ACCESS_PREFETCH, false, now );
+        }
+    }
+}
+
+// Sends one reference to every instance. The misses of blocking references
+// are counted per instance so each one gets its own cycle count
+inline void LLC_GROUP::Send( UINT32 tid, Addr_t PC, Addr_t paddr, UINT32 accessType, bool blocking, COUNTER now )
+{
+    if( numWorkers ) 
+    {
+        LLC_REF ref = { PC, paddr, tid, accessType, blocking };
+
+        Push( &workers[ (paddr >> lineShift) & (numWorkers - 1) ].queue, ref );
+
+        if( ++epochRefs == LLC_EPOCH_REFS ) 
+        {
+            EndEpoch();
+        }
+
+        return;
+    }
+
+    COUNTER *stalls = &blockingMisses[ tid * numLLCs ];
+
+    for(UINT32 i=0; i<numLLCs; i++)
+    {
+        bool hit = llcs[i].LookupAndFillCache( tid, PC, paddr, accessType );
+
+        if( !hit && blocking )
+        {
+            stalls[i]++;
+            missMask |= 1u << i;
+        }
+
+        if( drams ) 
+        {
+            AccessMemory( i, tid, paddr, accessType, blocking, hit, now );
+        }
+    }
+
+    // The group has a single instance when it has an inclusion
+    if( inclusion == LLC_INCLUSIVE ) 
+    {
+        LLC_EVICTION *eviction = &evictions[ numEvictions ];
+
+        numEvictions += llcs[0].TakeEviction( &eviction->paddr, &eviction->presence );
+    }
+    else if( inclusion == LLC_EXCLUSIVE ) 
+    {
+        movedDirty |= llcs[0].TakeMovedDirty();
+    }
+}
+
+// Exclusive: a valid line evicted from the private caches of thread tid
+inline void LLC_GROUP::InsertVictim( UINT32 tid, Addr_t paddr, bool dirty, COUNTER now )
+{
+    bool hit = llcs[0].InsertVictim( tid, paddr, dirty );
+
+    if( drams ) 
+    {
+        AccessMemory( 0, tid, paddr, ACCESS_WRITEBACK, false, hit, now );
+    }
+}
+
+// Inclusive: a dirty line that a back-invalidation took from the private
+// caches of thread tid goes straight to memory
+inline void LLC_GROUP::WriteMemory( UINT32 tid, Addr_t paddr, COUNTER now )
+{
+    if( drams ) 
+    {
+        drams[0].Write( tid, paddr, now + drams[0].Stall( tid ) );
+    }
+}
+
+// The DRAM traffic of an access to instance i: the fill of a miss (a missing
+// writeback brings its own data), then the line the access wrote back. The
+// thread is at cycle now plus its memory stalls under the instance
+inline void LLC_GROUP::AccessMemory( UINT32 i, UINT32 tid, Addr_t paddr, UINT32 accessType, bool blocking, bool hit,
+                                     COUNTER now )
+{
+    DRAM_MODEL *dram = &drams[i];
+    Addr_t      wbAddr;
+    UINT32      owner;
+
+    now += dram->Stall( tid );
+
+    if( !hit && accessType != ACCESS_WRITEBACK ) 
+    {
+        UINT32 latency = dram->Read( tid, paddr, now, blocking );
+
+        if( blocking ) 
+        {
+            readLatency[i] = latency;
+        }
+    }
+
+    if( llcs[i].TakeWriteback( &wbAddr, &owner ) ) 
+    {
+        dram->Write( owner, wbAddr, now );
+    }
+}
+
+// Waits for room, then queues the reference; it reaches the worker with
+// the next published batch
+inline void LLC_GROUP::Push( LLC_QUEUE *queue, const LLC_REF &ref )
+{
+    while( queue->pending - __atomic_load_n( &queue->head, __ATOMIC_ACQUIRE ) == LLC_QUEUE_SIZE ) 
+    {
+        Publish( queue );
+        sched_yield();
+    }
+
+    queue->ring[ queue->pending++ & (LLC_QUEUE_SIZE - 1) ] = ref;
+
+    if( queue->pending - queue->tail == LLC_QUEUE_BATCH ) 
+    {
+        Publish( queue );
+    }
+}
+
+#endif
@@ -0,0 +1,524 @@
+#include <climits>
+#include <iomanip>
+#include <sstream>
+#include "memory_hierarchy.h"
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// The cache hierarchy modelled by the open driver (see memory_hierarchy.h).  //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+MEMORY_HIERARCHY::MEMORY_HIERARCHY( UINT32 _cores, LLC_GROUP *_llcs, UINT32 _linesize )
+{
+    numCores  = _cores;
+    lineShift = CRC_FloorLog2( _linesize );
+    llcs      = _llcs;      // NULL when only recording the LLC references
+    inclusion = llcs ? llcs->Inclusion() : LLC_NINE;
+    profiler  = NULL;
+    recorder  = NULL;
+    filter    = NULL;
+    sampler   = NULL;
+    upperStats = NULL;
+
+    sampleInstrLeft = LLONG_MAX;
+    sampleRefsLeft  = LLONG_MAX;
+    cores     = new CORE_STATE[ numCores ];
+
+    for(UINT32 c=0; c<numCores; c++) 
+    {
+        cores[c].il1 = new HIER_CACHE( "IL1", 0, c, IL1_SIZE, IL1_ASSOC, _linesize );
+        cores[c].dl1 = new HIER_CACHE( "DL1", 1, c, DL1_SIZE, DL1_ASSOC, _linesize );
+        cores[c].mlc = new HIER_CACHE( "UL2", 2, c, MLC_SIZE, MLC_ASSOC, _linesize );
+
+        cores[c].fetchLine    = 0;
+        cores[c].fetchValid   = false;
+        cores[c].instructions = 0;
+        cores[c].cycles       = 0;
+
+        cores[c].probes           = 0;
+        cores[c].probesFiltered   = 0;
+        cores[c].inclusionVictims = 0;
+        cores[c].dirtyVictims     = 0;
+        cores[c].llcVictims       = 0;
+        cores[c].movedDirty       = 0;
+        cores[c].ooo              = NULL;
+    }
+}
+
+bool MEMORY_HIERARCHY::Finish()
+{
+    COUNTER instructions = 0;
+
+    for(UINT32 c=0; c<numCores; c++) 
+    {
+        if( cores[c].ooo ) cores[c].ooo->Finish( cores[c].instructions );
+
+        instructions += cores[c].instructions;
+    }
+
+    return sampler == NULL || sampler->Finish( instructions );
+}
+
+void MEMORY_HIERARCHY::SetSampler( INTERVAL_SAMPLER *_sampler )
+{
+    sampler         = _sampler;
+    sampleInstrLeft = LLONG_MAX;
+    sampleRefsLeft  = LLONG_MAX;
+
+    if( sampler == NULL ) return;
+
+    if( sampler->Unit() == INTERVAL_INSTRUCTIONS ) 
+    {
+        sampleInstrLeft = (long long) sampler->Interval();
+    }
+    else 
+    {
+        sampleRefsLeft = (long long) sampler->Interval();
+    }
+}
+
+// The countdown ran out: samples at the instructions retired so far and
+// starts the next interval
+void MEMORY_HIERARCHY::SampleInterval()
+{
+    COUNTER instructions = 0;
+
+    for(UINT32 c=0; c<numCores; c++) 
+    {
+        instructions += cores[c].instructions;
+    }
+
+    sampler->Sample( instructions );
+
+    if( sampler->Unit() == INTERVAL_INSTRUCTIONS ) 
+    {
+        sampleInstrLeft += (long long) sampler->Interval();
+    }
+    else 
+    {
+        sampleRefsLeft += (long long) sampler->Interval();
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Sends an L1 miss or writeback to the core's MLC and, if a miss misses      //
+// there too, to the LLCs. A writeback that misses the MLC stays there: the   //
+// MLC now holds the line dirty and writes it back when it evicts it. Dirty   //
+// MLC victims are written back to the LLCs. Returns the load-to-use latency  //
+// of the request down to the LLC; memory latency depends on the LLC          //
+// instance and is counted by the LLC group.                                  //
+//                                                                            //
+// An exclusive LLC takes every MLC victim instead, clean or dirty.           //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+UINT32 MEMORY_HIERARCHY::AccessMLC( UINT32 tid, Addr_t PC, Addr_t addr, UINT32 accessType )
+{
+    CORE_STATE *core = &cores[ tid ];
+    HIER_VICTIM victim;
+    UINT32      latency = MLC_LATENCY;
+
+    if( !core->mlc->Access( addr, accessType, &victim ) ) 
+    {
+        latency += LLC_LATENCY;
+
+        if( accessType != ACCESS_WRITEBACK ) 
+        {
+            AccessLLC( tid, PC, addr, accessType, accessType == ACCESS_IFETCH || accessType == ACCESS_LOAD );
+
+            if( inclusion == LLC_EXCLUSIVE && llcs->MovedDirty() ) 
+            {
+                core->mlc->MarkDirty( addr );
+                core->movedDirty++;
+            }
+        }
+    }
+
+    if( victim.valid && inclusion == LLC_EXCLUSIVE ) 
+    {
+        llcs->InsertVictim( tid, victim.addr, victim.dirty, core->cycles );
+        core->llcVictims++;
+
+        if( profiler ) profiler->Access( victim.addr, ACCESS_WRITEBACK );
+    }
+    else if( victim.valid && victim.dirty ) 
+    {
+        AccessLLC( tid, 0, victim.addr, ACCESS_WRITEBACK, false );
+    }
+
+    return latency;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// After an access to an inclusive LLC: every line it evicted leaves the      //
+// private caches of the cores in its presence bitmap, the others are not     //
+// probed. A dirty copy goes straight to memory.                              //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+void MEMORY_HIERARCHY::BackInvalidate()
+{
+    const LLC_EVICTION *evictions;
+    UINT32              n       = llcs->Evictions( &evictions );
+    BITVECTOR           allMask = CRC_WayMask( numCores );
+
+    for(UINT32 e=0; e<n; e++) 
+    {
+        Addr_t    addr     = evictions[e].paddr;
+        BITVECTOR presence = evictions[e].presence & allMask;
+
+        for(BITVECTOR absent = ~presence & allMask; absent; absent &= absent - 1) 
+        {
+            cores[ CRC_CountTrailingZeros64( absent ) ].probesFiltered++;
+        }
+
+        while( presence ) 
+        {
+            UINT32      c    = CRC_CountTrailingZeros64( presence );
+            CORE_STATE *core = &cores[c];
+            bool        il1Dirty = false, dl1Dirty = false, mlcDirty = false;
+
+            presence &= presence - 1;
+            core->probes++;
+
+            bool found = core->il1->Invalidate( addr, &il1Dirty );
+
+            found |= core->dl1->Invalidate( addr, &dl1Dirty );
+            found |= core->mlc->Invalidate( addr, &mlcDirty );
+
+            if( !found ) continue;
+
+            core->inclusionVictims++;
+
+            if( il1Dirty || dl1Dirty || mlcDirty ) 
+            {
+                core->dirtyVictims++;
+                llcs->WriteMemory( c, addr, core->cycles );
+            }
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// A load or store from the trace. Loads stall the core for the latency of    //
+// the level they hit in, stores retire without stalling. A load that misses  //
+// the DL1 goes to the out-of-order model as the last instruction retired.    //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+void MEMORY_HIERARCHY::DataAccess( UINT32 tid, Addr_t PC, Addr_t addr, UINT32 accessType )
+{
+    CORE_STATE  *core = &cores[ tid ];
+    HIER_VICTIM  victim;
+    UINT32       latency = 0;
+
+    if( !core->dl1->Access( addr, accessType, &victim ) ) 
+    {
+        latency = AccessMLC( tid, PC, addr, accessType );
+    }
+
+    if( victim.valid && victim.dirty ) 
+    {
+        AccessMLC( tid, 0, victim.addr, ACCESS_WRITEBACK );
+    }
+
+    if( accessType == ACCESS_LOAD ) 
+    {
+        core->cycles += latency;
+
+        if( core->ooo && latency ) 
+        {
+            UINT32 latencies[ LLC_GROUP_MAX ];
+            UINT32 missMask = (latency > MLC_LATENCY) ? llcs->BlockingMissMask() : 0;
+
+            Latencies( latency, latencies );
+            core->ooo->AddLoad( core->instructions - 1, missMask, latencies );
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Prints the per core thread counts and upper-level cache statistics,        //
+// followed by the LLC statistics, in the layout of the CMPsim stats files.   //
+// The out-of-order timing, if any, follows the upper levels, and adds its    //
+// cycles and IPC to the Full Run Summary or the comparison table.            //
+// The prefetcher in front of the LLCs, if any, prints its statistics first,  //
+// and the DRAM model of every LLC instance follows its statistics.           //
+// With several LLC instances every instance prints its statistics under      //
+// its name and the run ends with a comparison table instead of the           //
+// Full Run Summary. The stack-distance profile, if any, follows the LLCs.    //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+ostream & MEMORY_HIERARCHY::PrintStats( ostream &out )
+{
+    UINT32 numLLCs = llcs->NumLLCs();
+
+    for(UINT32 c=0; c<numCores; c++) 
+    {
+        out<<endl;
+        out<<"Thread ID: "<<c<<endl;
+        out<<"###################################################################"<<endl;
+        out<<"# Total Number of Instructions Executed:  "<<cores[c].instructions<<endl;
+        out<<"###################################################################"<<endl;
+        out<<endl;
+    }
+
+    out<<endl;
+    out<<"Thread Counts: "<<endl;
+
+    for(UINT32 c=0; c<numCores; c++) 
+    {
+        out<<"\tThread: "<<c<<" Instructions: "<<cores[c].instructions<<" Cycles: "<<Cycles(c);
+
+        for(UINT32 i=1; i<numLLCs; i++) 
+        {
+            out<<" "<<Cycles(c, i);
+        }
+
+        out<<endl;
+    }
+
+    out<<endl;
+    out<<endl;
+    out<<"+=+=+=+=+=+=+=+=+=+=+=+=+=+=+= EXPERIMENT 0 +=+=+=+=+=+=+=+=+=+=+=+=+=+=+="<<endl;
+    out<<endl;
+
+    PrintUpperLevels( out );
+    PrintInclusion( out );
+    PrintTiming( out );
+
+    if( llcs->Prefetcher() ) 
+    {
+        llcs->Prefetcher()->PrintStats( out );
+    }
+
+    for(UINT32 i=0; i<numLLCs; i++) 
+    {
+        if( numLLCs > 1 ) 
+        {
+            out<<endl;
+            out<<"LLC "<<i<<": "<<llcs->Name(i)<<endl;
+        }
+
+        llcs->LLC(i)->PrintStats( out );
+
+        if( llcs->DRAM(i) ) 
+        {
+            llcs->DRAM(i)->PrintStats( out );
+        }
+    }
+
+    if( profiler ) 
+    {
+        profiler->PrintStats( out );
+    }
+
+    if( numLLCs > 1 ) 
+    {
+        return PrintComparison( out );
+    }
+
+    out<<endl;
+    out<<"Full Run Summary: "<<endl;
+
+    for(UINT32 c=0; c<numCores; c++) 
+    {
+        out<<"\tThread ID: "<<c<<" ICOUNT: "<<cores[c].instructions<<" CYC: "<<Cycles(c)
+           <<" CPI: "<<(cores[c].instructions ? (double)Cycles(c)/(double)cores[c].instructions : 0.0)
+           <<" LLC Misses: "<<(COUNTER) (llcs->LLC(0)->ThreadDemandMissEstimate(c) + 0.5);
+
+        if( cores[c].ooo ) 
+        {
+            OOO_CORE *ooo = cores[c].ooo;
+
+            out<<" OOO CYC: "<<ooo->Cycles(0)
+               <<" OOO IPC: "<<(ooo->Cycles(0) ? (double)ooo->Instructions()/(double)ooo->Cycles(0) : 0.0);
+        }
+
+        out<<endl;
+    }
+
+    return out;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// The IL1, DL1 and MLC statistics of every core, simulated or replayed.      //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+ostream & MEMORY_HIERARCHY::PrintUpperLevels( ostream &out )
+{
+    if( upperStats ) 
+    {
+        return out<<*upperStats;
+    }
+
+    for(UINT32 c=0; c<numCores; c++) 
+    {
+        cores[c].il1->PrintStats( out );
+        cores[c].dl1->PrintStats( out );
+        cores[c].mlc->PrintStats( out );
+    }
+
+    return out;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Per core, what an inclusive or exclusive LLC did to its private caches.    //
+// Nothing for a non-inclusive LLC.                                           //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+ostream & MEMORY_HIERARCHY::PrintInclusion( ostream &out )
+{
+    if( inclusion == LLC_NINE ) return out;
+
+    out<<"Inclusion: "<<LLC_GROUP::InclusionName( inclusion )<<endl;
+
+    for(UINT32 c=0; c<numCores; c++) 
+    {
+        CORE_STATE *core = &cores[c];
+
+        out<<"\tThread: "<<c;
+
+        if( inclusion == LLC_INCLUSIVE ) 
+        {
+            out<<" Back-Invalidations: "<<core->probes<<" Filtered: "<<core->probesFiltered
+               <<" Inclusion Victims: "<<core->inclusionVictims<<" Dirty: "<<core->dirtyVictims<<endl;
+        }
+        else 
+        {
+            out<<" Victims to LLC: "<<core->llcVictims<<" Dirty Lines Moved Up: "<<core->movedDirty<<endl;
+        }
+    }
+
+    out<<endl;
+
+    return out;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Per core, the out-of-order timing under every LLC instance. Nothing        //
+// without the models.                                                        //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+ostream & MEMORY_HIERARCHY::PrintTiming( ostream &out )
+{
+    if( cores[0].ooo == NULL ) return out;
+
+    out<<"Out-of-Order Timing: ROB "<<cores[0].ooo->Rob()<<", width "<<cores[0].ooo->Width()<<endl;
+
+    for(UINT32 c=0; c<numCores; c++) 
+    {
+        cores[c].ooo->PrintStats( out, c, llcs );
+    }
+
+    out<<endl;
+
+    return out;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// At the end of a filter pass: what the trailer of the filtered trace        //
+// keeps about the upper levels.                                              //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+void MEMORY_HIERARCHY::Summarize( LLC_FILTER_SUMMARY *summary )
+{
+    ostringstream stats;
+
+    assert( numCores <= LLC_FILTER_MAX_THREADS );
+
+    summary->threads = numCores;
+
+    for(UINT32 c=0; c<numCores; c++) 
+    {
+        summary->instructions[c] = cores[c].instructions;
+        summary->cycles[c]       = cores[c].cycles;
+    }
+
+    PrintUpperLevels( stats );
+    summary->upperStats = stats.str();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// After replaying a filtered trace: takes the upper-level counts and         //
+// statistics from its trailer, which must outlive the hierarchy's stats.     //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+void MEMORY_HIERARCHY::SetUpperLevels( const LLC_FILTER_SUMMARY *summary )
+{
+    assert( summary->threads == numCores );
+
+    for(UINT32 c=0; c<numCores; c++) 
+    {
+        cores[c].instructions = summary->instructions[c];
+        cores[c].cycles       = summary->cycles[c];
+    }
+
+    upperStats = &summary->upperStats;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// One row per LLC instance and thread: demand accesses and misses, miss      //
+// rate, misses and memory writebacks per kilo-instruction and CPI under      //
+// that LLC, and the out-of-order IPC under it if the cores have the model.   //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+ostream & MEMORY_HIERARCHY::PrintComparison( ostream &out )
+{
+    out<<endl;
+    out<<"LLC Comparison: "<<endl;
+    out<<"  "<<setw(4)<<"LLC"<<"  "<<left<<setw(28)<<"Configuration"<<right
+       <<setw(7)<<"Thread"<<setw(12)<<"Accesses"<<setw(12)<<"Misses"
+       <<setw(10)<<"MissRate"<<setw(10)<<"MPKI"<<setw(10)<<"WBPKI"<<setw(10)<<"CPI";
+
+    if( cores[0].ooo ) 
+    {
+        out<<setw(10)<<"OOO-IPC";
+    }
+
+    out<<endl;
+
+    for(UINT32 i=0; i<llcs->NumLLCs(); i++) 
+    {
+        CRC_CACHE *llc = llcs->LLC(i);
+
+        for(UINT32 c=0; c<numCores; c++) 
+        {
+            COUNTER lookups = llc->ThreadDemandReferences(c);
+            COUNTER misses  = (COUNTER) (llc->ThreadDemandMissEstimate(c) + 0.5);
+            COUNTER instrs  = cores[c].instructions;
+            COUNTER wbs     = llc->ThreadWritebackStats(c) * llc->SampleRatio();
+
+            out<<"  "<<setw(4)<<i<<"  "<<left<<setw(28)<<llcs->Name(i)<<right
+               <<setw(7)<<c<<setw(12)<<lookups<<setw(12)<<misses<<fixed<<setprecision(2)
+               <<setw(10)<<(lookups ? (double)misses/(double)lookups*100.0 : 0.0)
+               <<setw(10)<<(instrs ? (double)misses*1000.0/(double)instrs : 0.0)
+               <<setw(10)<<(instrs ? (double)wbs*1000.0/(double)instrs : 0.0)
+               <<setprecision(4)
+               <<setw(10)<<(instrs ? (double)Cycles(c, i)/(double)instrs : 0.0);
+
+            if( cores[c].ooo ) 
+            {
+                COUNTER cycles = cores[c].ooo->Cycles(i);
+
+                out<<setw(10)<<(cycles ? (double)cores[c].ooo->Instructions()/(double)cycles : 0.0);
+            }
+
+            out<<endl;
+
+            out.unsetf( ios::floatfield );
+            out<<setprecision(6);
+        }
+    }
+
+    return out;
+}
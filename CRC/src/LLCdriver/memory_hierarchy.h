@@ -0,0 +1,229 @@
+#ifndef MEMORY_HIERARCHY_H
+#define MEMORY_HIERARCHY_H
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// The cache hierarchy modelled by the open driver: per core a private        //
+// IL1, DL1 and unified MLC in front of a group of shared CRC_CACHE LLCs,   //
+// geometry and load-to-use latencies of the CMPsim kit configuration.        //
+//                                                                            //
+// The LLC is non-inclusive non-exclusive unless the group says otherwise.    //
+// An inclusive LLC's victims are invalidated in the private caches of the    //
+// cores in the victim's presence bitmap (the LLC line's sharing_dir), and    //
+// dirty copies go to memory. An exclusive LLC hands its demand hits to the   //
+// MLC and takes every MLC victim, clean or dirty.                            //
+//                                                                            //
+// A core can also have an out-of-order timing model, which gets the          //
+// latency of every load that misses the DL1 and every fetch that misses the  //
+// IL1 under each LLC instance, and follows the hierarchy as it retires.      //
+//                                                                            //
+// An interval sampler is called every so many instructions or LLC            //
+// references, counted down where they happen.                                //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#include "utils.h"
+#include "hier_cache.h"
+#include "llc_group.h"
+#include "stack_profiler.h"
+#include "llc_filter.h"
+#include "ooo_core.h"
+#include "interval_sampler.h"
+
+#define IL1_SIZE        (32*1024)
+#define IL1_ASSOC       4
+#define DL1_SIZE        (32*1024)
+#define DL1_ASSOC       8
+#define MLC_SIZE        (256*1024)
+#define MLC_ASSOC       8
+
+#define MLC_LATENCY     10
+#define LLC_LATENCY     30
+#define MEM_LATENCY     200
+
+// Per core state of the hierarchy
+typedef struct
+{
+    HIER_CACHE *il1;
+    HIER_CACHE *dl1;
+    HIER_CACHE *mlc;
+
+    Addr_t      fetchLine;    // line the core is fetching from
+    bool        fetchValid;
+
+    COUNTER     instructions;
+    COUNTER     cycles;       // one per instruction plus stalls above memory
+
+    // Inclusive LLC
+    COUNTER     probes;           // back-invalidations sent to the core's caches
+    COUNTER     probesFiltered;   // ... spared by the presence bitmap
+    COUNTER     inclusionVictims; // lines they removed
+    COUNTER     dirtyVictims;     // ... that were dirty and went to memory
+
+    // Exclusive LLC
+    COUNTER     llcVictims;       // MLC victims inserted in the LLC
+    COUNTER     movedDirty;       // dirty lines the LLC handed to the MLC
+
+    OOO_CORE   *ooo;              // optional out-of-order timing
+} CORE_STATE;
+
+class MEMORY_HIERARCHY
+{
+  private:
+
+    UINT32      numCores;
+    UINT32      lineShift;
+    CORE_STATE *cores;
+    LLC_GROUP  *llcs;
+    UINT32      inclusion;      // the LLCs' LLCInclusion
+    STACK_PROFILER *profiler;   // optional, sees the same LLC references
+    OPT_INDEX_WRITER *recorder; // optional, records the LLC references for OPT
+    LLC_FILTER_WRITER *filter;  // optional, writes the LLC references to a filtered trace
+    INTERVAL_SAMPLER *sampler;  // optional, samples the LLCs every interval
+
+    // Instructions and LLC references to the next sample, the one not
+    // counted in never runs out
+    long long   sampleInstrLeft;
+    long long   sampleRefsLeft;
+
+    // Replaying a filtered trace: the upper levels are not simulated and
+    // their statistics come from the trace
+    const string *upperStats;
+
+  public:
+
+    MEMORY_HIERARCHY( UINT32 _cores, LLC_GROUP *_llcs, UINT32 _linesize=64 );
+
+    // n instructions retire from the current fetch line
+    inline void Retire( UINT32 tid, UINT32 n );
+    void        Fetch( UINT32 tid, Addr_t line ) 
+    {
+        cores[ tid ].fetchLine  = line;
+        cores[ tid ].fetchValid = true;
+    }
+    void        DataAccess( UINT32 tid, Addr_t PC, Addr_t addr, UINT32 accessType );
+
+    void        SetProfiler( STACK_PROFILER *_profiler ) { profiler = _profiler; }
+    void        SetRecorder( OPT_INDEX_WRITER *_recorder ) { recorder = _recorder; }
+    void        SetFilter( LLC_FILTER_WRITER *_filter ) { filter = _filter; }
+    void        SetTiming( UINT32 tid, OOO_CORE *ooo ) { cores[ tid ].ooo = ooo; }
+    void        SetSampler( INTERVAL_SAMPLER *_sampler );
+
+    // Runs the out-of-order models up to the last instruction retired and
+    // writes the sampler's last interval, false if the sampler failed
+    bool        Finish();
+
+    // A reference of a filtered trace goes straight to the LLCs
+    void        ReplayLLC( const LLC_REF *ref ) 
+    {
+        AccessLLC( ref->tid, ref->PC, ref->paddr, ref->accessType, ref->blocking );
+    }
+
+    void        Summarize( LLC_FILTER_SUMMARY *summary );
+    void        SetUpperLevels( const LLC_FILTER_SUMMARY *summary );
+
+    COUNTER     Instructions( UINT32 tid ) { return cores[ tid ].instructions; }
+    // With a DRAM model the stalls of the reads a core waited on replace
+    // MEM_LATENCY per blocking miss
+    COUNTER     Cycles( UINT32 tid, UINT32 llc=0 )
+    {
+        DRAM_MODEL *dram = llcs->DRAM( llc );
+
+        return cores[ tid ].cycles + (dram ? dram->Stall( tid ) : MEM_LATENCY * llcs->BlockingMisses( tid, llc ));
+    }
+    UINT32      NumCores() { return numCores; }
+    UINT32      NumLLCs() { return llcs ? llcs->NumLLCs() : 0; }
+
+    ostream &   PrintStats( ostream &out );
+
+  private:
+
+    ostream &   PrintComparison( ostream &out );
+    ostream &   PrintUpperLevels( ostream &out );
+    ostream &   PrintInclusion( ostream &out );
+    ostream &   PrintTiming( ostream &out );
+
+    UINT32      AccessMLC( UINT32 tid, Addr_t PC, Addr_t addr, UINT32 accessType );
+
+    void        BackInvalidate();
+    void        SampleInterval();
+
+    // The latency of the blocking access just made under every LLC
+    // instance, from its latency down to the LLC
+    void        Latencies( UINT32 latency, UINT32 *latencies )
+    {
+        UINT32 missMask = (latency > MLC_LATENCY) ? llcs->BlockingMissMask() : 0;
+
+        for(UINT32 i=0; i<llcs->NumLLCs(); i++) 
+        {
+            latencies[i] = latency;
+
+            if( missMask & (1u << i) ) 
+            {
+                latencies[i] += llcs->DRAM(i) ? llcs->ReadLatency(i) : MEM_LATENCY;
+            }
+        }
+    }
+
+    void        AccessLLC( UINT32 tid, Addr_t PC, Addr_t addr, UINT32 accessType, bool blocking )
+    {
+        if( llcs ) llcs->Access( tid, PC, addr, accessType, blocking, cores[ tid ].cycles );
+        if( inclusion == LLC_INCLUSIVE ) BackInvalidate();
+
+        if( profiler ) profiler->Access( addr, accessType );
+        if( recorder ) recorder->Add( addr >> lineShift );
+        if( filter ) filter->Add( tid, PC, addr, accessType );
+
+        if( --sampleRefsLeft <= 0 ) SampleInterval();
+    }
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Every instruction is one IL1 access to the current fetch line. After the   //
+// first access the line is MRU, so the remaining n-1 accesses are hits       //
+// that do not change any state and are only counted. An IL1 miss stalls the  //
+// out-of-order model at the first of the n instructions.                     //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+inline void MEMORY_HIERARCHY::Retire( UINT32 tid, UINT32 n )
+{
+    CORE_STATE *core = &cores[ tid ];
+
+    if( n == 0 ) return;
+
+    core->instructions += n;
+    core->cycles       += n;
+
+    if( core->fetchValid ) 
+    {
+        HIER_VICTIM victim;
+
+        if( !core->il1->Access( core->fetchLine, ACCESS_IFETCH, &victim ) ) 
+        {
+            UINT32 latency = AccessMLC( tid, core->fetchLine, core->fetchLine, ACCESS_IFETCH );
+
+            core->cycles += latency;
+
+            if( core->ooo ) 
+            {
+                UINT32 latencies[ LLC_GROUP_MAX ];
+
+                Latencies( latency, latencies );
+                core->ooo->AddFetch( core->instructions - n, latencies );
+            }
+        }
+
+        core->il1->CountHits( ACCESS_IFETCH, n-1 );
+    }
+
+    if( core->ooo ) 
+    {
+        core->ooo->Advance( core->instructions );
+    }
+
+    if( (sampleInstrLeft -= n) <= 0 ) SampleInterval();
+}
+
+#endif
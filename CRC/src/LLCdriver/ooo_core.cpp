@@ -0,0 +1,251 @@
+#include "ooo_core.h"
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Out-of-order core timing from the dependency file (see ooo_core.h).        //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+OOO_CORE::OOO_CORE( UINT32 _numLLCs, UINT32 _rob, UINT32 _width )
+{
+    assert( _numLLCs > 0 && _numLLCs <= LLC_GROUP_MAX );
+    assert( _width > 0 && _width <= OOO_MAX_WIDTH && _rob >= _width && _rob <= OOO_MAX_ROB );
+
+    numLLCs = _numLLCs;
+    rob     = _rob;
+    width   = _width;
+
+    instructions = 0;
+    rewinds      = 0;
+
+    loads.ring     = (OOO_EVENT *) CRC_AlignedCalloc( OOO_QUEUE_SIZE, sizeof(OOO_EVENT) );
+    loads.head     = 0;
+    loads.tail     = 0;
+    fetches.ring   = (OOO_EVENT *) CRC_AlignedCalloc( OOO_QUEUE_SIZE, sizeof(OOO_EVENT) );
+    fetches.head   = 0;
+    fetches.tail   = 0;
+    timing         = (OOO_TIMING *) CRC_AlignedCalloc( numLLCs, sizeof(OOO_TIMING) );
+    predictor      = (UINT8 *) CRC_AlignedCalloc( OOO_BP_ENTRIES, sizeof(UINT8) );
+
+    assert( loads.ring && fetches.ring && timing && predictor );
+
+    // weakly not taken
+    memset( predictor, 1, OOO_BP_ENTRIES );
+
+    matched     = 0;
+    unmatched   = 0;
+    branches    = 0;
+    mispredicts = 0;
+}
+
+OOO_CORE::~OOO_CORE()
+{
+    free( loads.ring );
+    free( fetches.ring );
+    free( timing );
+    free( predictor );
+}
+
+bool OOO_CORE::Open( const char *depName )
+{
+    return dep.Open( depName );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Models the instructions up to until. A dependency file that ends first     //
+// starts over, as the trace does with -autorewind; an empty one leaves the   //
+// rest as independent ALU instructions.                                      //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+void OOO_CORE::Run( COUNTER until )
+{
+    DEP_RECORD rec;
+
+    while( instructions < until )
+    {
+        if( !dep.Next( &rec ) )
+        {
+            if( dep.Instructions() && dep.Rewind() && dep.Next( &rec ) )
+            {
+                rewinds++;
+            }
+            else
+            {
+                rec.type    = DEP_ALU;
+                rec.numSrcs = 0;
+                rec.PC      = 0;
+            }
+        }
+
+        Step( &rec );
+        instructions++;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Runs instruction number instructions through the pipeline of every         //
+// instance. Its fetch misses, if any, apply first and its load takes the     //
+// next queued load within reach.                                             //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+void OOO_CORE::Step( const DEP_RECORD *rec )
+{
+    COUNTER          k    = instructions;
+    const OOO_EVENT *load = NULL;
+
+    for(; fetches.head != fetches.tail; fetches.head++)
+    {
+        const OOO_EVENT *fetch = &fetches.ring[ fetches.head & (OOO_QUEUE_SIZE - 1) ];
+
+        if( fetch->index > k ) break;
+
+        for(UINT32 i=0; i<numLLCs; i++)
+        {
+            OOO_TIMING *t     = &timing[i];
+            COUNTER     ready = t->dispatchCycle + fetch->latency[i];
+
+            if( ready > t->redirect ) t->redirect = ready;
+        }
+    }
+
+    for(; loads.head != loads.tail; loads.head++)
+    {
+        if( loads.ring[ loads.head & (OOO_QUEUE_SIZE - 1) ].index + OOO_MATCH_SLACK >= k ) break;
+
+        unmatched++;
+    }
+
+    if( rec->type == DEP_LOAD && loads.head != loads.tail
+        && loads.ring[ loads.head & (OOO_QUEUE_SIZE - 1) ].index <= k + OOO_MATCH_SLACK )
+    {
+        // Not overwritten before the next Push
+        load = &loads.ring[ loads.head++ & (OOO_QUEUE_SIZE - 1) ];
+        matched++;
+    }
+
+    bool mispredict = (rec->type == DEP_TAKEN || rec->type == DEP_NOT_TAKEN) && !Predict( rec );
+
+    for(UINT32 i=0; i<numLLCs; i++)
+    {
+        OOO_TIMING *t        = &timing[i];
+        COUNTER     dispatch = (t->redirect > t->dispatchCycle) ? t->redirect : t->dispatchCycle;
+
+        // Room in the ROB
+        if( k >= rob && t->retired[ (k - rob) & (OOO_MAX_ROB - 1) ] > dispatch )
+        {
+            dispatch = t->retired[ (k - rob) & (OOO_MAX_ROB - 1) ];
+        }
+
+        if( dispatch > t->dispatchCycle )
+        {
+            t->dispatchCycle = dispatch;
+            t->dispatched    = 0;
+        }
+        else if( t->dispatched == width )
+        {
+            t->dispatchCycle++;
+            t->dispatched = 0;
+        }
+
+        t->dispatched++;
+
+        COUNTER issue = t->dispatchCycle + 1;
+
+        for(UINT32 s=0; s<rec->numSrcs; s++)
+        {
+            UINT32 distance = rec->srcs[s];
+
+            if( distance == 0 || distance > k || distance >= OOO_DEP_WINDOW ) continue;
+
+            COUNTER ready = t->done[ (k - distance) & (OOO_DEP_WINDOW - 1) ];
+
+            if( ready > issue ) issue = ready;
+        }
+
+        UINT32 latency = 1;
+
+        if( rec->type == DEP_LOAD )
+        {
+            latency = OOO_L1_LATENCY + (load ? load->latency[i] : 0);
+        }
+
+        COUNTER complete = issue + latency;
+
+        t->done[ k & (OOO_DEP_WINDOW - 1) ] = complete;
+
+        if( load && (load->missMask & (1u << i)) )
+        {
+            t->llcMisses++;
+            t->missCycles += latency;
+
+            if( issue >= t->missUntil )          t->missCovered += latency;
+            else if( complete > t->missUntil )   t->missCovered += complete - t->missUntil;
+
+            if( complete > t->missUntil ) t->missUntil = complete;
+        }
+
+        // In order, width per cycle
+        if( complete > t->retireCycle )
+        {
+            t->retireCycle = complete;
+            t->retiredNow  = 0;
+        }
+        else if( t->retiredNow == width )
+        {
+            t->retireCycle++;
+            t->retiredNow = 0;
+        }
+
+        t->retiredNow++;
+        t->retired[ k & (OOO_MAX_ROB - 1) ] = t->retireCycle;
+
+        if( mispredict && complete + OOO_MISPREDICT > t->redirect )
+        {
+            t->redirect = complete + OOO_MISPREDICT;
+        }
+    }
+}
+
+// Bimodal prediction and update, true if the branch was predicted right
+bool OOO_CORE::Predict( const DEP_RECORD *rec )
+{
+    UINT8 *counter = &predictor[ CRC_Mix64( rec->PC ) & (OOO_BP_ENTRIES - 1) ];
+    bool   taken   = (rec->type == DEP_TAKEN);
+    bool   right   = ((*counter >= 2) == taken);
+
+    if( taken && *counter < 3 )   (*counter)++;
+    if( !taken && *counter > 0 )  (*counter)--;
+
+    branches++;
+    mispredicts += !right;
+
+    return right;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// The thread's loads and branches, then per LLC instance its cycles and      //
+// IPC, the loads that missed the instance and their MLP.                     //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+ostream & OOO_CORE::PrintStats( ostream &out, UINT32 tid, LLC_GROUP *llcs )
+{
+    out<<"\tThread: "<<tid<<" Instructions: "<<instructions<<" Matched Loads: "<<matched
+       <<" Unmatched Loads: "<<unmatched<<" Branches: "<<branches<<" Mispredicts: "<<mispredicts
+       <<" Dependency Rewinds: "<<rewinds<<endl;
+
+    for(UINT32 i=0; i<numLLCs; i++)
+    {
+        OOO_TIMING *t = &timing[i];
+
+        out<<"\t\tLLC "<<i<<": "<<llcs->Name(i)<<" Cycles: "<<t->retireCycle
+           <<" IPC: "<<(t->retireCycle ? (double)instructions/(double)t->retireCycle : 0.0)
+           <<" LLC Load Misses: "<<t->llcMisses
+           <<" MLP: "<<(t->missCovered ? (double)t->missCycles/(double)t->missCovered : 0.0)<<endl;
+    }
+
+    return out;
+}
@@ -0,0 +1,166 @@
+#ifndef OOO_CORE_H
+#define OOO_CORE_H
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// An out-of-order core timing model driven by the dependency file of a       //
+// trace (see dep_reader.h), with one timing state per LLC instance so every  //
+// instance gets the cycles of a core that overlaps its independent misses.   //
+//                                                                            //
+// Instructions dispatch in order, up to width per cycle, once the            //
+// instruction rob places ahead has retired and fetch is not redirected.      //
+// Each issues the cycle after dispatch or when its last producer completes,  //
+// whichever is later, and completes after its latency: one cycle, or for a   //
+// load the DL1 hit latency plus the latency the hierarchy measured for it    //
+// under that instance. Instructions retire in order, up to width per cycle,  //
+// once complete. A branch the bimodal predictor gets wrong holds dispatch    //
+// until OOO_MISPREDICT cycles after it completes, and an IL1 miss holds it   //
+// for the fetch latency. Issue ports are not modelled.                       //
+//                                                                            //
+// The hierarchy queues the latencies of the loads that miss the DL1 and of   //
+// the fetches that miss the IL1, each at the index of its instruction in     //
+// the trace. Fetches take effect at their index. The trace and the           //
+// dependency file count instructions alike but place a load only within a    //
+// few instructions of each other, so a load of the dependency file takes     //
+// the next queued load within OOO_MATCH_SLACK instructions of it, and counts //
+// as a DL1 hit if there is none; queued loads that no load took by then are  //
+// dropped as unmatched. The model runs OOO_LAG instructions behind the       //
+// hierarchy so the loads are queued before it gets to them.                  //
+//                                                                            //
+// MLP is the average number of LLC-missing loads in flight while at least    //
+// one is: their summed latency over the cycles their intervals cover.        //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#include <cassert>
+#include "utils.h"
+#include "dep_reader.h"
+#include "llc_group.h"
+
+#define OOO_MAX_ROB         512
+#define OOO_MAX_WIDTH       16
+#define OOO_DEP_WINDOW      1024    // producers further back are complete
+#define OOO_QUEUE_SIZE      1024    // queued loads and fetches, each
+#define OOO_LAG             64      // instructions behind the hierarchy
+#define OOO_MATCH_SLACK     32
+#define OOO_L1_LATENCY      4
+#define OOO_MISPREDICT      14
+#define OOO_BP_ENTRIES      4096    // 2-bit counters
+
+// A load or fetch the hierarchy timed, per LLC instance
+typedef struct
+{
+    COUNTER     index;
+    UINT32      missMask;       // instances it missed in
+    UINT32      latency[ LLC_GROUP_MAX ];
+} OOO_EVENT;
+
+typedef struct
+{
+    OOO_EVENT  *ring;
+    COUNTER     head;
+    COUNTER     tail;
+} OOO_QUEUE;
+
+// The pipeline under one LLC instance
+typedef struct
+{
+    COUNTER     done[ OOO_DEP_WINDOW ];     // completion cycle, by instruction
+    COUNTER     retired[ OOO_MAX_ROB ];     // retire cycle, by instruction
+
+    COUNTER     dispatchCycle;
+    UINT32      dispatched;     // ... in that cycle
+    COUNTER     retireCycle;
+    UINT32      retiredNow;     // ... in that cycle
+    COUNTER     redirect;       // no dispatch before
+
+    COUNTER     llcMisses;      // loads that missed the instance
+    COUNTER     missCycles;     // their summed latency
+    COUNTER     missCovered;    // cycles with one in flight
+    COUNTER     missUntil;
+} OOO_TIMING;
+
+class OOO_CORE
+{
+  private:
+
+    UINT32      numLLCs;
+    UINT32      rob;
+    UINT32      width;
+
+    DEP_READER  dep;
+    COUNTER     instructions;   // modelled
+    COUNTER     rewinds;        // of the dependency file
+
+    OOO_QUEUE   loads;
+    OOO_QUEUE   fetches;
+    OOO_TIMING *timing;         // per instance
+    UINT8      *predictor;
+
+    COUNTER     matched;
+    COUNTER     unmatched;
+    COUNTER     branches;
+    COUNTER     mispredicts;
+
+  public:
+
+    OOO_CORE( UINT32 _numLLCs, UINT32 _rob, UINT32 _width );
+    ~OOO_CORE();
+
+    bool        Open( const char *depName );
+
+    // Queues a timed load or fetch of instruction index
+    inline void AddLoad( COUNTER index, UINT32 missMask, const UINT32 *latency )
+    {
+        Push( &loads, index, missMask, latency );
+    }
+    inline void AddFetch( COUNTER index, const UINT32 *latency )
+    {
+        Push( &fetches, index, 0, latency );
+    }
+
+    // The hierarchy has run up to instruction count retired
+    inline void Advance( COUNTER retired )
+    {
+        if( retired > instructions + OOO_LAG )
+        {
+            Run( retired - OOO_LAG );
+        }
+    }
+    // ... and stopped there
+    void        Finish( COUNTER retired ) { Run( retired ); }
+
+    UINT32      Rob() { return rob; }
+    UINT32      Width() { return width; }
+    COUNTER     Instructions() { return instructions; }
+    COUNTER     Cycles( UINT32 i ) { return timing[i].retireCycle; }
+
+    ostream &   PrintStats( ostream &out, UINT32 tid, LLC_GROUP *llcs );
+
+  private:
+
+    void        Run( COUNTER until );
+    void        Step( const DEP_RECORD *rec );
+    bool        Predict( const DEP_RECORD *rec );
+
+    inline void Push( OOO_QUEUE *queue, COUNTER index, UINT32 missMask, const UINT32 *latency );
+};
+
+inline void OOO_CORE::Push( OOO_QUEUE *queue, COUNTER index, UINT32 missMask, const UINT32 *latency )
+{
+    // Everything queued is at most OOO_LAG + OOO_MATCH_SLACK instructions old
+    assert( queue->tail - queue->head < OOO_QUEUE_SIZE );
+
+    OOO_EVENT *event = &queue->ring[ queue->tail++ & (OOO_QUEUE_SIZE - 1) ];
+
+    event->index    = index;
+    event->missMask = missMask;
+
+    for(UINT32 i=0; i<numLLCs; i++)
+    {
+        event->latency[i] = latency[i];
+    }
+}
+
+#endif
@@ -0,0 +1,386 @@
+#include <iomanip>
+#include "stack_profiler.h"
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Mattson stack-distance profiler (see stack_profiler.h).                    //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#define STACK_INITIAL_SLOTS  8
+#define STACK_INITIAL_LINES  (1 << 16)
+
+// Adds delta to time slot slot
+static inline void FenwickAdd( UINT32 *tree, UINT32 capacity, UINT32 slot, INT32 delta )
+{
+    for(UINT32 i=slot+1; i<=capacity; i += i & (0-i))
+    {
+        tree[i] += delta;
+    }
+}
+
+// Number of marks in time slots [0, slots)
+static inline UINT32 FenwickPrefix( const UINT32 *tree, UINT32 slots )
+{
+    UINT32 sum = 0;
+
+    for(UINT32 i=slots; i>0; i -= i & (0-i))
+    {
+        sum += tree[i];
+    }
+
+    return sum;
+}
+
+STACK_PROFILER::STACK_PROFILER( UINT32 _linesize, UINT32 _maxSets, UINT32 _maxAssoc, double _sampleRate )
+{
+    // The miss ratio table walks powers of two
+    assert( _maxSets && (_maxSets & (_maxSets-1)) == 0 );
+    assert( _maxAssoc && (_maxAssoc & (_maxAssoc-1)) == 0 );
+    assert( _sampleRate > 0.0 && _sampleRate <= 1.0 );
+    assert( _maxSets <= (1U << 31) );
+
+    linesize   = _linesize;
+    lineShift  = CRC_FloorLog2( linesize );
+    maxAssoc   = _maxAssoc;
+    numSchemes = CRC_FloorLog2( _maxSets ) + 1;
+
+    sampleRate = _sampleRate;
+    references = 0;
+
+    schemes = new STACK_SCHEME[ numSchemes ];
+
+    for(UINT32 k=0; k<numSchemes; k++)
+    {
+        STACK_SCHEME *scheme = &schemes[k];
+
+        scheme->numsets   = 1 << k;
+        scheme->indexMask = scheme->numsets - 1;
+
+        // The fully associative stack keeps every line for the fully
+        // associative column; set-associative stacks only need maxAssoc
+        scheme->depthCap  = (k == 0) ? STACK_EMPTY_TIME : maxAssoc;
+
+        // Sets get their time slots on first use
+        scheme->sets  = (STACK_SET *) calloc( scheme->numsets, sizeof(STACK_SET) );
+        scheme->exact = (COUNTER *) calloc( maxAssoc, sizeof(COUNTER) );
+
+        // Set-associative schemes sample at least STACK_MIN_SAMPLED_SETS
+        // sets, or all of them
+        scheme->sampleRate = sampleRate;
+
+        if( k > 0 && scheme->sampleRate * scheme->numsets < STACK_MIN_SAMPLED_SETS )
+        {
+            scheme->sampleRate = (double) STACK_MIN_SAMPLED_SETS / scheme->numsets;
+            if( scheme->sampleRate > 1.0 ) scheme->sampleRate = 1.0;
+        }
+
+        scheme->sampleThreshold = (Addr_t) (scheme->sampleRate * (1ULL << STACK_SAMPLE_BITS));
+        scheme->sampled         = 0;
+
+        memset( scheme->log2Hist, 0, sizeof(scheme->log2Hist) );
+
+        assert( scheme->sets && scheme->exact );
+    }
+
+    mapCapacity = STACK_INITIAL_LINES;
+    mapCount    = 0;
+    mapLines    = (Addr_t *) malloc( mapCapacity * sizeof(Addr_t) );
+    mapTimes    = (UINT32 *) malloc( (size_t) mapCapacity * numSchemes * sizeof(UINT32) );
+
+    assert( mapLines && mapTimes );
+
+    memset( mapLines, 0xff, mapCapacity * sizeof(Addr_t) );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Returns the row of last access times of line, one per scheme. A line       //
+// seen for the first time is inserted with no times when insert is set.      //
+// @returns NULL if the line is unknown and insert is not set.                //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+UINT32 * STACK_PROFILER::FindLine( Addr_t line, bool insert )
+{
+    UINT32 mask = mapCapacity - 1;
+    UINT32 slot = CRC_Mix64( line ) & mask;
+
+    while( mapLines[ slot ] != line )
+    {
+        if( mapLines[ slot ] == STACK_EMPTY_LINE )
+        {
+            if( !insert ) return NULL;
+
+            // Keep the map at most half full
+            if( 2 * (mapCount + 1) > mapCapacity )
+            {
+                GrowMap();
+                return FindLine( line, insert );
+            }
+
+            mapLines[ slot ] = line;
+            mapCount++;
+
+            memset( &mapTimes[ (size_t) slot * numSchemes ], 0xff, numSchemes * sizeof(UINT32) );
+            break;
+        }
+
+        slot = (slot + 1) & mask;
+    }
+
+    return &mapTimes[ (size_t) slot * numSchemes ];
+}
+
+void STACK_PROFILER::GrowMap()
+{
+    Addr_t *oldLines    = mapLines;
+    UINT32 *oldTimes    = mapTimes;
+    UINT32  oldCapacity = mapCapacity;
+
+    mapCapacity *= 2;
+    mapCount     = 0;
+    mapLines     = (Addr_t *) malloc( mapCapacity * sizeof(Addr_t) );
+    mapTimes     = (UINT32 *) malloc( (size_t) mapCapacity * numSchemes * sizeof(UINT32) );
+
+    assert( mapLines && mapTimes );
+
+    memset( mapLines, 0xff, mapCapacity * sizeof(Addr_t) );
+
+    for(UINT32 slot=0; slot<oldCapacity; slot++)
+    {
+        if( oldLines[ slot ] == STACK_EMPTY_LINE ) continue;
+
+        memcpy( FindLine( oldLines[ slot ], true ), &oldTimes[ (size_t) slot * numSchemes ],
+                numSchemes * sizeof(UINT32) );
+    }
+
+    free( oldLines );
+    free( oldTimes );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Called when a set has used all of its time slots. Renumbers the marked     //
+// lines to the first slots in stack order, keeping at most depthCap of the   //
+// most recent ones. A dropped line keeps a stale time in the map; its next   //
+// access finds another line (or no line) in that slot and counts as a        //
+// reference beyond the stack. The set doubles its slots when more than       //
+// half of them stay marked.                                                  //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+void STACK_PROFILER::CompactSet( UINT32 k, STACK_SET *set )
+{
+    UINT32 depthCap = schemes[k].depthCap;
+    UINT32 keep     = (set->live < depthCap) ? set->live : depthCap;
+    UINT32 drop     = set->live - keep;
+    UINT32 next     = 0;
+
+    for(UINT32 t=0; t<set->now; t++)
+    {
+        Addr_t line = set->lineAt[t];
+
+        if( line == STACK_EMPTY_LINE ) continue;
+
+        if( drop )
+        {
+            drop--;
+            continue;
+        }
+
+        UINT32 *times = FindLine( line, false );
+        assert( times );
+
+        set->lineAt[ next ] = line;
+        times[k] = next++;
+    }
+
+    if( 2 * keep >= set->capacity )
+    {
+        set->capacity = set->capacity ? 2 * set->capacity : STACK_INITIAL_SLOTS;
+        set->lineAt   = (Addr_t *) realloc( set->lineAt, set->capacity * sizeof(Addr_t) );
+        set->tree     = (UINT32 *) realloc( set->tree, (set->capacity + 1) * sizeof(UINT32) );
+
+        assert( set->lineAt && set->tree );
+    }
+
+    for(UINT32 t=keep; t<set->capacity; t++)
+    {
+        set->lineAt[t] = STACK_EMPTY_LINE;
+    }
+
+    // Fenwick tree with the first keep slots marked: node i covers the
+    // slots (i - lowbit(i), i]
+    for(UINT32 i=1; i<=set->capacity; i++)
+    {
+        UINT32 low  = i - (i & (0-i));
+        UINT32 high = (i < keep) ? i : keep;
+
+        set->tree[i] = (high > low) ? high - low : 0;
+    }
+
+    set->now  = keep;
+    set->live = keep;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Moves line to the top of its set's stack in every scheme that samples     //
+// it. For demand references the depth it was found at, scaled in the         //
+// line-sampled fully associative stack, is added to the scheme's histograms. //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+void STACK_PROFILER::Profile( Addr_t line, bool demand )
+{
+    UINT32 selected = 0;   // schemes that sample line, bit k for scheme k
+    double scale    = 1.0 / sampleRate;
+
+    for(UINT32 k=0; k<numSchemes; k++)
+    {
+        if( schemes[k].sampleRate >= 1.0 || Sampled( k, line ) )
+        {
+            selected |= 1U << k;
+        }
+    }
+
+    if( selected == 0 ) return;
+
+    UINT32 *times = FindLine( line, true );
+
+    for(UINT32 k=0; k<numSchemes; k++)
+    {
+        if( !(selected & (1U << k)) ) continue;
+
+        STACK_SCHEME *scheme = &schemes[k];
+        STACK_SET    *set    = &scheme->sets[ line & scheme->indexMask ];
+        UINT32        t      = times[k];
+
+        scheme->sampled += demand;
+
+        if( t < set->now && set->lineAt[t] == line )
+        {
+            // Lines marked after t are the lines above it in the stack
+            Addr_t distance = set->live - FenwickPrefix( set->tree, t+1 );
+
+            set->lineAt[t] = STACK_EMPTY_LINE;
+            FenwickAdd( set->tree, set->capacity, t, -1 );
+            set->live--;
+
+            if( demand )
+            {
+                if( k == 0 && sampleRate < 1.0 ) distance = (Addr_t) (distance * scale);
+
+                if( distance < maxAssoc ) scheme->exact[ distance ]++;
+                scheme->log2Hist[ distance ? 64 - __builtin_clzll( distance ) : 0 ]++;
+            }
+        }
+
+        if( set->now == set->capacity )
+        {
+            CompactSet( k, set );
+        }
+
+        set->lineAt[ set->now ] = line;
+        FenwickAdd( set->tree, set->capacity, set->now, 1 );
+        times[k] = set->now++;
+        set->live++;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Demand miss ratio of an LRU cache with 2^k sets and assoc ways, estimated  //
+// from the references to the sampled sets (all sets without sampling).       //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+double STACK_PROFILER::MissRatio( UINT32 k, UINT32 assoc )
+{
+    double hits  = 0.0;
+    double total = schemes[k].sampled;
+
+    for(UINT32 d=0; d<assoc; d++)
+    {
+        hits += schemes[k].exact[d];
+    }
+
+    return (total > 0.0) ? 1.0 - hits / total : 0.0;
+}
+
+// Demand miss ratio of a fully associative LRU cache of lines lines
+double STACK_PROFILER::FullyAssocMissRatio( UINT32 lines )
+{
+    double hits  = 0.0;
+    double total = schemes[0].sampled;
+    UINT32 log2  = CRC_FloorLog2( lines );
+
+    for(UINT32 b=0; b<=log2; b++)
+    {
+        hits += schemes[0].log2Hist[b];
+    }
+
+    return (total > 0.0) ? 1.0 - hits / total : 0.0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Prints the demand miss ratio of every power-of-two cache size and          //
+// associativity the profile covers. A cache of S sets needs S <= maxSets.    //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+ostream & STACK_PROFILER::PrintStats( ostream &out )
+{
+    UINT32 maxSets  = 1 << (numSchemes - 1);
+    UINT32 minLines = (16 * 1024) / linesize;
+    UINT32 maxLines = maxSets * maxAssoc;
+
+    if( minLines > maxLines ) minLines = maxLines;
+
+    out<<endl;
+    out<<"LLC Stack Distance Profile: "<<endl;
+    out<<"\tLine Size:          "<<linesize<<"B"<<endl;
+    out<<"\tMax Sets:           "<<maxSets<<endl;
+    out<<"\tMax Associativity:  "<<maxAssoc<<endl;
+    out<<"\tSample Rate:        "<<sampleRate<<endl;
+    out<<"\tDemand References:  "<<references<<endl;
+    out<<"\tSampled References: "<<schemes[0].sampled<<" (fully associative)"<<endl;
+    out<<"\tDistinct Lines:     "<<mapCount<<endl;
+    out<<endl;
+
+    out<<"LLC Demand Miss Rate by Size and Associativity: "<<endl;
+    out<<setw(10)<<"Size";
+
+    for(UINT32 assoc=1; assoc<=maxAssoc; assoc*=2)
+    {
+        out<<setw(9)<<assoc;
+    }
+
+    out<<setw(9)<<"full"<<endl;
+
+    for(UINT32 lines=minLines; lines<=maxLines; lines*=2)
+    {
+        ostringstream size;
+        size<<(COUNTER) lines * linesize / 1024<<"K";
+
+        out<<setw(10)<<size.str()<<fixed<<setprecision(2);
+
+        for(UINT32 assoc=1; assoc<=maxAssoc; assoc*=2)
+        {
+            UINT32 sets = lines / assoc;
+
+            if( sets == 0 || sets > maxSets )
+            {
+                out<<setw(9)<<"-";
+                continue;
+            }
+
+            out<<setw(9)<<MissRatio( CRC_FloorLog2( sets ), assoc ) * 100.0;
+        }
+
+        out<<setw(9)<<FullyAssocMissRatio( lines ) * 100.0<<endl;
+
+        out.unsetf( ios::floatfield );
+        out<<setprecision(6);
+    }
+
+    return out;
+}
@@ -0,0 +1,128 @@
+#ifndef STACK_PROFILER_H
+#define STACK_PROFILER_H
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Mattson stack-distance profiler for the LLC reference stream. For every    //
+// power-of-two number of sets (1 = fully associative) it keeps the LRU       //
+// stack of each set, and records the stack distance of every demand          //
+// reference. A reference hits in an LRU cache of S sets and A ways exactly   //
+// when its distance in the S-set scheme is below A, so one pass gives the    //
+// miss ratio of every cache size and associativity.                          //
+//                                                                            //
+// Each set keeps its stack as access times: a line is marked at the time     //
+// of its last access and its stack distance is the number of marks after     //
+// that time, counted with a Fenwick tree. Sets grow on demand and are        //
+// compacted when they run out of time slots; lines deeper than any           //
+// profiled associativity are dropped at compaction.                          //
+//                                                                            //
+// With a sample rate below 1 the fully associative stack only profiles      //
+// lines whose address hash falls under a threshold (SHARDS spatial           //
+// sampling) and scales their distances by 1/rate. A set-associative stack    //
+// cannot be scaled that way, its sampled depth is far below one way, so      //
+// the set-associative schemes sample whole sets instead: the distances in    //
+// a sampled set are exact and the miss ratio is estimated from the sampled   //
+// sets. Every scheme samples at least STACK_MIN_SAMPLED_SETS sets.           //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#include <cassert>
+#include "utils.h"
+#include "crc_cache_defs.h"
+
+#define STACK_EMPTY_LINE   (~0ULL)
+#define STACK_EMPTY_TIME   (~0U)
+#define STACK_LOG2_BUCKETS 65
+#define STACK_SAMPLE_BITS  24
+#define STACK_MIN_SAMPLED_SETS 64
+
+// LRU stack of one set
+typedef struct
+{
+    UINT32  *tree;       // Fenwick tree over time slots, 1-indexed
+    Addr_t  *lineAt;     // line marked at each time slot
+    UINT32   capacity;   // time slots
+    UINT32   now;        // next time slot
+    UINT32   live;       // marked slots
+} STACK_SET;
+
+// All sets of one set-indexing scheme and its distance histograms
+typedef struct
+{
+    UINT32     numsets;
+    UINT32     indexMask;
+    UINT32     depthCap;     // stack depth kept at compaction
+    STACK_SET *sets;
+
+    // Lines (fully associative) or sets (set-associative) whose hash is
+    // below sampleThreshold are profiled
+    double     sampleRate;
+    Addr_t     sampleThreshold;
+    COUNTER    sampled;      // demand references profiled
+
+    COUNTER   *exact;                          // distances below maxAssoc
+    COUNTER    log2Hist[ STACK_LOG2_BUCKETS ]; // bucket b: distances < 2^b and >= 2^(b-1)
+} STACK_SCHEME;
+
+class STACK_PROFILER
+{
+  private:
+
+    UINT32        lineShift;
+    UINT32        linesize;
+    UINT32        maxAssoc;
+    UINT32        numSchemes;   // 1, 2, 4, ... maxSets sets
+    STACK_SCHEME *schemes;
+
+    // Open addressing map from line to its last access time in every
+    // scheme (mapCapacity x numSchemes)
+    Addr_t       *mapLines;
+    UINT32       *mapTimes;
+    UINT32        mapCapacity;
+    UINT32        mapCount;
+
+    double        sampleRate;
+    COUNTER       references;   // demand references seen
+
+  public:
+
+    STACK_PROFILER( UINT32 _linesize, UINT32 _maxSets, UINT32 _maxAssoc, double _sampleRate=1.0 );
+
+    inline void Access( Addr_t paddr, UINT32 accessType );
+
+    ostream &   PrintStats( ostream &out );
+
+  private:
+
+    void        Profile( Addr_t line, bool demand );
+    UINT32 *    FindLine( Addr_t line, bool insert );
+    void        GrowMap();
+    void        CompactSet( UINT32 k, STACK_SET *set );
+    bool        Sampled( UINT32 k, Addr_t line )
+    {
+        Addr_t key = k ? (line & schemes[k].indexMask) : line;
+
+        return (CRC_Mix64( key ) & ((1ULL << STACK_SAMPLE_BITS) - 1)) < schemes[k].sampleThreshold;
+    }
+
+    double      MissRatio( UINT32 k, UINT32 assoc );
+    double      FullyAssocMissRatio( UINT32 lines );
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Takes one LLC reference. Writebacks update the stacks like the fills       //
+// they cause in the LLC but are not part of the demand miss ratio.           //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+inline void STACK_PROFILER::Access( Addr_t paddr, UINT32 accessType )
+{
+    bool demand = (accessType <= ACCESS_STORE);
+
+    references += demand;
+
+    Profile( paddr >> lineShift, demand );
+}
+
+#endif
@@ -0,0 +1,353 @@
+#include <cstdio>
+#include <iomanip>
+#include "trace_mix.h"
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Multi-programmed runs from single-thread traces (see trace_mix.h).         //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#define MIX_LINE_MAX    4096
+
+static const char *mix_schedule_names[] =
+{
+    "icount",
+    "cpi"
+};
+
+TRACE_MIX::TRACE_MIX( UINT32 _schedule, bool _autorewind )
+{
+    assert( _schedule <= MIX_SCHEDULE_CPI );
+
+    numCores   = 0;
+    haveAlone  = false;
+    schedule   = _schedule;
+    autorewind = _autorewind;
+    icount     = 0;
+}
+
+bool TRACE_MIX::ParseSchedule( const char *name, UINT32 *schedule )
+{
+    for(UINT32 s=0; s<=MIX_SCHEDULE_CPI; s++)
+    {
+        if( string( name ) == mix_schedule_names[s] )
+        {
+            *schedule = s;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void TRACE_MIX::InitCore( MIX_CORE *core, TRACE_READER *reader, UINT32 tid )
+{
+    core->reader       = reader;
+    core->offset       = ((Addr_t) tid << MIX_REGION_SHIFT) + (Addr_t) tid * MIX_PAGE_SKEW;
+    core->idle         = false;
+    core->reached      = false;
+    core->records      = 0;
+    core->rewinds      = 0;
+    core->instructions = 0;
+
+    for(UINT32 i=0; i<LLC_GROUP_MAX; i++)
+    {
+        core->cycles[i] = 0;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Reads the trace paths of the mix, one per line with surrounding blanks     //
+// stripped, and opens every trace.                                           //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+bool TRACE_MIX::Open( const char *mixName )
+{
+    FILE *file = fopen( mixName, "r" );
+    char  line[ MIX_LINE_MAX ];
+
+    if( file == NULL )
+    {
+        cerr<<"Cannot open trace mix "<<mixName<<endl;
+        return false;
+    }
+
+    numCores = 0;
+
+    while( fgets( line, sizeof(line), file ) )
+    {
+        string path  = line;
+        size_t first = path.find_first_not_of( " \t\r\n" );
+
+        if( first == string::npos ) continue;
+
+        path = path.substr( first, path.find_last_not_of( " \t\r\n" ) - first + 1 );
+
+        if( numCores == MIX_MAX_THREADS )
+        {
+            cerr<<"Trace mix "<<mixName<<" lists more than "<<MIX_MAX_THREADS<<" traces"<<endl;
+            fclose( file );
+            return false;
+        }
+
+        traceNames[ numCores ] = path;
+
+        if( !readers[ numCores ].Open( path.c_str() ) )
+        {
+            cerr<<"Cannot open trace "<<path<<" of mix "<<mixName<<endl;
+            fclose( file );
+            return false;
+        }
+
+        InitCore( &cores[ numCores ], &readers[ numCores ], numCores );
+        numCores++;
+    }
+
+    fclose( file );
+
+    if( numCores == 0 )
+    {
+        cerr<<"Trace mix "<<mixName<<" lists no traces"<<endl;
+        return false;
+    }
+
+    return true;
+}
+
+COUNTER TRACE_MIX::Records()
+{
+    COUNTER total = 0;
+
+    for(UINT32 c=0; c<numCores; c++)
+    {
+        total += cores[c].records;
+    }
+
+    return total;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// The shared run: every core of the mix behind the hierarchy's LLCs, up to   //
+// _icount instructions per core, 0 for the end of every trace.               //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+bool TRACE_MIX::Run( MEMORY_HIERARCHY *hier, COUNTER _icount )
+{
+    assert( hier->NumCores() == numCores && hier->NumLLCs() > 0 );
+
+    icount = _icount;
+
+    return RunCores( cores, numCores, hier );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Runs n cores until each has reached its target, stepping the one furthest  //
+// behind (the lowest tid on a tie). A core whose trace ends reaches its      //
+// target there unless it still has to run up to -icount; it then starts      //
+// over with -autorewind, and idles otherwise. Stops at once, returning       //
+// false, if a trace fails to read.                                           //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+bool TRACE_MIX::RunCores( MIX_CORE *mix, UINT32 n, MEMORY_HIERARCHY *hier )
+{
+    UINT32 pending = n;
+
+    while( pending )
+    {
+        INT32   next  = -1;
+        COUNTER least = 0;
+
+        for(UINT32 c=0; c<n; c++)
+        {
+            if( mix[c].idle ) continue;
+
+            COUNTER clock = (schedule == MIX_SCHEDULE_CPI) ? hier->Cycles( c, 0 ) : hier->Instructions( c );
+
+            if( next < 0 || clock < least )
+            {
+                next  = c;
+                least = clock;
+            }
+        }
+
+        // Idle cores have all reached their target
+        assert( next >= 0 );
+
+        MIX_CORE *core = &mix[ next ];
+
+        if( !Step( core, next, hier ) )
+        {
+            if( core->reader->Failed() )
+            {
+                return false;
+            }
+
+            bool repeat = autorewind && Rewind( core );
+
+            if( !core->reached && (!icount || !repeat) )
+            {
+                Reach( core, next, hier );
+                pending--;
+            }
+
+            core->idle = !repeat;
+            continue;
+        }
+
+        if( icount && !core->reached && hier->Instructions( next ) >= icount )
+        {
+            Reach( core, next, hier );
+            pending--;
+        }
+    }
+
+    return true;
+}
+
+// Starts a trace over, unless it has no records to repeat
+bool TRACE_MIX::Rewind( MIX_CORE *core )
+{
+    if( core->reader->Records() == 0 || !core->reader->Rewind() )
+    {
+        return false;
+    }
+
+    core->rewinds++;
+
+    return true;
+}
+
+void TRACE_MIX::Reach( MIX_CORE *core, UINT32 tid, MEMORY_HIERARCHY *hier )
+{
+    core->reached      = true;
+    core->instructions = hier->Instructions( tid );
+
+    for(UINT32 i=0; i<hier->NumLLCs(); i++)
+    {
+        core->cycles[i] = hier->Cycles( tid, i );
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// After the shared run: runs every trace again on its own, as the only       //
+// core in front of fresh copies of the LLCs, to the target of the shared     //
+// run. The relocation stays that of its core, so the trace maps to the same  //
+// sets as in the mix. Diagnostics are left out of these runs.                //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+bool TRACE_MIX::RunAlone( const LLC_CONFIG *configs, UINT32 numLLCs )
+{
+    LLC_CONFIG aloneConfigs[ LLC_GROUP_MAX ];
+
+    assert( numLLCs > 0 && numLLCs <= LLC_GROUP_MAX );
+
+    for(UINT32 i=0; i<numLLCs; i++)
+    {
+        aloneConfigs[i]             = configs[i];
+        aloneConfigs[i].diagnostics = false;
+    }
+
+    for(UINT32 c=0; c<numCores; c++)
+    {
+        if( !readers[c].Open( traceNames[c].c_str() ) )
+        {
+            cerr<<"Cannot reopen trace "<<traceNames[c]<<endl;
+            return false;
+        }
+
+        LLC_GROUP        llcs( 1, numLLCs, aloneConfigs );
+        MEMORY_HIERARCHY hier( 1, &llcs, configs[0].linesize );
+
+        InitCore( &alone[c], &readers[c], c );
+
+        if( !RunCores( &alone[c], 1, &hier ) )
+        {
+            return false;
+        }
+
+        llcs.Finish();
+    }
+
+    haveAlone = true;
+
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Per LLC instance and core, the IPC at the target alone and in the mix and  //
+// the slowdown (alone over shared IPC). Over the mix, with the normalized    //
+// progress of a core its shared over alone IPC:                              //
+//                                                                            //
+//   weighted speedup   the sum of the normalized progress                    //
+//   harmonic speedup   the number of cores over the sum of the slowdowns     //
+//   max slowdown       the slowdown of the core hurt most                    //
+//   fairness           the least normalized progress over the most, 1 when   //
+//                      every core is slowed down alike                       //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+ostream & TRACE_MIX::PrintSummary( ostream &out, LLC_GROUP *llcs )
+{
+    assert( haveAlone );
+
+    out<<endl;
+    out<<"Mix Summary: "<<numCores<<" threads, "<<mix_schedule_names[ schedule ]<<" schedule, ";
+
+    if( icount ) out<<icount<<" instructions per thread"<<endl;
+    else         out<<"whole traces"<<endl;
+
+    for(UINT32 i=0; i<llcs->NumLLCs(); i++)
+    {
+        double progressSum = 0;
+        double slowdownSum = 0;
+        double maxSlowdown = 0;
+        double minProgress = 0;
+        double maxProgress = 0;
+
+        out<<"  LLC "<<i<<": "<<llcs->Name(i)<<endl;
+        out<<"  "<<setw(6)<<"Thread"<<"  "<<left<<setw(28)<<"Trace"<<right<<setw(14)<<"Instructions"
+           <<setw(10)<<"Rewinds"<<setw(11)<<"IPC Alone"<<setw(12)<<"IPC Shared"<<setw(10)<<"Slowdown"<<endl;
+
+        for(UINT32 c=0; c<numCores; c++)
+        {
+            MIX_CORE *shared = &cores[c];
+            double    ipcShared = shared->cycles[i] ? (double) shared->instructions / shared->cycles[i] : 0.0;
+            double    ipcAlone  = alone[c].cycles[i] ? (double) alone[c].instructions / alone[c].cycles[i] : 0.0;
+            double    progress  = ipcAlone ? ipcShared / ipcAlone : 0.0;
+            double    slowdown  = ipcShared ? ipcAlone / ipcShared : 0.0;
+
+            size_t slash = traceNames[c].rfind( '/' );
+            string base  = (slash == string::npos) ? traceNames[c] : traceNames[c].substr( slash + 1 );
+
+            out<<"  "<<setw(6)<<c<<"  "<<left<<setw(28)<<base<<right<<setw(14)<<shared->instructions
+               <<setw(10)<<shared->rewinds<<fixed<<setprecision(4)<<setw(11)<<ipcAlone<<setw(12)<<ipcShared
+               <<setw(10)<<slowdown<<endl;
+
+            out.unsetf( ios::floatfield );
+            out<<setprecision(6);
+
+            progressSum += progress;
+            slowdownSum += slowdown;
+
+            if( slowdown > maxSlowdown ) maxSlowdown = slowdown;
+            if( c == 0 || progress < minProgress ) minProgress = progress;
+            if( c == 0 || progress > maxProgress ) maxProgress = progress;
+        }
+
+        out<<fixed<<setprecision(4);
+        out<<"  Weighted Speedup: "<<progressSum
+           <<"  Harmonic Speedup: "<<(slowdownSum ? numCores / slowdownSum : 0.0)
+           <<"  Max Slowdown: "<<maxSlowdown
+           <<"  Fairness: "<<(maxProgress ? minProgress / maxProgress : 0.0)<<endl;
+        out.unsetf( ios::floatfield );
+        out<<setprecision(6);
+    }
+
+    return out;
+}
@@ -0,0 +1,142 @@
+#ifndef TRACE_MIX_H
+#define TRACE_MIX_H
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Multi-programmed runs from single-thread traces. A mix file lists one      //
+// trace per core (the CMPsim -mix format: a path per line, blank lines are   //
+// skipped); core c runs its trace as thread c behind its own IL1/DL1/MLC     //
+// and all cores share the LLCs.                                              //
+//                                                                            //
+// The traces are interleaved one record at a time, always stepping the core  //
+// that is furthest behind: by instructions retired (schedule "icount"), or   //
+// by cycles under the first LLC instance (schedule "cpi"), so a core that    //
+// stalls on LLC misses falls behind in the interleaving as it would in time. //
+//                                                                            //
+// The traces are of separate processes, so every core's addresses and PCs    //
+// are moved to a region of their own: core c adds c << MIX_REGION_SHIFT,     //
+// plus c times a prime number of pages so that cores running the same        //
+// trace do not map their lines to the same LLC sets.                         //
+//                                                                            //
+// Every core runs to its target, -icount instructions or, without it, the    //
+// end of its trace; its instructions and cycles are taken there. Cores that  //
+// get there first keep running to load the LLC until every core has          //
+// (rewinding their trace with -autorewind 1, idling at its end otherwise).   //
+// Each trace is then run alone, as thread 0 of a hierarchy of its own with   //
+// the same LLCs, to the same target; from the IPC shared and alone come the  //
+// weighted speedup and the fairness metrics of the mix.                      //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#include "utils.h"
+#include "trace_reader.h"
+#include "llc_group.h"
+#include "memory_hierarchy.h"
+
+#define MIX_MAX_THREADS     8
+#define MIX_REGION_SHIFT    48              // above the user address space
+#define MIX_PAGE_SKEW       (97 * 4096)     // bytes, added per core
+
+typedef enum
+{
+    MIX_SCHEDULE_ICOUNT = 0,
+    MIX_SCHEDULE_CPI    = 1
+} MixSchedules;
+
+// One core of a mix
+typedef struct
+{
+    TRACE_READER   *reader;
+    Addr_t          offset;     // relocation of its addresses and PCs
+    bool            idle;       // at the end of its trace for good
+    bool            reached;    // at its target, counts below taken
+    COUNTER         records;    // run, over all rewinds
+    COUNTER         rewinds;
+
+    COUNTER         instructions;
+    COUNTER         cycles[ LLC_GROUP_MAX ];    // per LLC instance
+} MIX_CORE;
+
+class TRACE_MIX
+{
+  private:
+
+    UINT32          numCores;
+    string          traceNames[ MIX_MAX_THREADS ];
+    TRACE_READER    readers[ MIX_MAX_THREADS ];
+    MIX_CORE        cores[ MIX_MAX_THREADS ];
+    MIX_CORE        alone[ MIX_MAX_THREADS ];
+    bool            haveAlone;
+
+    UINT32          schedule;
+    bool            autorewind;
+    COUNTER         icount;     // target, 0 = end of the trace
+
+  public:
+
+    TRACE_MIX( UINT32 _schedule, bool _autorewind );
+
+    // Reads the mix file and opens its traces, false if either fails
+    bool        Open( const char *mixName );
+
+    // Both return false if a trace fails to read
+    bool        Run( MEMORY_HIERARCHY *hier, COUNTER _icount );
+    bool        RunAlone( const LLC_CONFIG *configs, UINT32 numLLCs );
+
+    UINT32      NumCores() { return numCores; }
+    const string & TraceName( UINT32 c ) { return traceNames[c]; }
+    COUNTER     Records();
+
+    ostream &   PrintSummary( ostream &out, LLC_GROUP *llcs );
+
+    static bool ParseSchedule( const char *name, UINT32 *schedule );
+
+  private:
+
+    bool        RunCores( MIX_CORE *mix, UINT32 n, MEMORY_HIERARCHY *hier );
+    inline bool Step( MIX_CORE *core, UINT32 tid, MEMORY_HIERARCHY *hier );
+    bool        Rewind( MIX_CORE *core );
+    void        Reach( MIX_CORE *core, UINT32 tid, MEMORY_HIERARCHY *hier );
+
+    static void InitCore( MIX_CORE *core, TRACE_READER *reader, UINT32 tid );
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Runs the next record of a core's trace, relocated, as thread tid.          //
+// Returns false at the end of the trace.                                     //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+inline bool TRACE_MIX::Step( MIX_CORE *core, UINT32 tid, MEMORY_HIERARCHY *hier )
+{
+    TRACE_RECORD rec;
+
+    if( !core->reader->Next( &rec ) )
+    {
+        return false;
+    }
+
+    core->records++;
+
+    hier->Retire( tid, rec.icount );
+
+    switch( rec.accessType )
+    {
+      case ACCESS_IFETCH:
+        hier->Fetch( tid, rec.addr + core->offset );
+        break;
+
+      case ACCESS_LOAD:
+      case ACCESS_STORE:
+        hier->DataAccess( tid, rec.PC + core->offset, rec.addr + core->offset, rec.accessType );
+        break;
+
+      default:
+        break;
+    }
+
+    return true;
+}
+
+#endif
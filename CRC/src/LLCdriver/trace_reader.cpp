@@ -0,0 +1,129 @@
+#include "trace_reader.h"
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Open reader for the binary CMPsim trace format. See trace_reader.h for     //
+// the record layout.                                                         //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+TRACE_READER::TRACE_READER()
+{
+    file     = NULL;
+    buf      = new unsigned char [ TRACE_BUFFER_SIZE ];
+    bufPos   = 0;
+    bufLen   = 0;
+    fileDone = true;
+    failed   = false;
+
+    fetchLine    = 0;
+    lastAddr     = 0;
+    lastPC       = 0;
+    records      = 0;
+    instructions = 0;
+}
+
+TRACE_READER::~TRACE_READER()
+{
+    Close();
+    delete [] buf;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Opens a trace and resets the decoder. Returns false if the file could      //
+// not be opened.                                                             //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+bool TRACE_READER::Open( const char *name )
+{
+    Close();
+
+    filename = name;
+    file     = gzopen( name, "rb" );
+
+    if( file == NULL ) 
+    {
+        return false;
+    }
+
+    // Let zlib read the compressed file in large chunks as well
+    gzbuffer( file, TRACE_BUFFER_SIZE );
+
+    bufPos   = 0;
+    bufLen   = 0;
+    fileDone = false;
+    failed   = false;
+
+    fetchLine    = 0;
+    lastAddr     = 0;
+    lastPC       = 0;
+    records      = 0;
+    instructions = 0;
+
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Restarts the trace from its first record (used by -autorewind).            //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+bool TRACE_READER::Rewind()
+{
+    string name = filename;
+
+    return Open( name.c_str() );
+}
+
+void TRACE_READER::Close()
+{
+    if( file != NULL ) 
+    {
+        gzclose( file );
+        file = NULL;
+    }
+
+    fileDone = true;
+    bufPos   = 0;
+    bufLen   = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Moves the undecoded tail of the buffer to the front and fills the rest     //
+// from the decompressor.                                                     //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+void TRACE_READER::Refill()
+{
+    UINT32 left = bufLen - bufPos;
+
+    memmove( buf, &buf[ bufPos ], left );
+    bufPos = 0;
+    bufLen = left;
+
+    while( !fileDone && bufLen < TRACE_BUFFER_SIZE ) 
+    {
+        int got = gzread( file, &buf[ bufLen ], TRACE_BUFFER_SIZE - bufLen );
+
+        if( got <= 0 ) 
+        {
+            int         error;
+            const char *message = gzerror( file, &error );
+
+            // a cut gzip stream ends in 0 bytes and Z_BUF_ERROR
+            if( got < 0 || error != Z_OK ) 
+            {
+                cerr<<"Cannot read trace "<<message<<endl;
+                failed = true;
+            }
+
+            fileDone = true;
+            break;
+        }
+
+        bufLen += got;
+    }
+}
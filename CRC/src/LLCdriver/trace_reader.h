@@ -0,0 +1,214 @@
+#ifndef TRACE_READER_H
+#define TRACE_READER_H
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Open reader for the binary CMPsim trace format (*.trace.gz) written by     //
+// CMPsim.gentrace, so that the LLCsim code can be driven without the         //
+// closed libCMPsim archive.                                                  //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#include <zlib.h>
+#include <cassert>
+#include <cstring>
+#include "utils.h"
+#include "crc_cache_defs.h"
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// The trace is a gzip'ed byte stream of records:                             //
+//                                                                            //
+//     [count:1] [type:1] [payload]                                           //
+//                                                                            //
+// count is the number of instructions retired (from the current fetch        //
+// line) before the record's event. The payload depends on type:              //
+//                                                                            //
+//     0  ifetch, next line     1 byte: unsigned byte offset to new line      //
+//     1  ifetch, new line      8 bytes: line address                         //
+//     2  load, delta           2 bytes: signed address and PC deltas         //
+//     3  load                  16 bytes: address, PC                         //
+//     4  store, delta          2 bytes: signed address and PC deltas         //
+//     5  store                 16 bytes: address, PC                         //
+//                                                                            //
+// Deltas are relative to the previous data reference (load or store).        //
+// All multi-byte fields are little endian. A lone count byte at the end      //
+// of the stream holds the instructions retired after the last event. Any     //
+// other record cut off by the end of the stream makes the trace truncated.   //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+typedef enum
+{
+    TRACE_IFETCH_NEXT   = 0,
+    TRACE_IFETCH        = 1,
+    TRACE_LOAD_DELTA    = 2,
+    TRACE_LOAD          = 3,
+    TRACE_STORE_DELTA   = 4,
+    TRACE_STORE         = 5,
+    TRACE_MAX_TYPE      = 6
+} TraceRecordTypes;
+
+// Bytes of a record of each type, count and type included
+static const UINT32 trace_record_size[ TRACE_MAX_TYPE ] = { 3, 10, 4, 18, 4, 18 };
+
+// One decoded trace event
+typedef struct
+{
+    UINT32  icount;      // instructions retired before the event
+    UINT32  accessType;  // ACCESS_IFETCH/LOAD/STORE, ACCESS_MAX if none
+    Addr_t  PC;          // PC of a data reference
+    Addr_t  addr;        // fetch line or data address
+} TRACE_RECORD;
+
+#define TRACE_BUFFER_SIZE   (1 << 20)
+#define TRACE_MAX_RECORD    18
+
+class TRACE_READER
+{
+  private:
+    string          filename;
+    gzFile          file;
+
+    // decompressed bytes not yet decoded are buf[bufPos..bufLen)
+    unsigned char  *buf;
+    UINT32          bufPos;
+    UINT32          bufLen;
+    bool            fileDone;
+    bool            failed;     // read error or corrupt record
+
+    // decoder state
+    Addr_t          fetchLine;
+    Addr_t          lastAddr;
+    Addr_t          lastPC;
+
+    COUNTER         records;
+    COUNTER         instructions;
+
+  public:
+
+    TRACE_READER();
+    ~TRACE_READER();
+
+    bool    Open( const char *name );
+    bool    Rewind();
+    void    Close();
+
+    // Decodes the next record, returns false at the end of the trace
+    inline bool Next( TRACE_RECORD *rec );
+
+    // True once the trace ended on a read error or a corrupt record
+    bool    Failed() { return failed; }
+
+    const string & Name() { return filename; }
+    COUNTER Records() { return records; }
+    COUNTER Instructions() { return instructions; }
+
+  private:
+
+    void    Refill();
+
+    static Addr_t Load64( const unsigned char *p ) 
+    {
+        Addr_t v;
+        memcpy( &v, p, sizeof(v) );
+        return v;
+    }
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Decodes one record from the buffer. Kept inline: this runs once per        //
+// trace event and is the inner loop of every driver mode.                    //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+inline bool TRACE_READER::Next( TRACE_RECORD *rec )
+{
+    if( bufLen - bufPos < TRACE_MAX_RECORD && !fileDone ) 
+    {
+        Refill();
+    }
+
+    if( bufPos >= bufLen ) 
+    {
+        return false;
+    }
+
+    const unsigned char *p = &buf[ bufPos ];
+
+    rec->icount = p[0];
+
+    // trailing count without an event
+    if( bufLen - bufPos == 1 ) 
+    {
+        instructions += p[0];
+        records++;
+        rec->accessType = ACCESS_MAX;
+        rec->addr       = 0;
+        rec->PC         = 0;
+        bufPos++;
+        return true;
+    }
+
+    // the buffer holds everything left once the file is done
+    if( p[1] < TRACE_MAX_TYPE && bufLen - bufPos < trace_record_size[ p[1] ] ) 
+    {
+        cerr<<"Truncated trace record at the end of "<<filename<<endl;
+        failed = true;
+        bufPos = bufLen;
+        return false;
+    }
+
+    switch( p[1] ) 
+    {
+      case TRACE_IFETCH_NEXT:
+        fetchLine      += p[2];
+        rec->accessType = ACCESS_IFETCH;
+        rec->addr       = fetchLine;
+        rec->PC         = fetchLine;
+        bufPos += 3;
+        break;
+
+      case TRACE_IFETCH:
+        fetchLine       = Load64( p + 2 );
+        rec->accessType = ACCESS_IFETCH;
+        rec->addr       = fetchLine;
+        rec->PC         = fetchLine;
+        bufPos += 10;
+        break;
+
+      case TRACE_LOAD_DELTA:
+      case TRACE_STORE_DELTA:
+        lastAddr       += (signed char) p[2];
+        lastPC         += (signed char) p[3];
+        rec->accessType = (p[1] == TRACE_LOAD_DELTA) ? ACCESS_LOAD : ACCESS_STORE;
+        rec->addr       = lastAddr;
+        rec->PC         = lastPC;
+        bufPos += 4;
+        break;
+
+      case TRACE_LOAD:
+      case TRACE_STORE:
+        lastAddr        = Load64( p + 2 );
+        lastPC          = Load64( p + 10 );
+        rec->accessType = (p[1] == TRACE_LOAD) ? ACCESS_LOAD : ACCESS_STORE;
+        rec->addr       = lastAddr;
+        rec->PC         = lastPC;
+        bufPos += 18;
+        break;
+
+      default:
+        cerr<<"Corrupt trace record type "<<(UINT32) p[1]<<" in "<<filename<<endl;
+        failed = true;
+        bufPos = bufLen;
+        return false;
+    }
+
+    instructions += p[0];
+    records++;
+
+    return true;
+}
+
+#endif
@@ -1,4 +1,5 @@
 #include "crc_cache.h"
+#include "replacement_policies.h"
 
 ////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////
@@ -22,6 +23,14 @@
 // IMPORTANT NOTE: DO NOT CHANGE ANYTHING IN THIS HEADER FILE. Changing anything
 // in here will violate the competition rules.
 
+#include <cmath>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 string crc_access_names[] =
 {
     "IFETCH   ",
@@ -40,10 +49,25 @@ string crc_access_names[] =
 ////////////////////////////////////////////////////////////////////////////////
 CRC_CACHE::CRC_CACHE( UINT32 _cacheSize, UINT32 _assoc, UINT32 _tpc, UINT32 _linesize, UINT32 _pol ) 
 {
+    Init( _cacheSize, _assoc, _tpc, _linesize, _pol, 1 );
+}
 
-    // Start off with empty cache and replacement state
-    cache          = NULL;
-    cacheReplState = NULL;
+CRC_CACHE::CRC_CACHE( UINT32 _cacheSize, UINT32 _assoc, UINT32 _tpc, UINT32 _linesize, UINT32 _pol,
+                      UINT32 _sampleRatio ) 
+{
+    Init( _cacheSize, _assoc, _tpc, _linesize, _pol, _sampleRatio );
+}
+
+void CRC_CACHE::Init( UINT32 _cacheSize, UINT32 _assoc, UINT32 _tpc, UINT32 _linesize, UINT32 _pol,
+                      UINT32 _sampleRatio ) 
+{
+
+    // Start off with empty cache and replacement state, without prefetch
+    // statistics
+    cache           = NULL;
+    cacheReplState  = NULL;
+    prefetchMask    = NULL;
+    pollutionFilter = NULL;
 
     // Initialize parameters to the cache
     numsets  = _cacheSize / (_linesize * _assoc);
@@ -53,11 +77,19 @@ CRC_CACHE::CRC_CACHE( UINT32 _cacheSize, UINT32 _assoc, UINT32 _tpc, UINT32 _lin
 
     replPolicy = _pol;
 
+    // Model 1 of every sampleRatio sets (a power of two, 1 = all of them)
+    sampleRatio = _sampleRatio;
+    sampleShift = CRC_FloorLog2( sampleRatio );
+    numSampled  = numsets / sampleRatio;
+
+    assert( (sampleRatio & (sampleRatio - 1)) == 0 && sampleRatio <= numsets );
+
     // Initialize the cache
     InitCache();
 
     // Initialize Replacement State
     InitCacheReplacementState();
+    InitAccessPath();
 
     // Initialize the stats
     InitStats();
@@ -75,29 +107,58 @@ void CRC_CACHE::InitCache()
     indexShift = CRC_FloorLog2( numsets );    
     indexMask  = (1 << indexShift) - 1;
 
-    // Create the cache structure (first create the sets)
-    cache = new LINE_STATE* [ numsets ];
+    // Pick the modelled set of every group by a hash of the group, so the
+    // sample is spread over the whole index range without a fixed stride
+    sampleOffset = NULL;
+
+    if( sampleRatio > 1 ) 
+    {
+        sampleOffset = new UINT32[ numSampled ];
+
+        for(UINT32 group=0; group<numSampled; group++) 
+        {
+            sampleOffset[ group ] = CRC_Mix64( group ) & (sampleRatio - 1);
+        }
+    }
+
+    // Lines are tracked in a 64-bit valid mask per set. Only the modelled
+    // sets are allocated
+    assert(assoc <= 64);
+    wayMask    = CRC_WayMask( assoc );
+
+    // Pad the tag rows to a multiple of four ways (one AVX2 vector)
+    tagStride  = (assoc + 3) & ~3;
+    tagShadow  = (Addr_t *) CRC_AlignedCalloc( numSampled * tagStride, sizeof(Addr_t) );
+    validMask  = (BITVECTOR *) CRC_AlignedCalloc( numSampled, sizeof(BITVECTOR) );
+
+    assert(tagShadow && validMask);
+
+    // Create the cache structure as one contiguous set-major block so that
+    // all ways of a set are adjacent in host memory
+    cache = (LINE_STATE *) CRC_AlignedCalloc( numSampled * assoc, sizeof(LINE_STATE) );
 
     // ensure that we were able to create cache
     assert(cache);
 
-    // If we were able to create the sets, now create the ways
-    for(UINT32 setIndex=0; setIndex<numsets; setIndex++) 
+    // Initialize the cache ways
+    for(UINT32 setIndex=0; setIndex<numSampled; setIndex++) 
     {
-        cache[ setIndex ] = new LINE_STATE[ assoc ];
+        LINE_STATE *currSet = GetSet( setIndex );
 
-        // Initialize the cache ways
         for(UINT32 way=0; way<assoc; way++) 
         {
-            cache[ setIndex ][ way ].tag   = 0xdeaddead;
-            cache[ setIndex ][ way ].valid = false;
-            cache[ setIndex ][ way ].dirty = false;
-            cache[ setIndex ][ way ].sharing_dir   = 0;
+            currSet[ way ].tag   = 0xdeaddead;
+            currSet[ way ].valid = false;
+            currSet[ way ].dirty = false;
+            currSet[ way ].sharing_dir   = 0;
+
+            tagShadow[ setIndex * tagStride + way ] = 0xdeaddead;
         }
     }
 
     // Initialize cache access timer
-    mytimer = 0;
+    mytimer  = 0;
+    warmRefs = 0;
 
 }
 
@@ -121,6 +182,45 @@ void CRC_CACHE::InitStats()
             hits[i][t]    = 0;
         }
     }
+
+    writebacks = new COUNTER[ threads ];
+
+    for(UINT32 t=0; t<threads; t++) 
+    {
+        writebacks[t] = 0;
+    }
+
+    victimInserts = 0;
+    cleanInserts  = 0;
+
+    wbPending = false;
+    wbAddr    = 0;
+    wbOwner   = 0;
+
+    inclusion  = LLC_NINE;
+    evPending  = false;
+    evAddr     = 0;
+    evPresence = 0;
+    movedDirty = false;
+
+    demandRefs  = NULL;
+    slotLookups = NULL;
+    slotMisses  = NULL;
+
+    if( sampleRatio > 1 ) 
+    {
+        demandRefs  = (COUNTER *) CRC_AlignedCalloc( threads, sizeof(COUNTER) );
+        slotLookups = (COUNTER *) CRC_AlignedCalloc( numSampled * threads, sizeof(COUNTER) );
+        slotMisses  = (COUNTER *) CRC_AlignedCalloc( numSampled * threads, sizeof(COUNTER) );
+
+        assert( demandRefs && slotLookups && slotMisses );
+    }
+
+    pfFills          = 0;
+    pfUseful         = 0;
+    pfUseless        = 0;
+    pfPolluted       = 0;
+    pfMergedResident = 0;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -143,9 +243,19 @@ ostream & CRC_CACHE::PrintStats(ostream &out)
     out<<"\tAssociativity:  "<<assoc<<endl;
     out<<"\tTot # Sets:     "<<numsets<<endl;
     out<<"\tTot # Threads:  "<<threads<<endl;
+
+    if( sampleRatio > 1 ) 
+    {
+        out<<"\tSampled Sets:   "<<numSampled<<" (1 in "<<sampleRatio<<")"<<endl;
+    }
+
+    if( warmRefs ) 
+    {
+        out<<"\tWarmed Up By:   "<<warmRefs<<" references (snapshot)"<<endl;
+    }
     
     out<<endl;
-    out<<"Cache Statistics: "<<endl;
+    out<<"Cache Statistics"<<((sampleRatio > 1) ? " (sampled sets)" : "")<<": "<<endl;
     out<<endl;
     
     for(UINT32 a=0; a<ACCESS_MAX; a++) 
@@ -173,8 +283,22 @@ ostream & CRC_CACHE::PrintStats(ostream &out)
         }
     }
 
+    COUNTER totWritebacks = 0;
+
+    for(UINT32 t=0; t<threads; t++) 
+    {
+        totWritebacks += writebacks[t];
+    }
+
+    out<<"\tMemory Writebacks:    "<<totWritebacks<<endl;
+
+    if( inclusion == LLC_EXCLUSIVE ) 
+    {
+        out<<"\tVictim Insertions:    "<<victimInserts<<" ("<<cleanInserts<<" clean), counted as WRITEBACK accesses"<<endl;
+    }
+
     out<<endl;
-    out<<"Per Thread Demand Reference Statistics: "<<endl;
+    out<<"Per Thread Demand Reference Statistics"<<((sampleRatio > 1) ? " (sampled sets)" : "")<<": "<<endl;
 
     for(UINT32 t=0; t<threads; t++) 
     {
@@ -190,11 +314,220 @@ ostream & CRC_CACHE::PrintStats(ostream &out)
     }
     out<<endl;
 
+    if( sampleRatio > 1 ) 
+    {
+        out<<"Per Thread Demand Estimates for All Sets (95% confidence): "<<endl;
+
+        for(UINT32 t=0; t<threads; t++) 
+        {
+            COUNTER refs = ThreadDemandReferences(t);
+            double  halfWidth;
+            double  estMisses = ThreadDemandMissEstimate( t, &halfWidth );
+
+            if( refs ) 
+            {
+                out<<"\tThread: "<<t<<" Lookups: "<<refs
+                   <<" Misses: "<<(COUNTER) (estMisses + 0.5)<<" +- "<<(COUNTER) (halfWidth + 0.5)
+                   <<" Miss Rate: "<<estMisses/(double)refs*100.0<<" +- "<<halfWidth/(double)refs*100.0<<endl;
+            }
+        }
+        out<<endl;
+    }
+
+    if( prefetchMask ) 
+    {
+        PrintPrefetchStats( out );
+    }
+
     cacheReplState->PrintStats( out );
      
     return out;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// The function adds the statistics of another cache of the same geometry    //
+// to this one, e.g. of a copy that simulated a different part of the sets    //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+void CRC_CACHE::MergeStats( const CRC_CACHE *other )
+{
+    assert( other->numsets == numsets && other->sampleRatio == sampleRatio );
+
+    for(UINT32 a=0; a<ACCESS_MAX; a++) 
+    {
+        for(UINT32 t=0; t<threads; t++) 
+        {
+            lookups[a][t] += other->lookups[a][t];
+            misses[a][t]  += other->misses[a][t];
+            hits[a][t]    += other->hits[a][t];
+        }
+    }
+
+    for(UINT32 t=0; t<threads; t++) 
+    {
+        writebacks[t] += other->writebacks[t];
+    }
+
+    victimInserts += other->victimInserts;
+    cleanInserts  += other->cleanInserts;
+
+    if( sampleRatio > 1 ) 
+    {
+        for(UINT32 t=0; t<threads; t++) 
+        {
+            demandRefs[t] += other->demandRefs[t];
+        }
+
+        for(UINT32 i=0; i<numSampled * threads; i++) 
+        {
+            slotLookups[i] += other->slotLookups[i];
+            slotMisses[i]  += other->slotMisses[i];
+        }
+    }
+
+    if( prefetchMask ) 
+    {
+        pfFills    += other->pfFills;
+        pfUseful   += other->pfUseful;
+        pfUseless  += other->pfUseless;
+        pfPolluted += other->pfPolluted;
+
+        pfMergedResident += other->pfMergedResident;
+
+        for(UINT32 setIndex=0; setIndex<numSampled; setIndex++) 
+        {
+            pfMergedResident += CRC_PopCount64( other->prefetchMask[ setIndex ] );
+        }
+    }
+
+    cacheReplState->MergeStats( other->cacheReplState );
+}
+
+// The arrays of the cache section of a snapshot, the modelled sets only
+UINT32 CRC_CACHE::SnapshotArrays( CRC_SNAPSHOT_ARRAY *arrays )
+{
+    CRC_SNAPSHOT_ARRAY section[] = 
+    {
+        { &mytimer,  sizeof(mytimer) },
+        { cache,     numSampled * assoc * sizeof(LINE_STATE) },
+        { tagShadow, numSampled * tagStride * sizeof(Addr_t) },
+        { validMask, numSampled * sizeof(BITVECTOR) }
+    };
+
+    memcpy( arrays, section, sizeof(section) );
+
+    return sizeof(section) / sizeof(section[0]);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Writes the snapshot header of the cache and its cache, common and policy   //
+// sections (see crc_snapshot.h).                                             //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+bool CRC_CACHE::SaveSnapshot( FILE *file )
+{
+    CRC_SNAPSHOT_HEADER header;
+    CRC_SNAPSHOT_ARRAY  arrays[ CRC_SNAPSHOT_MAX_ARRAYS ];
+    UINT32              count = SnapshotArrays( arrays );
+
+    memset( &header, 0, sizeof(header) );
+    header.numsets     = numsets;
+    header.assoc       = assoc;
+    header.threads     = threads;
+    header.linesize    = linesize;
+    header.replPolicy  = replPolicy;
+    header.sampleRatio = sampleRatio;
+    header.bytes       = CRC_SnapshotBytes( arrays, count ) + cacheReplState->SnapshotBytes();
+
+    return fwrite( &header, sizeof(header), 1, file ) == 1
+           && CRC_SnapshotArrays( file, arrays, count, false )
+           && cacheReplState->SaveSnapshot( file );
+}
+
+// The geometry of the cache, which its state only fits if it is the same
+bool CRC_CACHE::SnapshotMatches( const CRC_SNAPSHOT_HEADER *header )
+{
+    return header->numsets == numsets && header->assoc == assoc && header->threads == threads
+           && header->linesize == linesize && header->sampleRatio == sampleRatio;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Reads the sections after a matching header in place: all of them for a     //
+// snapshot of the same policy, else the cache and common sections, and       //
+// makes the references so far the reset point of the statistics. Prefetch    //
+// statistics start with no line marked as prefetched.                        //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+bool CRC_CACHE::LoadSnapshot( FILE *file, const CRC_SNAPSHOT_HEADER *header )
+{
+    CRC_SNAPSHOT_ARRAY arrays[ CRC_SNAPSHOT_MAX_ARRAYS ];
+    UINT32             count      = SnapshotArrays( arrays );
+    bool               samePolicy = (header->replPolicy == replPolicy);
+
+    assert( SnapshotMatches( header ) );
+
+    if( samePolicy && header->bytes != CRC_SnapshotBytes( arrays, count ) + cacheReplState->SnapshotBytes() ) 
+    {
+        return false;
+    }
+
+    if( !CRC_SnapshotArrays( file, arrays, count, true ) || !cacheReplState->LoadSnapshot( file, samePolicy ) ) 
+    {
+        return false;
+    }
+
+    warmRefs = mytimer;
+
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// What the prefetches came to. Accuracy is the share of the prefetched       //
+// lines that were hit on demand, coverage the share of the demand misses     //
+// they saved (their first hits over those hits plus the demand misses).      //
+// Pollution counts the demand misses to lines that prefetch fills evicted,   //
+// as far as the filter of evicted lines still holds them.                    //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+ostream & CRC_CACHE::PrintPrefetchStats( ostream &out )
+{
+    COUNTER issued = 0, redundant = 0, demandMisses = 0;
+    COUNTER unused = pfMergedResident;
+
+    for(UINT32 t=0; t<threads; t++) 
+    {
+        issued       += lookups[ ACCESS_PREFETCH ][t];
+        redundant    += hits[ ACCESS_PREFETCH ][t];
+        demandMisses += ThreadDemandMissStats(t);
+    }
+
+    for(UINT32 setIndex=0; setIndex<numSampled; setIndex++) 
+    {
+        unused += CRC_PopCount64( prefetchMask[ setIndex ] );
+    }
+
+    out<<"Prefetch Statistics"<<((sampleRatio > 1) ? " (sampled sets)" : "")<<": "<<endl;
+    out<<"\tIssued:         "<<issued<<endl;
+    out<<"\tRedundant:      "<<redundant<<" (line already cached)"<<endl;
+    out<<"\tBypassed:       "<<issued - redundant - pfFills<<endl;
+    out<<"\tFilled:         "<<pfFills<<endl;
+    out<<"\tUseful:         "<<pfUseful<<" (hit on demand)"<<endl;
+    out<<"\tUseless:        "<<pfUseless<<" (evicted before a demand hit)"<<endl;
+    out<<"\tUnused:         "<<unused<<" (still cached at the end)"<<endl;
+    out<<"\tAccuracy:       "<<(pfFills ? (double)pfUseful/(double)pfFills*100.0 : 0.0)<<endl;
+    out<<"\tCoverage:       "
+       <<((pfUseful + demandMisses) ? (double)pfUseful/(double)(pfUseful + demandMisses)*100.0 : 0.0)<<endl;
+    out<<"\tPollution:      "<<pfPolluted<<" demand misses ("
+       <<(demandMisses ? (double)pfPolluted/(double)demandMisses*100.0 : 0.0)<<"% of them)"<<endl;
+    out<<endl;
+
+    return out;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 //                                                                            //
 // The function slects a victim for the given set index. We enforce that      //
@@ -202,46 +535,125 @@ ostream & CRC_CACHE::PrintStats(ostream &out)
 // the replacement policy is consulted to find the victim                     //
 //                                                                            //
 ////////////////////////////////////////////////////////////////////////////////
+template <UINT32 POLICY>
 INT32 CRC_CACHE::GetVictimInSet( UINT32 tid, UINT32 setIndex, Addr_t PC, Addr_t paddr, UINT32 accessType ) 
 {
-    // Get pointer to replacement state of current set
-    LINE_STATE *vicSet = cache[ setIndex ];
+    // First find and fill invalid lines (lowest invalid way)
+    BITVECTOR invalid = ~validMask[ setIndex ] & wayMask;
 
-    // First find and fill invalid lines
-    for(UINT32 way=0; way<assoc; way++) 
+    if( invalid ) 
     {
-        if( vicSet[way].valid == false ) 
-        {
-            return way;
-        }
+        return CRC_CountTrailingZeros64( invalid );
     }
 
     // If no invalid lines, then replace based on replacement policy
-    return cacheReplState->GetVictimInSet( tid, setIndex, vicSet, assoc, PC, paddr, accessType );
+    return REPL_POLICY<POLICY>::Victim( cacheReplState, tid, setIndex, PC, accessType );
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 //                                                                            //
-// The function looks up the set for the tag and returns physical way index   //
-// if the tag was a hit. Else returns -1 if it was a miss.                    //
+// Estimates the demand misses of a thread over all sets from the sampled     //
+// ones. The miss ratio of the sampled sets is applied to the thread's        //
+// references to every set (a ratio estimator with the sets as clusters);     //
+// halfWidth receives the half width of its 95% confidence interval.          //
+// Without sampling the count is exact and the half width 0.                  //
 //                                                                            //
 ////////////////////////////////////////////////////////////////////////////////
-INT32 CRC_CACHE::LookupSet( UINT32 setIndex, Addr_t tag )
+double CRC_CACHE::ThreadDemandMissEstimate( UINT32 tid, double *halfWidth )
 {
-    // Get pointer to current set
-    LINE_STATE *currSet = cache[ setIndex ];
+    double lookups = (double) ThreadDemandLookupStats( tid );
+    double misses  = (double) ThreadDemandMissStats( tid );
+    double refs    = (double) ThreadDemandReferences( tid );
+
+    if( halfWidth ) *halfWidth = 0.0;
 
-    // Find Tag
-    for(UINT32 way=0; way<assoc; way++) 
+    if( sampleRatio == 1 || lookups == 0.0 ) 
     {
-        if( currSet[way].valid && (currSet[way].tag == tag) ) 
-        {
-            return way;
-        }
+        return (sampleRatio == 1) ? misses : 0.0;
+    }
+
+    double ratio    = misses / lookups;
+    double residual = 0.0;
+
+    for(UINT32 slot=0; slot<numSampled; slot++) 
+    {
+        double d = (double) slotMisses[ slot * threads + tid ] 
+                   - ratio * (double) slotLookups[ slot * threads + tid ];
+
+        residual += d * d;
+    }
+
+    // Var(ratio) ~ (1 - n/N) s^2 / (n mean^2), s^2 the residual variance
+    double n        = (double) numSampled;
+    double mean     = lookups / n;
+    double variance = (numSampled > 1) 
+                      ? (1.0 - 1.0 / sampleRatio) * residual / (n - 1.0) / (n * mean * mean) 
+                      : 0.0;
+
+    if( halfWidth ) *halfWidth = 1.96 * sqrt( variance ) * refs;
+
+    return ratio * refs;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// The function compares a tag against a row of the tag shadow and returns    //
+// a bit mask with bit w set if way w holds the tag. The row must be padded   //
+// to a multiple of four tags. Uses AVX2 or SSE2 compares when the compiler   //
+// targets them and falls back to a scalar loop on other hosts.               //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+static inline BITVECTOR MatchTagRow( const Addr_t *row, UINT32 stride, Addr_t tag )
+{
+    BITVECTOR match = 0;
+
+#if defined(__AVX2__)
+    __m256i key = _mm256_set1_epi64x( (long long) tag );
+
+    for(UINT32 way=0; way<stride; way+=4) 
+    {
+        __m256i tags = _mm256_load_si256( (const __m256i *) &row[ way ] );
+        __m256i eq   = _mm256_cmpeq_epi64( tags, key );
+
+        match |= (BITVECTOR) _mm256_movemask_pd( _mm256_castsi256_pd( eq ) ) << way;
+    }
+#elif defined(__SSE2__)
+    __m128i key = _mm_set1_epi64x( (long long) tag );
+
+    for(UINT32 way=0; way<stride; way+=2) 
+    {
+        __m128i tags = _mm_load_si128( (const __m128i *) &row[ way ] );
+
+        // SSE2 has no 64-bit compare: both 32-bit halves must match
+        __m128i eq   = _mm_cmpeq_epi32( tags, key );
+        eq           = _mm_and_si128( eq, _mm_shuffle_epi32( eq, _MM_SHUFFLE(2,3,0,1) ) );
+
+        match |= (BITVECTOR) _mm_movemask_pd( _mm_castsi128_pd( eq ) ) << way;
+    }
+#else
+    for(UINT32 way=0; way<stride; way++) 
+    {
+        match |= (BITVECTOR) (row[ way ] == tag) << way;
     }
+#endif
+
+    return match;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// The function looks up the set for the tag and returns physical way index   //
+// if the tag was a hit. Else returns -1 if it was a miss.                    //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+INT32 CRC_CACHE::LookupSet( UINT32 setIndex, Addr_t tag )
+{
+    // Match the whole set at once, then drop invalid and padding ways
+    BITVECTOR match = MatchTagRow( &tagShadow[ setIndex * tagStride ], tagStride, tag ) 
+                      & validMask[ setIndex ];
 
     // If not found, return -1
-    return -1;
+    return match ? CRC_CountTrailingZeros64( match ) : -1;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -256,6 +668,17 @@ bool CRC_CACHE::CacheInspect( UINT32 tid, Addr_t PC, Addr_t paddr, UINT32 access
     UINT32 setIndex = GetSetIndex( paddr );  // Get the set index
     Addr_t tag      = GetTag( paddr );       // Determine Cache Tag
 
+    // Sets that are not modelled report hits, as in LookupAndFillCache
+    if( sampleRatio > 1 ) 
+    {
+        if( !SampledSet( setIndex ) ) 
+        {
+            return true;
+        }
+
+        setIndex >>= sampleShift;
+    }
+
     INT32 wayID     = LookupSet( setIndex, tag );
 
     // if wayID = -1, miss, else it is a hit
@@ -273,6 +696,66 @@ bool CRC_CACHE::CacheInspect( UINT32 tid, Addr_t PC, Addr_t paddr, UINT32 access
 //                                                                            //
 ////////////////////////////////////////////////////////////////////////////////
 bool CRC_CACHE::LookupAndFillCache( UINT32 tid, Addr_t PC, Addr_t paddr, UINT32 accessType ) 
+{
+    return (this->*accessPath)( tid, PC, paddr, accessType );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Before a fill of way: counts the way's line as useless if a prefetch       //
+// brought it in and no demand hit it since, and marks the way as             //
+// prefetched or not. A prefetch that displaces a line other than an unused   //
+// prefetch enters it in the pollution filter.                                //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+inline void CRC_CACHE::TrackFill( UINT32 setIndex, INT32 way, UINT32 accessType )
+{
+    BITVECTOR bit    = 1ULL << way;
+    bool      unused = (prefetchMask[ setIndex ] & bit) != 0;
+
+    pfUseless += unused;
+
+    if( accessType != ACCESS_PREFETCH ) 
+    {
+        prefetchMask[ setIndex ] &= ~bit;
+        return;
+    }
+
+    if( (validMask[ setIndex ] & bit) && !unused ) 
+    {
+        Addr_t tag = GetSet( setIndex )[ way ].tag;
+
+        *PollutionEntry( setIndex, tag ) = tag;
+    }
+
+    prefetchMask[ setIndex ] |= bit;
+    pfFills++;
+}
+
+// The address of a line, rebuilt from its tag and set (the real set of a
+// sampled slot)
+inline Addr_t CRC_CACHE::LineAddr( UINT32 setIndex, Addr_t tag )
+{
+    Addr_t set = (sampleRatio > 1) ? (setIndex << sampleShift) | sampleOffset[ setIndex ] : setIndex;
+
+    return ((tag << indexShift) | set) << lineShift;
+}
+
+// A line leaves for memory: counts it for its owner and keeps it for
+// TakeWriteback
+inline void CRC_CACHE::WriteBack( UINT32 setIndex, Addr_t tag, UINT32 owner )
+{
+    writebacks[ owner ]++;
+
+    wbPending = true;
+    wbAddr    = LineAddr( setIndex, tag );
+    wbOwner   = owner;
+}
+
+// The body of LookupAndFillCache for replacement policy POLICY, feeding the
+// replacement diagnostics if DIAG and the prefetch statistics if PF
+template <UINT32 POLICY, bool DIAG, bool PF>
+bool CRC_CACHE::LookupAndFill( UINT32 tid, Addr_t PC, Addr_t paddr, UINT32 accessType ) 
 {
 
     LINE_STATE *currLine = NULL;
@@ -281,14 +764,39 @@ bool CRC_CACHE::LookupAndFillCache( UINT32 tid, Addr_t PC, Addr_t paddr, UINT32
     ++mytimer;     
     cacheReplState->IncrementTimer();
 
-    // manage stats for cache
-    lookups[ accessType ][ tid ]++;
-
     // Process request
     bool  hit       = true;
     UINT32 setIndex = GetSetIndex( paddr );  // Get the set index
     Addr_t tag      = GetTag( paddr );       // Determine Cache Tag
 
+    // In sampled mode references to the other sets are only counted. They
+    // report a hit so that the caller charges no memory stall for them
+    if( sampleRatio > 1 ) 
+    {
+        demandRefs[ tid ] += (accessType <= ACCESS_STORE);
+
+        if( !SampledSet( setIndex ) ) 
+        {
+            return true;
+        }
+
+        setIndex >>= sampleShift;
+
+        if( accessType <= ACCESS_STORE ) 
+        {
+            slotLookups[ setIndex * threads + tid ]++;
+        }
+    }
+
+    // UCP's utility monitors see every access, hit or miss
+    if( REPL_POLICY<POLICY>::monitorsAccesses ) 
+    {
+        cacheReplState->MonitorAccess( tid, setIndex, tag, accessType );
+    }
+
+    // manage stats for cache
+    lookups[ accessType ][ tid ]++;
+
     // Lookup the cache set to determine whether line is already in cache or not
     INT32 wayID     = LookupSet( setIndex, tag );
 
@@ -297,12 +805,45 @@ bool CRC_CACHE::LookupAndFillCache( UINT32 tid, Addr_t PC, Addr_t paddr, UINT32
     {
         hit = false;
 
-        // get victim line to replace (wayID = -1, then bypass)
-        wayID     = GetVictimInSet( tid, setIndex, PC, paddr, accessType );
+        // A demand miss to a line that a prefetch evicted
+        if( PF && accessType <= ACCESS_STORE ) 
+        {
+            Addr_t *entry = PollutionEntry( setIndex, tag );
+
+            if( *entry == tag ) 
+            {
+                pfPolluted++;
+                *entry = PF_NO_KEY;
+            }
+        }
+
+        // get victim line to replace (wayID = -1, then bypass). An exclusive
+        // cache leaves the lines of demand misses to the level above
+        bool noFill = (inclusion == LLC_EXCLUSIVE) && accessType <= ACCESS_STORE;
+
+        wayID     = noFill ? -1 : GetVictimInSet<POLICY>( tid, setIndex, PC, paddr, accessType );
 
         if( wayID != -1 )
         {
-            currLine  = &cache[ setIndex ][ wayID ];
+            if( PF ) TrackFill( setIndex, wayID, accessType );
+
+            currLine  = &GetSet( setIndex )[ wayID ];
+
+            // A dirty victim goes back to memory, counted for the lowest
+            // numbered thread that used it
+            if( currLine->valid && currLine->dirty ) 
+            {
+                WriteBack( setIndex, currLine->tag, 
+                           currLine->sharing_dir ? CRC_CountTrailingZeros64( currLine->sharing_dir ) : tid );
+            }
+
+            // An inclusive cache reports every valid victim for back-invalidation
+            if( inclusion == LLC_INCLUSIVE && currLine->valid ) 
+            {
+                evPending  = true;
+                evAddr     = LineAddr( setIndex, currLine->tag );
+                evPresence = currLine->sharing_dir;
+            }
 
             // Update the line state accordingly
             currLine->valid          = true;
@@ -310,26 +851,74 @@ bool CRC_CACHE::LookupAndFillCache( UINT32 tid, Addr_t PC, Addr_t paddr, UINT32
             currLine->dirty          = IS_STORE( accessType );
             currLine->sharing_dir    = (1<<tid);
 
+            // Keep the tag shadow in sync with the line
+            tagShadow[ setIndex * tagStride + wayID ] = tag;
+            validMask[ setIndex ] |= 1ULL << wayID;
+
             // Update Replacement State
-            cacheReplState->UpdateReplacementState( setIndex, wayID, currLine, tid, PC, accessType, hit );
+            REPL_POLICY<POLICY>::Update( cacheReplState, setIndex, wayID, tid, PC, accessType, hit );
+
+            if( DIAG ) cacheReplState->Diagnostics()->Fill( setIndex, wayID, PC );
+        }
+        else if( !noFill ) 
+        {
+            // A bypassed writeback goes on to memory
+            if( accessType == ACCESS_WRITEBACK ) 
+            {
+                WriteBack( setIndex, tag, tid );
+            }
+
+            if( DIAG ) cacheReplState->Diagnostics()->Bypass( setIndex, PC );
         }
         
         // Update Stats
         misses[ accessType ][ tid ]++;
+
+        if( sampleRatio > 1 && accessType <= ACCESS_STORE ) 
+        {
+            slotMisses[ setIndex * threads + tid ]++;
+        }
     }
     else 
     {
         // get pointer to cache line we hit
-        currLine         = &cache[ setIndex ][ wayID ];
+        currLine         = &GetSet( setIndex )[ wayID ];
 
         // Update the line state accordingly
         currLine->dirty         |= IS_STORE( accessType );
         currLine->sharing_dir   |= (1<<tid);
 
-        // Update Replacement State
-        if( accessType != ACCESS_WRITEBACK ) 
+        // Update Replacement State. Writeback hits leave the replacement
+        // state alone, except for OPT which must see every reference to
+        // keep the line's next use current. So do prefetches of lines
+        // already in the cache
+        if( accessType <= ACCESS_STORE 
+            || (accessType == ACCESS_WRITEBACK && REPL_POLICY<POLICY>::updateOnWritebackHit) ) 
+        {
+            REPL_POLICY<POLICY>::Update( cacheReplState, setIndex, wayID, tid, PC, accessType, hit );
+        }
+
+        if( DIAG ) 
         {
-            cacheReplState->UpdateReplacementState( setIndex, wayID, currLine, tid, PC, accessType, hit );
+            cacheReplState->Diagnostics()->Hit( setIndex, wayID, accessType <= ACCESS_STORE );
+        }
+
+        // The first demand hit of a prefetched line
+        if( PF && accessType <= ACCESS_STORE && (prefetchMask[ setIndex ] & (1ULL << wayID)) ) 
+        {
+            prefetchMask[ setIndex ] &= ~(1ULL << wayID);
+            pfUseful++;
+        }
+
+        // An exclusive cache hands a demand hit to the level above, dirty
+        // or not, and frees its way
+        if( inclusion == LLC_EXCLUSIVE && accessType <= ACCESS_STORE ) 
+        {
+            movedDirty = currLine->dirty;
+
+            currLine->valid = false;
+            currLine->dirty = false;
+            validMask[ setIndex ] &= ~(1ULL << wayID);
         }
 
         // Update Stats
@@ -347,5 +936,139 @@ bool CRC_CACHE::LookupAndFillCache( UINT32 tid, Addr_t PC, Addr_t paddr, UINT32
 ////////////////////////////////////////////////////////////////////////////////
 void CRC_CACHE::InitCacheReplacementState()
 {
-    cacheReplState = new CACHE_REPLACEMENT_STATE( numsets, assoc, replPolicy );
+    cacheReplState = new CACHE_REPLACEMENT_STATE( numSampled, assoc, replPolicy );
+    cacheReplState->SetThreads( threads );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// The function turns on the replacement diagnostics and moves the cache to   //
+// the access path that feeds them                                            //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+void CRC_CACHE::EnableDiagnostics()
+{
+    cacheReplState->EnableDiagnostics();
+    InitAccessPath();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// The function sets the inclusion of the cache. With set sampling the        //
+// lines of the unmodelled sets could be neither reported nor moved           //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+void CRC_CACHE::EnableInclusion( UINT32 _inclusion )
+{
+    assert( _inclusion < LLC_INCLUSION_MAX && sampleRatio == 1 );
+
+    inclusion = _inclusion;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Exclusive mode: a line evicted from the level above goes through the       //
+// access path as a writeback, which marks the line dirty. A clean victim     //
+// then gets back the dirty bit the line had before: clean if it filled the   //
+// line, unchanged if it hit a copy a prefetch had brought in. So only dirty  //
+// lines go back to memory when evicted.                                      //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+bool CRC_CACHE::InsertVictim( UINT32 tid, Addr_t paddr, bool dirty )
+{
+    UINT32 setIndex = GetSetIndex( paddr );
+    Addr_t tag      = GetTag( paddr );
+    INT32  wayID    = LookupSet( setIndex, tag );
+    bool   wasDirty = (wayID != -1) && GetSet( setIndex )[ wayID ].dirty;
+
+    bool hit = LookupAndFillCache( tid, 0, paddr, ACCESS_WRITEBACK );
+
+    victimInserts++;
+
+    if( !dirty ) 
+    {
+        cleanInserts++;
+
+        wayID = LookupSet( setIndex, tag );
+
+        if( wayID != -1 ) 
+        {
+            GetSet( setIndex )[ wayID ].dirty = wasDirty;
+        }
+    }
+
+    return hit;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// The function turns on the prefetch statistics and moves the cache to the   //
+// access path that keeps them                                                //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+void CRC_CACHE::EnablePrefetchStats()
+{
+    prefetchMask    = (BITVECTOR *) CRC_AlignedCalloc( numSampled, sizeof(BITVECTOR) );
+    pollutionFilter = (Addr_t *) CRC_AlignedCalloc( numSampled * assoc, sizeof(Addr_t) );
+
+    assert( prefetchMask && pollutionFilter );
+
+    for(UINT32 e=0; e<numSampled * assoc; e++) 
+    {
+        pollutionFilter[e] = PF_NO_KEY;
+    }
+
+    InitAccessPath();
+}
+
+// The access path of POLICY, with diagnostics and prefetch statistics if
+// they are enabled
+template <UINT32 POLICY>
+CRC_CACHE::ACCESS_PATH CRC_CACHE::PolicyAccessPath()
+{
+    if( cacheReplState->Diagnostics() ) 
+    {
+        return DiagAccessPath<POLICY, true>();
+    }
+
+    return DiagAccessPath<POLICY, false>();
+}
+
+template <UINT32 POLICY, bool DIAG>
+CRC_CACHE::ACCESS_PATH CRC_CACHE::DiagAccessPath()
+{
+    if( prefetchMask ) 
+    {
+        return &CRC_CACHE::LookupAndFill<POLICY, DIAG, true>;
+    }
+
+    return &CRC_CACHE::LookupAndFill<POLICY, DIAG, false>;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// The one run-time dispatch on the replacement policy: picks the access      //
+// path instantiated for it                                                   //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+void CRC_CACHE::InitAccessPath()
+{
+    switch( replPolicy ) 
+    {
+      case CRC_REPL_LRU:         accessPath = PolicyAccessPath<CRC_REPL_LRU>();         break;
+      case CRC_REPL_RANDOM:      accessPath = PolicyAccessPath<CRC_REPL_RANDOM>();      break;
+      case CRC_REPL_CONTESTANT:  accessPath = PolicyAccessPath<CRC_REPL_CONTESTANT>();  break;
+      case CRC_REPL_OPT:         accessPath = PolicyAccessPath<CRC_REPL_OPT>();         break;
+      case CRC_REPL_OPT_BYPASS:  accessPath = PolicyAccessPath<CRC_REPL_OPT_BYPASS>();  break;
+      case CRC_REPL_SRRIP:       accessPath = PolicyAccessPath<CRC_REPL_SRRIP>();       break;
+      case CRC_REPL_BRRIP:       accessPath = PolicyAccessPath<CRC_REPL_BRRIP>();       break;
+      case CRC_REPL_DRRIP:       accessPath = PolicyAccessPath<CRC_REPL_DRRIP>();       break;
+      case CRC_REPL_SHIP:        accessPath = PolicyAccessPath<CRC_REPL_SHIP>();        break;
+      case CRC_REPL_SHIP_BYPASS: accessPath = PolicyAccessPath<CRC_REPL_SHIP_BYPASS>(); break;
+      case CRC_REPL_UCP:         accessPath = PolicyAccessPath<CRC_REPL_UCP>();         break;
+
+      default:
+        // Unknown replacement policy
+        assert(0);
+    }
 }
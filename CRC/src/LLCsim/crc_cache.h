@@ -28,6 +28,17 @@
 #include "replacement_state.h"
 #include "crc_cache_defs.h"
 
+#define PF_NO_KEY   (~0ULL)     // empty entry of the pollution filter
+
+// Inclusion of the LLC relative to the private caches above it
+typedef enum
+{
+    LLC_NINE          = 0,  // non-inclusive non-exclusive: every miss fills
+    LLC_INCLUSIVE     = 1,  // evicted lines are reported for back-invalidation
+    LLC_EXCLUSIVE     = 2,  // demand hits move up, demand misses do not fill
+    LLC_INCLUSION_MAX = 3
+} LLCInclusion;
+
 class CRC_CACHE
 {
   private:
@@ -39,13 +50,49 @@ class CRC_CACHE
     UINT32 linesize;
     UINT32 replPolicy;
     
-    LINE_STATE               **cache;
+    LINE_STATE               *cache;   // set-major: numsets x assoc lines
+
+    // Structure-of-arrays shadow of the tags and valid bits so that a whole
+    // set can be matched with vector compares (one row of tagStride tags
+    // per set, padded to the vector width)
+    Addr_t                   *tagShadow;
+    BITVECTOR                *validMask;
+    UINT32                    tagStride;
+    BITVECTOR                 wayMask;
     CACHE_REPLACEMENT_STATE  *cacheReplState;
 
+    // LookupAndFillCache instantiated for replPolicy, with or without the
+    // replacement diagnostics and the prefetch statistics, picked once so the
+    // per-access path inlines a single policy
+    typedef bool (CRC_CACHE::*ACCESS_PATH)( UINT32 tid, Addr_t PC, Addr_t paddr, UINT32 accessType );
+    ACCESS_PATH               accessPath;
+
     // statistics
     COUNTER *lookups[ ACCESS_MAX ];
     COUNTER *misses[ ACCESS_MAX ];
     COUNTER *hits[ ACCESS_MAX ];
+    COUNTER *writebacks;    // lines written to memory, per owning thread
+
+    // The line the last access wrote back to memory, if any: a dirty
+    // victim or a writeback that the policy bypassed
+    bool     wbPending;
+    Addr_t   wbAddr;
+    UINT32   wbOwner;
+
+    // Inclusion (EnableInclusion). Inclusive: the valid line the last
+    // access evicted and its sharing_dir, the threads that referenced it
+    // since its fill and so may hold it above. Exclusive: whether the line
+    // the last demand hit handed to the level above was dirty
+    UINT32    inclusion;
+    bool      evPending;
+    Addr_t    evAddr;
+    BITVECTOR evPresence;
+    bool      movedDirty;
+
+    // Exclusive: the lines InsertVictim took from the level above, among
+    // the WRITEBACK accesses, and how many of them were clean
+    COUNTER   victimInserts;
+    COUNTER   cleanInserts;
 
     // Lookup Parameters
     UINT32 lineShift;
@@ -53,26 +100,146 @@ class CRC_CACHE
     UINT32 indexMask;
 
     COUNTER mytimer; 
+
+    // References before the statistics started, those of the warm-up run
+    // of a loaded snapshot
+    COUNTER warmRefs;
+
+    // Set sampling: of every group of sampleRatio consecutive sets only the
+    // one at sampleOffset[group] (picked by a hash) is modelled, and the
+    // modelled sets are stored densely as slots 0..numSampled-1
+    UINT32   sampleRatio;
+    UINT32   sampleShift;
+    UINT32   numSampled;
+    UINT32  *sampleOffset;
+
+    // Sampled mode only: demand references of every set per thread, and
+    // demand lookups and misses per slot and thread (slot-major) for the
+    // extrapolation
+    COUNTER *demandRefs;
+    COUNTER *slotLookups;
+    COUNTER *slotMisses;
+
+    // Prefetch statistics: per set the ways filled by a prefetch and not
+    // used on demand since, and the tags of lines that prefetch fills
+    // evicted, to find the demand misses they caused (assoc entries per set
+    // picked by a hash of the tag, PF_NO_KEY when empty)
+    BITVECTOR *prefetchMask;
+    Addr_t    *pollutionFilter;
+    COUNTER    pfFills;
+    COUNTER    pfUseful;        // first demand hits of prefetched lines
+    COUNTER    pfUseless;       // prefetched lines evicted before any
+    COUNTER    pfPolluted;      // demand misses to lines a prefetch evicted
+    COUNTER    pfMergedResident;
     
   public:
 
     CRC_CACHE( UINT32 _cacheSize, UINT32 _assoc, UINT32 _tpc, UINT32 _linesize=64, UINT32 _pol=CRC_REPL_LRU );
 
+    // Models 1 of every _sampleRatio sets, a power of two, to estimate the
+    // whole cache. The five-argument form models every set
+    CRC_CACHE( UINT32 _cacheSize, UINT32 _assoc, UINT32 _tpc, UINT32 _linesize, UINT32 _pol,
+               UINT32 _sampleRatio );
+
     bool   CacheInspect( UINT32 tid, Addr_t PC, Addr_t paddr, UINT32 accessType );
     bool   LookupAndFillCache( UINT32 tid, Addr_t PC, Addr_t paddr, UINT32 accessType );
     ostream &   PrintStats(ostream &out);
 
+    CACHE_REPLACEMENT_STATE *ReplacementState() { return cacheReplState; }
+    void   MergeStats( const CRC_CACHE *other );
+
+    // Collects reuse and dead-block diagnostics, printed with the
+    // replacement statistics. Must be called before the first access
+    void   EnableDiagnostics();
+
+    // Tracks the lines filled by ACCESS_PREFETCH references to their first
+    // demand hit or their eviction and prints their accuracy, coverage and
+    // pollution. Must be called before the first access
+    void   EnablePrefetchStats();
+
+    // Sets the inclusion of the cache (LLCInclusion). Must be called before
+    // the first access, and not with set sampling
+    void   EnableInclusion( UINT32 _inclusion );
+    UINT32 Inclusion() { return inclusion; }
+
+    // Exclusive: a line evicted from the level above fills the cache like a
+    // writeback, clean unless dirty or already dirty in the cache. Returns
+    // true if it was already cached
+    bool   InsertVictim( UINT32 tid, Addr_t paddr, bool dirty );
+
+    // Inclusive: takes the line evicted by the last access and the threads
+    // that may hold it above. False if the access evicted no valid line
+    bool   TakeEviction( Addr_t *paddr, BITVECTOR *presence )
+    {
+        if( !evPending ) return false;
+
+        *paddr    = evAddr;
+        *presence = evPresence;
+        evPending = false;
+
+        return true;
+    }
+
+    // Exclusive: whether the line the last demand hit moved up was dirty
+    bool   TakeMovedDirty()
+    {
+        bool dirty = movedDirty;
+
+        movedDirty = false;
+
+        return dirty;
+    }
+
+    // Warm-cache snapshots (see crc_snapshot.h). Save writes the header and
+    // the sections of the cache; Load reads the sections that follow a
+    // header that Matches, of this or another policy, and false if the file
+    // ends first. A cache with diagnostics, in epoch mode or running OPT
+    // takes no part in snapshots
+    bool   SaveSnapshot( FILE *file );
+    bool   SnapshotMatches( const CRC_SNAPSHOT_HEADER *header );
+    bool   LoadSnapshot( FILE *file, const CRC_SNAPSHOT_HEADER *header );
+    COUNTER WarmReferences() { return warmRefs; }
+
+    // Takes the line written back to memory by the last access, with the
+    // thread that owned it. False if the access wrote nothing back
+    bool   TakeWriteback( Addr_t *paddr, UINT32 *owner )
+    {
+        if( !wbPending ) return false;
+
+        *paddr    = wbAddr;
+        *owner    = wbOwner;
+        wbPending = false;
+
+        return true;
+    }
+
   private:
 
     Addr_t GetTag( Addr_t addr ) { return ((addr >> lineShift) >> indexShift); }
     UINT32 GetSetIndex( Addr_t addr ) { return ((addr >> lineShift) & indexMask); }
+    LINE_STATE *GetSet( UINT32 setIndex ) { return &cache[ setIndex * assoc ]; }
+    bool   SampledSet( UINT32 setIndex ) 
+    { 
+        return (setIndex & (sampleRatio - 1)) == sampleOffset[ setIndex >> sampleShift ]; 
+    }
 
+    void   Init( UINT32 _cacheSize, UINT32 _assoc, UINT32 _tpc, UINT32 _linesize, UINT32 _pol,
+                 UINT32 _sampleRatio );
     void   InitCache();
     void   InitCacheReplacementState();
+    void   InitAccessPath();
 
     void   InitStats();
+    UINT32 SnapshotArrays( CRC_SNAPSHOT_ARRAY *arrays );
 
     INT32  LookupSet( UINT32 setIndex, Addr_t tag );
+    template <UINT32 POLICY>
+    ACCESS_PATH PolicyAccessPath();
+    template <UINT32 POLICY, bool DIAG, bool PF>
+    bool   LookupAndFill( UINT32 tid, Addr_t PC, Addr_t paddr, UINT32 accessType );
+    template <UINT32 POLICY, bool DIAG>
+    ACCESS_PATH DiagAccessPath();
+    template <UINT32 POLICY>
     INT32  GetVictimInSet( UINT32 tid, UINT32 setIndex, Addr_t PC, Addr_t paddr, UINT32 accessType );
 
   public:
@@ -99,6 +266,30 @@ class CRC_CACHE
         return stat;
     }
 
+    COUNTER ThreadWritebackStats( UINT32 tid ) { return writebacks[tid]; }
+
+    // In sampled mode the stats above cover the sampled sets only; these
+    // cover every set, estimated from the sampled ones
+    UINT32  SampleRatio() { return sampleRatio; }
+
+    COUNTER ThreadDemandReferences( UINT32 tid )
+    {
+        return (sampleRatio > 1) ? demandRefs[tid] : ThreadDemandLookupStats(tid);
+    }
+
+    double  ThreadDemandMissEstimate( UINT32 tid, double *halfWidth=NULL );
+
+  private:
+
+    Addr_t *PollutionEntry( UINT32 setIndex, Addr_t tag ) 
+    { 
+        return &pollutionFilter[ setIndex * assoc + CRC_Mix64( tag ) % assoc ]; 
+    }
+    inline void TrackFill( UINT32 setIndex, INT32 way, UINT32 accessType );
+    inline Addr_t LineAddr( UINT32 setIndex, Addr_t tag );
+    inline void WriteBack( UINT32 setIndex, Addr_t tag, UINT32 owner );
+    ostream &   PrintPrefetchStats( ostream &out );
+
 };
 
 #endif
@@ -0,0 +1,86 @@
+#ifndef CRC_SNAPSHOT_H
+#define CRC_SNAPSHOT_H
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Warm-cache snapshots: the state of one or more CRC_CACHEs at the end of a  //
+// warm-up run, which later runs load to start from warm caches instead of    //
+// repeating the warm-up. Loading reads every array straight into place.      //
+//                                                                            //
+// A snapshot file is a CRC_SNAPSHOT_FILE header and then, per cache, a       //
+// CRC_SNAPSHOT_HEADER and bytes bytes of sections, in host byte order:       //
+//                                                                            //
+//     cache    references, the lines (LINE_STATE), tag shadow, valid masks   //
+//     common   the replacement state every policy keeps: references, the     //
+//              rand() stream, the LRU stacks (packed, or the per-line ages   //
+//              above 16 ways), the CLOCK used masks and hands                //
+//     policy   the state of the cache's own policy: PSEL, the RRPV planes,   //
+//              the SHiP counters and signatures, the UCP monitors and        //
+//              ownership masks                                               //
+//                                                                            //
+// A cache of another policy takes the cache and common sections and starts   //
+// its own state cold. Statistics are not kept: a loaded cache counts from    //
+// the references it had seen, its reset point.                               //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#include <cstdio>
+#include "utils.h"
+
+#define CRC_SNAPSHOT_MAGIC      "CRCSNAP1"
+#define CRC_SNAPSHOT_VERSION    1
+
+typedef struct
+{
+    char        magic[ 8 ];
+    UINT32      version;
+    UINT32      count;          // caches
+} CRC_SNAPSHOT_FILE;
+
+// Geometry and policy of one cache, and the size of its sections
+typedef struct
+{
+    UINT32      numsets;
+    UINT32      assoc;
+    UINT32      threads;
+    UINT32      linesize;
+    UINT32      replPolicy;
+    UINT32      sampleRatio;
+    COUNTER     bytes;
+} CRC_SNAPSHOT_HEADER;
+
+#define CRC_SNAPSHOT_MAX_ARRAYS 16     // per section
+
+// One array of a section, saved and loaded as it is in memory
+typedef struct
+{
+    void       *data;
+    size_t      bytes;
+} CRC_SNAPSHOT_ARRAY;
+
+static inline COUNTER CRC_SnapshotBytes(const CRC_SNAPSHOT_ARRAY *arrays, UINT32 count)
+{
+    COUNTER bytes = 0;
+
+    for (UINT32 a = 0; a < count; a++) bytes += arrays[a].bytes;
+
+    return bytes;
+}
+
+// Writes the arrays in order, or reads them back in place if load.
+// @returns false if the file ended or could not be written.
+static inline bool CRC_SnapshotArrays(FILE *file, const CRC_SNAPSHOT_ARRAY *arrays, UINT32 count, bool load)
+{
+    for (UINT32 a = 0; a < count; a++)
+    {
+        size_t done = load ? fread(arrays[a].data, 1, arrays[a].bytes, file)
+                           : fwrite(arrays[a].data, 1, arrays[a].bytes, file);
+
+        if (done != arrays[a].bytes) return false;
+    }
+
+    return true;
+}
+
+#endif
@@ -0,0 +1,176 @@
+#include "dram_model.h"
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// A simple DRAM model behind the LLC (see dram_model.h).                     //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+DRAM_MODEL::DRAM_MODEL( UINT32 _channels, UINT32 _banks, UINT32 _rowSize, UINT32 _threads, UINT32 _linesize )
+{
+    assert( _channels && _channels <= DRAM_MAX_CHANNELS && (_channels & (_channels - 1)) == 0 );
+    assert( _banks && _banks <= DRAM_MAX_BANKS && (_banks & (_banks - 1)) == 0 );
+    assert( _rowSize >= _linesize && _rowSize <= DRAM_MAX_ROW_SIZE && (_rowSize & (_rowSize - 1)) == 0 );
+
+    channels = _channels;
+    banks    = _banks;
+    rowSize  = _rowSize;
+    threads  = _threads;
+    linesize = _linesize;
+
+    lineShift    = CRC_FloorLog2( linesize );
+    channelShift = CRC_FloorLog2( channels );
+    columnShift  = CRC_FloorLog2( rowSize / linesize );
+    bankShift    = CRC_FloorLog2( banks );
+
+    bankState = (DRAM_BANK *) CRC_AlignedCalloc( channels * banks, sizeof(DRAM_BANK) );
+    busFreeAt = (COUNTER *) CRC_AlignedCalloc( channels, sizeof(COUNTER) );
+    busBusy   = (COUNTER *) CRC_AlignedCalloc( channels, sizeof(COUNTER) );
+    perThread = (DRAM_THREAD *) CRC_AlignedCalloc( threads, sizeof(DRAM_THREAD) );
+
+    assert( bankState && busFreeAt && busBusy && perThread );
+
+    lastDone = 0;
+}
+
+UINT32 DRAM_MODEL::Read( UINT32 tid, Addr_t paddr, COUNTER now, bool blocking )
+{
+    DRAM_THREAD *stats = &perThread[ tid ];
+    COUNTER      queueing;
+    UINT32       latency = DRAM_T_OVERHEAD + (UINT32) Schedule( stats, paddr, now, &queueing );
+
+    stats->reads++;
+    stats->readLatency += latency;
+
+    if( blocking )
+    {
+        stats->stall    += latency;
+        stats->queueing += queueing;
+    }
+
+    return latency;
+}
+
+void DRAM_MODEL::Write( UINT32 tid, Addr_t paddr, COUNTER now )
+{
+    DRAM_THREAD *stats = &perThread[ tid ];
+    COUNTER      queueing;
+
+    Schedule( stats, paddr, now, &queueing );
+    stats->writes++;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Runs one request through its bank and channel. Returns the cycles from     //
+// now to the end of its data transfer; queueing receives the part of them    //
+// spent waiting for the bank and the bus.                                    //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+COUNTER DRAM_MODEL::Schedule( DRAM_THREAD *stats, Addr_t paddr, COUNTER now, COUNTER *queueing )
+{
+    Addr_t line    = paddr >> lineShift;
+    UINT32 channel = line & (channels - 1);
+    Addr_t rows    = line >> (channelShift + columnShift);     // rows of the channel, over all banks
+    UINT32 bank    = (rows ^ (rows >> bankShift)) & (banks - 1);
+    Addr_t row     = rows >> bankShift;
+
+    DRAM_BANK *state = &bankState[ channel * banks + bank ];
+    COUNTER    start = WaitFor( now, state->readyAt );
+    COUNTER    access;
+
+    if( state->open && state->openRow == row )
+    {
+        access = DRAM_T_CAS;
+        stats->rowHits++;
+    }
+    else if( !state->open )
+    {
+        access = DRAM_T_RCD + DRAM_T_CAS;
+        stats->rowEmpty++;
+    }
+    else
+    {
+        access = DRAM_T_RP + DRAM_T_RCD + DRAM_T_CAS;
+        stats->rowConflicts++;
+    }
+
+    state->open    = true;
+    state->openRow = row;
+
+    COUNTER ready = start + access;
+    COUNTER burst = WaitFor( ready, busFreeAt[ channel ] );
+    COUNTER done  = burst + DRAM_T_BURST;
+
+    if( ready > state->readyAt ) state->readyAt = ready;
+    if( done > busFreeAt[ channel ] ) busFreeAt[ channel ] = done;
+    if( done > lastDone ) lastDone = done;
+
+    busBusy[ channel ] += DRAM_T_BURST;
+
+    *queueing = (start - now) + (burst - ready);
+
+    return done - now;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Traffic and row-buffer locality over all threads, the share of the         //
+// channels' time their data buses were busy, and per thread its traffic      //
+// and the cycles it stalled on reads, with the part of them spent queueing   //
+// behind other requests: the stall that comes from limited bandwidth.        //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+ostream & DRAM_MODEL::PrintStats( ostream &out )
+{
+    DRAM_THREAD total;
+    COUNTER     busy = 0;
+
+    memset( &total, 0, sizeof(total) );
+
+    for(UINT32 t=0; t<threads; t++)
+    {
+        total.reads        += perThread[t].reads;
+        total.writes       += perThread[t].writes;
+        total.rowHits      += perThread[t].rowHits;
+        total.rowEmpty     += perThread[t].rowEmpty;
+        total.rowConflicts += perThread[t].rowConflicts;
+        total.readLatency  += perThread[t].readLatency;
+    }
+
+    for(UINT32 c=0; c<channels; c++)
+    {
+        busy += busBusy[c];
+    }
+
+    COUNTER requests = total.reads + total.writes;
+
+    out<<"DRAM Statistics: "<<channels<<" channels, "<<banks<<" banks per channel, "<<rowSize<<"B rows"<<endl;
+    out<<"\tReads:          "<<total.reads<<endl;
+    out<<"\tWrites:         "<<total.writes<<endl;
+    out<<"\tBytes Moved:    "<<requests * linesize<<endl;
+    out<<"\tRow Hits:       "<<total.rowHits<<endl;
+    out<<"\tRow Empty:      "<<total.rowEmpty<<endl;
+    out<<"\tRow Conflicts:  "<<total.rowConflicts<<endl;
+    out<<"\tRow Hit Rate:   "<<(requests ? (double)total.rowHits/(double)requests*100.0 : 0.0)<<endl;
+    out<<"\tRead Latency:   "<<(total.reads ? (double)total.readLatency/(double)total.reads : 0.0)<<endl;
+    out<<"\tBus Utilization: "<<(lastDone ? (double)busy/(double)(channels * lastDone)*100.0 : 0.0)<<endl;
+    out<<endl;
+
+    for(UINT32 t=0; t<threads; t++)
+    {
+        DRAM_THREAD *stats = &perThread[t];
+        COUNTER      own   = stats->reads + stats->writes;
+
+        if( own == 0 ) continue;
+
+        out<<"\tThread: "<<t<<" Reads: "<<stats->reads<<" Writes: "<<stats->writes
+           <<" Bytes: "<<own * linesize
+           <<" Row Hit Rate: "<<(double)stats->rowHits/(double)own*100.0
+           <<" Stall Cycles: "<<stats->stall<<" Queueing: "<<stats->queueing<<endl;
+    }
+    out<<endl;
+
+    return out;
+}
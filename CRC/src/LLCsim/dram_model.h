@@ -0,0 +1,109 @@
+#ifndef DRAM_MODEL_H
+#define DRAM_MODEL_H
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// A simple DRAM model behind the LLC: the fills of LLC misses and the lines  //
+// the LLC writes back go to channels of banks with open-row buffers.         //
+//                                                                            //
+// Consecutive lines alternate between the channels; within a channel a row   //
+// holds consecutive lines, and rows go round the banks with the bank index   //
+// XORed with the low row bits so that rows a power of two apart do not all   //
+// conflict in one bank. Rows stay open until a request for another row of    //
+// the bank closes them (open-page policy).                                   //
+//                                                                            //
+// Every request waits for its bank, spends tCAS on a row hit, tRCD + tCAS    //
+// on a closed bank and tRP + tRCD + tCAS on a row conflict, then waits for   //
+// the channel's data bus and holds it for tBURST. A read's latency adds      //
+// DRAM_T_OVERHEAD for the way through the controller and back; writes are    //
+// posted and stall nobody but take bank and bus time from the reads. All     //
+// times are in core cycles, for a DDR3-1600 channel next to a 3.2GHz core.   //
+//                                                                            //
+// Requests come with the cycle count of the thread that sends them, and      //
+// the threads of a mix can run ahead of each other in cycles. A request      //
+// waits for a bank or bus that is busy up to DRAM_WINDOW cycles past its     //
+// own time; one that far behind counts as scheduled in an earlier gap.       //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#include <cassert>
+#include "utils.h"
+
+#define DRAM_MAX_CHANNELS   8
+#define DRAM_MAX_BANKS      32
+#define DRAM_MAX_ROW_SIZE   (64*1024)
+
+#define DRAM_T_CAS          44
+#define DRAM_T_RCD          44
+#define DRAM_T_RP           44
+#define DRAM_T_BURST        16      // one 64B line at 12.8GB/s
+#define DRAM_T_OVERHEAD     100
+#define DRAM_WINDOW         4096
+
+// One bank and its row buffer
+typedef struct
+{
+    Addr_t      openRow;
+    bool        open;
+    COUNTER     readyAt;    // cycle it takes the next command
+} DRAM_BANK;
+
+// The requests of one thread
+typedef struct
+{
+    COUNTER     reads;
+    COUNTER     writes;
+    COUNTER     rowHits;
+    COUNTER     rowEmpty;       // bank closed
+    COUNTER     rowConflicts;   // another row open
+    COUNTER     readLatency;    // sum over the reads
+    COUNTER     stall;          // sum over the reads the thread waited on
+    COUNTER     queueing;       // ... of it spent waiting for a bank or bus
+} DRAM_THREAD;
+
+class DRAM_MODEL
+{
+  private:
+
+    UINT32      channels;
+    UINT32      banks;
+    UINT32      rowSize;
+    UINT32      threads;
+    UINT32      linesize;
+
+    UINT32      lineShift;
+    UINT32      channelShift;
+    UINT32      columnShift;    // lines per row
+    UINT32      bankShift;
+
+    DRAM_BANK  *bankState;      // channel-major, channels x banks
+    COUNTER    *busFreeAt;      // per channel
+    COUNTER    *busBusy;        // cycles of data transfers, per channel
+    DRAM_THREAD *perThread;
+    COUNTER     lastDone;       // latest completion, the span of the run
+
+  public:
+
+    DRAM_MODEL( UINT32 _channels, UINT32 _banks, UINT32 _rowSize, UINT32 _threads, UINT32 _linesize=64 );
+
+    // A line read for thread tid at cycle now, returns its latency. The
+    // latency of a blocking read counts as a stall of the thread
+    UINT32      Read( UINT32 tid, Addr_t paddr, COUNTER now, bool blocking );
+    void        Write( UINT32 tid, Addr_t paddr, COUNTER now );
+
+    COUNTER     Stall( UINT32 tid ) { return perThread[ tid ].stall; }
+
+    ostream &   PrintStats( ostream &out );
+
+  private:
+
+    COUNTER     Schedule( DRAM_THREAD *stats, Addr_t paddr, COUNTER now, COUNTER *queueing );
+
+    static COUNTER WaitFor( COUNTER now, COUNTER busyUntil )
+    {
+        return (busyUntil > now && busyUntil - now <= DRAM_WINDOW) ? busyUntil : now;
+    }
+};
+
+#endif
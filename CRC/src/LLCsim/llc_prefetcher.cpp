@@ -0,0 +1,259 @@
+#include "llc_prefetcher.h"
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Hardware prefetchers in front of the LLC (see llc_prefetcher.h).           //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+static const char *pf_type_names[] =
+{
+    "none",
+    "nextline",
+    "stride",
+    "stream"
+};
+
+// Defaults per type: degree, distance
+static const UINT32 pf_defaults[ PF_MAX ][ 2 ] =
+{
+    { 0, 0 },
+    { 1, 1 },
+    { 2, 1 },
+    { 4, 16 }
+};
+
+LLC_PREFETCHER::LLC_PREFETCHER( UINT32 _type, UINT32 _degree, UINT32 _distance, UINT32 _linesize )
+{
+    assert( _type > PF_NONE && _type < PF_MAX );
+
+    type      = _type;
+    degree    = _degree ? _degree : DefaultDegree( type );
+    distance  = _distance ? _distance : DefaultDistance( type );
+    lineShift = CRC_FloorLog2( _linesize );
+
+    assert( degree <= PF_MAX_DEGREE && distance <= PF_MAX_DISTANCE );
+
+    strides = (PF_STRIDE_ENTRY *) CRC_AlignedCalloc( PF_STRIDE_ENTRIES, sizeof(PF_STRIDE_ENTRY) );
+    streams = (PF_STREAM_TRACKER *) CRC_AlignedCalloc( PF_STREAM_TRACKERS, sizeof(PF_STREAM_TRACKER) );
+
+    assert( strides && streams );
+
+    timer      = 0;
+    trainings  = 0;
+    triggers   = 0;
+    candidates = 0;
+}
+
+bool LLC_PREFETCHER::ParseType( const char *name, UINT32 *type )
+{
+    for(UINT32 t=0; t<PF_MAX; t++)
+    {
+        if( string( name ) == pf_type_names[t] )
+        {
+            *type = t;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+const char * LLC_PREFETCHER::TypeName( UINT32 type )
+{
+    return (type < PF_MAX) ? pf_type_names[ type ] : "unknown";
+}
+
+UINT32 LLC_PREFETCHER::DefaultDegree( UINT32 type )
+{
+    return (type < PF_MAX) ? pf_defaults[ type ][0] : 0;
+}
+
+UINT32 LLC_PREFETCHER::DefaultDistance( UINT32 type )
+{
+    return (type < PF_MAX) ? pf_defaults[ type ][1] : 0;
+}
+
+UINT32 LLC_PREFETCHER::Train( Addr_t PC, Addr_t paddr, UINT32 accessType, Addr_t *pf )
+{
+    Addr_t line = paddr >> lineShift;
+    UINT32 n    = 0;
+
+    trainings++;
+
+    switch( type )
+    {
+      case PF_NEXTLINE: n = NextLine( line, pf );                    break;
+      case PF_STRIDE:   n = Stride( PC, line, accessType, pf );      break;
+      case PF_STREAM:   n = Stream( line, pf );                      break;
+
+      default:
+        assert(0);
+    }
+
+    triggers   += (n != 0);
+    candidates += n;
+
+    // Line numbers to addresses
+    for(UINT32 p=0; p<n; p++)
+    {
+        pf[p] <<= lineShift;
+    }
+
+    return n;
+}
+
+UINT32 LLC_PREFETCHER::NextLine( Addr_t line, Addr_t *pf )
+{
+    for(UINT32 p=0; p<degree; p++)
+    {
+        pf[p] = line + distance + p;
+    }
+
+    return degree;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// A PC's entry learns the stride between the lines of its last two           //
+// accesses; a new stride replaces it and resets the confidence, a repeat     //
+// raises it. References to the line of the last access teach nothing.        //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+UINT32 LLC_PREFETCHER::Stride( Addr_t PC, Addr_t line, UINT32 accessType, Addr_t *pf )
+{
+    if( accessType == ACCESS_IFETCH ) return 0;
+
+    PF_STRIDE_ENTRY *entry = &strides[ CRC_Mix64( PC ) & (PF_STRIDE_ENTRIES - 1) ];
+
+    if( !entry->valid || entry->PC != PC )
+    {
+        entry->valid      = true;
+        entry->PC         = PC;
+        entry->lastLine   = line;
+        entry->stride     = 0;
+        entry->confidence = 0;
+        return 0;
+    }
+
+    long long stride = (long long) (line - entry->lastLine);
+
+    if( stride == 0 ) return 0;
+
+    if( stride == entry->stride )
+    {
+        if( entry->confidence < PF_STRIDE_CONFIDENT ) entry->confidence++;
+    }
+    else
+    {
+        entry->stride     = stride;
+        entry->confidence = 0;
+    }
+
+    entry->lastLine = line;
+
+    if( entry->confidence < PF_STRIDE_CONFIDENT ) return 0;
+
+    for(UINT32 p=0; p<degree; p++)
+    {
+        pf[p] = line + (Addr_t) (stride * (long long) (distance + p));
+    }
+
+    return degree;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// An access continues the first stream whose last access is within           //
+// PF_STREAM_WINDOW lines of it, or takes the least recently used tracker.    //
+// Every step in the stream's direction trains it and a step against it       //
+// starts the stream over in the new direction. A trained stream prefetches   //
+// from where its prefetches stopped, or just past the access if that has     //
+// overtaken them, up to distance lines ahead of the access.                  //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+UINT32 LLC_PREFETCHER::Stream( Addr_t line, Addr_t *pf )
+{
+    PF_STREAM_TRACKER *stream = NULL;
+    PF_STREAM_TRACKER *lru    = &streams[0];
+
+    timer++;
+
+    for(UINT32 t=0; t<PF_STREAM_TRACKERS; t++)
+    {
+        PF_STREAM_TRACKER *tracker = &streams[t];
+        long long          delta   = (long long) (line - tracker->lastLine);
+
+        if( tracker->valid && delta >= -PF_STREAM_WINDOW && delta <= PF_STREAM_WINDOW )
+        {
+            stream = tracker;
+            break;
+        }
+
+        if( !tracker->valid || (lru->valid && tracker->lastUse < lru->lastUse) )
+        {
+            lru = tracker;
+        }
+    }
+
+    if( stream == NULL )
+    {
+        lru->valid     = true;
+        lru->lastLine  = line;
+        lru->nextLine  = line;
+        lru->direction = 0;
+        lru->steps     = 0;
+        lru->lastUse   = timer;
+        return 0;
+    }
+
+    long long delta = (long long) (line - stream->lastLine);
+
+    stream->lastUse = timer;
+
+    if( delta == 0 ) return 0;
+
+    INT32 direction = (delta > 0) ? 1 : -1;
+
+    if( direction == stream->direction )
+    {
+        if( stream->steps < PF_STREAM_TRAINED ) stream->steps++;
+    }
+    else
+    {
+        stream->direction = direction;
+        stream->steps     = 1;
+        stream->nextLine  = line + direction;
+    }
+
+    stream->lastLine = line;
+
+    if( stream->steps < PF_STREAM_TRAINED ) return 0;
+
+    if( (long long) (stream->nextLine - line) * direction <= 0 )
+    {
+        stream->nextLine = line + direction;
+    }
+
+    UINT32 n = 0;
+
+    while( n < degree && (long long) (stream->nextLine - line) * direction <= (long long) distance )
+    {
+        pf[ n++ ] = stream->nextLine;
+        stream->nextLine += direction;
+    }
+
+    return n;
+}
+
+ostream & LLC_PREFETCHER::PrintStats( ostream &out )
+{
+    out<<"Prefetcher: "<<TypeName( type )<<", degree "<<degree<<", distance "<<distance<<endl;
+    out<<"\tTrained:        "<<trainings<<endl;
+    out<<"\tTriggered:      "<<triggers<<endl;
+    out<<"\tCandidates:     "<<candidates<<endl;
+    out<<endl;
+
+    return out;
+}
@@ -0,0 +1,109 @@
+#ifndef LLC_PREFETCHER_H
+#define LLC_PREFETCHER_H
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Hardware prefetchers in front of the LLC. A prefetcher trains on the       //
+// demand references that reach the LLC and answers each with the line        //
+// addresses to prefetch, which the caller sends to LookupAndFillCache as     //
+// ACCESS_PREFETCH references; CRC_CACHE tracks the prefetched lines.         //
+//                                                                            //
+//   nextline   the degree lines that start distance lines past the access    //
+//   stride     per PC (a reference prediction table): once the PC has        //
+//              repeated its stride between lines, the degree lines that      //
+//              start distance strides past the access. Instruction fetches   //
+//              do not train it                                               //
+//   stream     trackers for accesses that move through nearby lines in one   //
+//              direction; a trained stream keeps its prefetches up to        //
+//              distance lines ahead of the access, at most degree new        //
+//              lines per access                                              //
+//                                                                            //
+// A degree or distance of 0 picks the default of the prefetcher.             //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#include <cassert>
+#include "utils.h"
+#include "crc_cache_defs.h"
+
+#define PF_MAX_DEGREE       16
+#define PF_MAX_DISTANCE     256
+#define PF_STRIDE_ENTRIES   256     // reference prediction table, direct mapped
+#define PF_STRIDE_CONFIDENT 2       // repeats of a stride before it prefetches
+#define PF_STREAM_TRACKERS  32
+#define PF_STREAM_WINDOW    16      // lines from a stream's last access that continue it
+#define PF_STREAM_TRAINED   2       // steps in one direction before it prefetches
+
+typedef enum
+{
+    PF_NONE      = 0,
+    PF_NEXTLINE  = 1,
+    PF_STRIDE    = 2,
+    PF_STREAM    = 3,
+    PF_MAX       = 4
+} PrefetcherTypes;
+
+// One PC of the reference prediction table
+typedef struct
+{
+    Addr_t      PC;
+    Addr_t      lastLine;
+    long long   stride;         // in lines
+    UINT32      confidence;
+    bool        valid;
+} PF_STRIDE_ENTRY;
+
+// One stream being tracked
+typedef struct
+{
+    Addr_t      lastLine;       // of its last access
+    Addr_t      nextLine;       // next line to prefetch
+    INT32       direction;      // +1, -1, 0 until the second access
+    UINT32      steps;          // accesses in direction, saturating
+    COUNTER     lastUse;        // for the LRU replacement of trackers
+    bool        valid;
+} PF_STREAM_TRACKER;
+
+class LLC_PREFETCHER
+{
+  private:
+
+    UINT32      type;
+    UINT32      degree;
+    UINT32      distance;
+    UINT32      lineShift;
+
+    PF_STRIDE_ENTRY   *strides;
+    PF_STREAM_TRACKER *streams;
+    COUNTER            timer;
+
+    // statistics
+    COUNTER     trainings;      // demand references seen
+    COUNTER     triggers;       // ... that prefetched
+    COUNTER     candidates;     // lines prefetched
+
+  public:
+
+    LLC_PREFETCHER( UINT32 _type, UINT32 _degree, UINT32 _distance, UINT32 _linesize=64 );
+
+    // Trains on a demand reference and writes the addresses of up to
+    // degree lines to prefetch to pf. Returns their number
+    UINT32      Train( Addr_t PC, Addr_t paddr, UINT32 accessType, Addr_t *pf );
+
+    UINT32      Type() { return type; }
+    ostream &   PrintStats( ostream &out );
+
+    static bool ParseType( const char *name, UINT32 *type );
+    static const char * TypeName( UINT32 type );
+    static UINT32 DefaultDegree( UINT32 type );
+    static UINT32 DefaultDistance( UINT32 type );
+
+  private:
+
+    UINT32      NextLine( Addr_t line, Addr_t *pf );
+    UINT32      Stride( Addr_t PC, Addr_t line, UINT32 accessType, Addr_t *pf );
+    UINT32      Stream( Addr_t line, Addr_t *pf );
+};
+
+#endif
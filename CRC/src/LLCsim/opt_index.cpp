@@ -0,0 +1,224 @@
+#include "opt_index.h"
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Next-use index for the Belady OPT policy (see opt_index.h).                //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#define OPT_EMPTY_LINE  (~0ULL)
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Starts recording. The line addresses go to <indexName>.lines, which is     //
+// removed once the index is built.                                           //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+bool OPT_INDEX_WRITER::Open( const char *_indexName )
+{
+    indexName  = _indexName;
+    linesName  = indexName + ".lines";
+    lines      = fopen( linesName.c_str(), "w+b" );
+    references = 0;
+    bufLen     = 0;
+
+    return lines != NULL;
+}
+
+bool OPT_INDEX_WRITER::Flush()
+{
+    bool ok = (fwrite( buf, sizeof(Addr_t), bufLen, lines ) == bufLen);
+
+    bufLen = 0;
+
+    return ok;
+}
+
+// Line -> index of its next reference, open addressing, at most half full
+typedef struct
+{
+    Addr_t  *lines;
+    COUNTER *next;
+    UINT32   capacity;
+    UINT32   count;
+} OPT_NEXT_MAP;
+
+static void InitNextMap( OPT_NEXT_MAP *map, UINT32 capacity )
+{
+    map->capacity = capacity;
+    map->count    = 0;
+    map->lines    = (Addr_t *) malloc( capacity * sizeof(Addr_t) );
+    map->next     = (COUNTER *) malloc( capacity * sizeof(COUNTER) );
+
+    assert( map->lines && map->next );
+
+    memset( map->lines, 0xff, capacity * sizeof(Addr_t) );
+}
+
+// Slot holding line, or the empty slot where it belongs
+static UINT32 FindNextSlot( const OPT_NEXT_MAP *map, Addr_t line )
+{
+    UINT32 mask = map->capacity - 1;
+    UINT32 slot = CRC_Mix64( line ) & mask;
+
+    while( map->lines[ slot ] != line && map->lines[ slot ] != OPT_EMPTY_LINE )
+    {
+        slot = (slot + 1) & mask;
+    }
+
+    return slot;
+}
+
+static void GrowNextMap( OPT_NEXT_MAP *map )
+{
+    OPT_NEXT_MAP old = *map;
+
+    InitNextMap( map, 2 * old.capacity );
+
+    for(UINT32 s=0; s<old.capacity; s++)
+    {
+        if( old.lines[s] == OPT_EMPTY_LINE ) continue;
+
+        UINT32 slot = FindNextSlot( map, old.lines[s] );
+
+        map->lines[ slot ] = old.lines[s];
+        map->next[ slot ]  = old.next[s];
+        map->count++;
+    }
+
+    free( old.lines );
+    free( old.next );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// The backward pass. Blocks of recorded lines are read from the end of the   //
+// stream; within a block the references are visited last to first with a     //
+// map from line to the index of its next reference, and the block's          //
+// distances are written at the block's offset in the index.                  //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+bool OPT_INDEX_WRITER::Finish()
+{
+    if( !Flush() || fflush( lines ) != 0 )
+    {
+        return false;
+    }
+
+    FILE *index = fopen( indexName.c_str(), "wb" );
+
+    if( index == NULL )
+    {
+        return false;
+    }
+
+    OPT_NEXT_MAP map;
+    UINT32      *dist = (UINT32 *) malloc( OPT_INDEX_BLOCK * sizeof(UINT32) );
+    bool         ok   = true;
+
+    InitNextMap( &map, 1 << 16 );
+    assert( dist );
+
+    for(COUNTER end = references; end > 0 && ok; )
+    {
+        UINT32  n     = (end > OPT_INDEX_BLOCK) ? OPT_INDEX_BLOCK : (UINT32) end;
+        COUNTER start = end - n;
+
+        if( fseeko( lines, start * sizeof(Addr_t), SEEK_SET ) != 0
+            || fread( buf, sizeof(Addr_t), n, lines ) != n )
+        {
+            ok = false;
+            break;
+        }
+
+        for(UINT32 i=n; i-- > 0; )
+        {
+            COUNTER ref = start + i;
+
+            if( 2 * (map.count + 1) > map.capacity )
+            {
+                GrowNextMap( &map );
+            }
+
+            UINT32 slot = FindNextSlot( &map, buf[i] );
+
+            if( map.lines[ slot ] == buf[i] )
+            {
+                COUNTER distance = map.next[ slot ] - ref;
+
+                dist[i] = (distance > 0xffffffffULL) ? 0xffffffffU : (UINT32) distance;
+            }
+            else
+            {
+                dist[i] = 0;
+
+                map.lines[ slot ] = buf[i];
+                map.count++;
+            }
+
+            map.next[ slot ] = ref;
+        }
+
+        if( fseeko( index, start * sizeof(UINT32), SEEK_SET ) != 0
+            || fwrite( dist, sizeof(UINT32), n, index ) != n )
+        {
+            ok = false;
+        }
+
+        end = start;
+    }
+
+    free( map.lines );
+    free( map.next );
+    free( dist );
+
+    fclose( lines );
+    remove( linesName.c_str() );
+    lines = NULL;
+
+    if( fclose( index ) != 0 )
+    {
+        ok = false;
+    }
+
+    return ok;
+}
+
+void OPT_INDEX_WRITER::Abort()
+{
+    if( lines != NULL )
+    {
+        fclose( lines );
+        remove( linesName.c_str() );
+        lines = NULL;
+    }
+}
+
+bool OPT_INDEX_READER::Open( const char *indexName )
+{
+    file = fopen( indexName, "rb" );
+
+    if( file == NULL )
+    {
+        return false;
+    }
+
+    fseeko( file, 0, SEEK_END );
+    remaining = ftello( file ) / sizeof(UINT32);
+    fseeko( file, 0, SEEK_SET );
+
+    bufPos = 0;
+    bufLen = 0;
+
+    return true;
+}
+
+void OPT_INDEX_READER::Refill()
+{
+    UINT32 n = (remaining > OPT_INDEX_BLOCK) ? OPT_INDEX_BLOCK : (UINT32) remaining;
+
+    bufPos     = 0;
+    bufLen     = fread( buf, sizeof(UINT32), n, file );
+    remaining -= bufLen;
+}
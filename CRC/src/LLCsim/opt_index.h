@@ -0,0 +1,107 @@
+#ifndef OPT_INDEX_H
+#define OPT_INDEX_H
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Next-use index of an LLC reference stream for the Belady OPT policy.       //
+//                                                                            //
+// A pre-scan records the line address of every LLC reference. A backward     //
+// pass over the recorded lines then writes, for reference i, the distance    //
+// to the next reference to the same line (0 if there is none) as one         //
+// 32-bit word per reference; distances beyond 2^32-1 references saturate.    //
+// The backward pass streams the recorded lines from the end in blocks and    //
+// writes each block of distances at its place in the index, so the index     //
+// is read forwards while the cache is simulated and neither pass holds       //
+// more than a block and a map of the distinct lines in memory.               //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#include <cstdio>
+#include <cassert>
+#include "utils.h"
+
+#define OPT_INDEX_BLOCK     (1 << 16)
+#define OPT_NEVER           (~0ULL)
+
+// Records the reference stream and builds the index from it
+class OPT_INDEX_WRITER
+{
+  private:
+
+    string      indexName;
+    string      linesName;
+    FILE       *lines;
+    COUNTER     references;
+
+    Addr_t      buf[ OPT_INDEX_BLOCK ];
+    UINT32      bufLen;
+
+  public:
+
+    OPT_INDEX_WRITER() : lines( NULL ), references( 0 ), bufLen( 0 ) {}
+
+    bool        Open( const char *_indexName );
+    inline void Add( Addr_t line );
+    bool        Finish();
+
+    // Drops the recorded references without writing the index
+    void        Abort();
+
+    COUNTER     References() { return references; }
+
+  private:
+
+    bool        Flush();
+};
+
+// Streams the next-use distances of an index in reference order
+class OPT_INDEX_READER
+{
+  private:
+
+    FILE       *file;
+    COUNTER     remaining;    // distances left in the file
+
+    UINT32      buf[ OPT_INDEX_BLOCK ];
+    UINT32      bufPos;
+    UINT32      bufLen;
+
+  public:
+
+    OPT_INDEX_READER() : file( NULL ), remaining( 0 ), bufPos( 0 ), bufLen( 0 ) {}
+
+    bool        Open( const char *indexName );
+    inline UINT32 Next();
+
+  private:
+
+    void        Refill();
+};
+
+inline void OPT_INDEX_WRITER::Add( Addr_t line )
+{
+    buf[ bufLen++ ] = line;
+    references++;
+
+    if( bufLen == OPT_INDEX_BLOCK )
+    {
+        Flush();
+    }
+}
+
+// Distance to the next reference to the same line, 0 for none
+inline UINT32 OPT_INDEX_READER::Next()
+{
+    if( bufPos == bufLen )
+    {
+        Refill();
+    }
+
+    // The cache must not see more references than the pre-scan did
+    assert( bufPos < bufLen );
+
+    return buf[ bufPos++ ];
+}
+
+#endif
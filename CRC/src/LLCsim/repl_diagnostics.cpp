@@ -0,0 +1,358 @@
+#include <iomanip>
+#include <sstream>
+#include "repl_diagnostics.h"
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Replacement policy diagnostics (see repl_diagnostics.h).                   //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+static const char *diag_hit_labels[ DIAG_HIT_BUCKETS ] =
+{
+    "0", "1", "2", "3", "4-7", "8-15", "16-31", "32+"
+};
+
+REPL_DIAGNOSTICS::REPL_DIAGNOSTICS( UINT32 _sets, UINT32 _assoc )
+{
+    numsets = _sets;
+    assoc   = _assoc;
+
+    lines       = (LINE_DIAG *) CRC_AlignedCalloc( numsets * assoc, sizeof(LINE_DIAG) );
+    setTime     = (UINT32 *) CRC_AlignedCalloc( numsets, sizeof(UINT32) );
+    hitPosition = (COUNTER *) CRC_AlignedCalloc( assoc, sizeof(COUNTER) );
+
+    assert( lines && setTime && hitPosition );
+
+    numPCs      = 0;
+    pcCapacity  = 0;
+    mapCapacity = 0;
+    pcs         = NULL;
+    pcMap       = NULL;
+
+    GrowPCs();
+
+    fills = evictions = deadEvictions = bypasses = demandHits = 0;
+
+    memset( hitsPerFill, 0, sizeof(hitsPerFill) );
+    memset( fillAge, 0, sizeof(fillAge) );
+    memset( idleAge, 0, sizeof(idleAge) );
+
+    mergedResident = mergedResidentDead = 0;
+
+    duel       = false;
+    flips      = 0;
+    lastPsel   = 0;
+    lastWinner = 0;
+    samples    = 0;
+    interval   = 1024;
+}
+
+// Map slot holding PC, or the empty slot where it belongs
+UINT32 REPL_DIAGNOSTICS::PCMapSlot( Addr_t PC )
+{
+    UINT32 mask = mapCapacity - 1;
+    UINT32 slot = CRC_Mix64( PC ) & mask;
+
+    while( pcMap[ slot ] && pcs[ pcMap[ slot ] - 1 ].PC != PC )
+    {
+        slot = (slot + 1) & mask;
+    }
+
+    return slot;
+}
+
+// Doubles the PC table and rebuilds the map; the indices do not change
+void REPL_DIAGNOSTICS::GrowPCs()
+{
+    pcCapacity  = pcCapacity ? 2 * pcCapacity : 1024;
+    mapCapacity = 2 * pcCapacity;
+
+    pcs = (PC_DIAG *) realloc( pcs, pcCapacity * sizeof(PC_DIAG) );
+
+    free( pcMap );
+    pcMap = (UINT32 *) calloc( mapCapacity, sizeof(UINT32) );
+
+    assert( pcs && pcMap );
+
+    for(UINT32 i=0; i<numPCs; i++)
+    {
+        pcMap[ PCMapSlot( pcs[i].PC ) ] = i + 1;
+    }
+}
+
+// Index of a fill PC, added on its first fill
+UINT32 REPL_DIAGNOSTICS::PCIndex( Addr_t PC )
+{
+    UINT32 slot = PCMapSlot( PC );
+
+    if( pcMap[ slot ] )
+    {
+        return pcMap[ slot ] - 1;
+    }
+
+    if( numPCs == pcCapacity )
+    {
+        GrowPCs();
+        slot = PCMapSlot( PC );
+    }
+
+    PC_DIAG *pc = &pcs[ numPCs ];
+
+    pc->PC        = PC;
+    pc->fills     = 0;
+    pc->deadFills = 0;
+    pc->hits      = 0;
+    pc->bypasses  = 0;
+
+    pcMap[ slot ] = ++numPCs;
+
+    return numPCs - 1;
+}
+
+void REPL_DIAGNOSTICS::Evict( LINE_DIAG *line, UINT32 now )
+{
+    evictions++;
+    hitsPerFill[ HitBucket( line->hits ) ]++;
+    fillAge[ AgeBucket( now - line->fillTime ) ]++;
+    idleAge[ AgeBucket( now - line->lastUse ) ]++;
+
+    if( line->hits == 0 )
+    {
+        deadEvictions++;
+        pcs[ line->pc ].deadFills++;
+    }
+}
+
+void REPL_DIAGNOSTICS::Resident( COUNTER *resident, COUNTER *dead ) const
+{
+    *resident = mergedResident;
+    *dead     = mergedResidentDead;
+
+    for(UINT32 i=0; i<numsets * assoc; i++)
+    {
+        *resident += lines[i].valid;
+        *dead     += lines[i].valid && lines[i].hits == 0;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// The set-dueling scoreboard. Scoreboard() is called whenever PSEL may have  //
+// changed, with the number of accesses so far; PSEL held its last value      //
+// until then, which is what the samples due up to now record.                //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+void REPL_DIAGNOSTICS::StartScoreboard( UINT32 psel, UINT32 winner )
+{
+    duel       = true;
+    lastPsel   = psel;
+    lastWinner = winner;
+}
+
+void REPL_DIAGNOSTICS::Scoreboard( UINT32 psel, UINT32 winner, COUNTER now )
+{
+    if( !duel ) return;
+
+    // Sample i is taken after (i+1) * interval accesses
+    while( (samples + 1) * interval <= now )
+    {
+        if( samples == DIAG_TRAJECTORY )
+        {
+            // Keep the samples at multiples of twice the interval
+            for(UINT32 i=0; i<DIAG_TRAJECTORY / 2; i++)
+            {
+                trajectory[i] = trajectory[ 2 * i + 1 ];
+            }
+
+            samples   = DIAG_TRAJECTORY / 2;
+            interval *= 2;
+            continue;
+        }
+
+        trajectory[ samples++ ] = lastPsel;
+    }
+
+    flips     += (winner != lastWinner);
+    lastPsel   = psel;
+    lastWinner = winner;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Adds the counters of another copy of the cache. The copies run disjoint    //
+// sets, so the lines still resident in the other copy are counted here.      //
+// The scoreboard is only kept by the first copy.                             //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+void REPL_DIAGNOSTICS::Merge( const REPL_DIAGNOSTICS *other )
+{
+    assert( other->assoc == assoc );
+
+    fills         += other->fills;
+    evictions     += other->evictions;
+    deadEvictions += other->deadEvictions;
+    bypasses      += other->bypasses;
+    demandHits    += other->demandHits;
+
+    for(UINT32 b=0; b<DIAG_HIT_BUCKETS; b++) hitsPerFill[b] += other->hitsPerFill[b];
+
+    for(UINT32 b=0; b<DIAG_AGE_BUCKETS; b++)
+    {
+        fillAge[b] += other->fillAge[b];
+        idleAge[b] += other->idleAge[b];
+    }
+
+    for(UINT32 p=0; p<assoc; p++) hitPosition[p] += other->hitPosition[p];
+
+    for(UINT32 i=0; i<other->numPCs; i++)
+    {
+        const PC_DIAG *from = &other->pcs[i];
+        UINT32         pc   = PCIndex( from->PC );  // may move pcs
+        PC_DIAG       *to   = &pcs[ pc ];
+
+        to->fills     += from->fills;
+        to->deadFills += from->deadFills;
+        to->hits      += from->hits;
+        to->bypasses  += from->bypasses;
+    }
+
+    COUNTER resident, dead;
+
+    other->Resident( &resident, &dead );
+
+    mergedResident     += resident;
+    mergedResidentDead += dead;
+}
+
+// count and its share of total, e.g. "      1234  12.34%"
+static void PrintShare( ostream &out, COUNTER count, COUNTER total )
+{
+    out<<setw(12)<<count<<setw(8)<<(total ? (double) count / (double) total * 100.0 : 0.0)<<"%";
+}
+
+ostream & REPL_DIAGNOSTICS::Print( ostream &out, const char *side0, const char *side1 )
+{
+    ios::fmtflags flags     = out.flags();
+    streamsize    precision = out.precision();
+
+    COUNTER resident, residentDead;
+
+    Resident( &resident, &residentDead );
+
+    out<<fixed<<setprecision(2);
+    out<<"\tDiagnostics:"<<endl;
+    out<<"\tFills:            "<<fills<<" ("<<evictions<<" evicted, "<<resident<<" resident)"<<endl;
+    out<<"\tDead on Arrival:  "<<deadEvictions<<" of the evicted fills ("
+       <<(evictions ? (double) deadEvictions / (double) evictions * 100.0 : 0.0)<<"%), "
+       <<residentDead<<" of the resident ones not hit yet"<<endl;
+    out<<"\tDemand Hits:      "<<demandHits<<endl;
+    out<<"\tBypasses:         "<<bypasses<<endl;
+
+    out<<"\tHits per Evicted Fill:"<<endl;
+
+    for(UINT32 b=0; b<DIAG_HIT_BUCKETS; b++)
+    {
+        out<<"\t  "<<left<<setw(8)<<diag_hit_labels[b]<<right;
+        PrintShare( out, hitsPerFill[b], evictions );
+        out<<endl;
+    }
+
+    // Only the range of ages that occurred
+    UINT32 first = DIAG_AGE_BUCKETS, last = 0;
+
+    for(UINT32 b=0; b<DIAG_AGE_BUCKETS; b++)
+    {
+        if( fillAge[b] == 0 && idleAge[b] == 0 ) continue;
+
+        if( first == DIAG_AGE_BUCKETS ) first = b;
+        last = b;
+    }
+
+    out<<"\tEviction Age (set accesses)    since fill       since last use"<<endl;
+
+    for(UINT32 b=first; b<=last && first<DIAG_AGE_BUCKETS; b++)
+    {
+        ostringstream range;
+
+        if( b == 0 ) range<<"0";
+        else         range<<(1ULL << (b - 1))<<"-"<<((1ULL << b) - 1);
+
+        out<<"\t  "<<left<<setw(22)<<range.str()<<right;
+        PrintShare( out, fillAge[b], evictions );
+        PrintShare( out, idleAge[b], evictions );
+        out<<endl;
+    }
+
+    out<<"\tRecency Position at Demand Hit (0 = most recently used):"<<endl;
+
+    COUNTER cumulative = 0;
+
+    for(UINT32 p=0; p<assoc; p++)
+    {
+        cumulative += hitPosition[p];
+
+        out<<"\t  "<<left<<setw(8)<<p<<right;
+        PrintShare( out, hitPosition[p], demandHits );
+        out<<"  cumulative "<<setw(7)<<(demandHits ? (double) cumulative / (double) demandHits * 100.0 : 0.0)<<"%"<<endl;
+    }
+
+    // The PCs with the most dead fills, by repeated selection
+    bool  *shown = new bool[ numPCs ];
+    memset( shown, 0, numPCs * sizeof(bool) );
+
+    out<<"\tTop Dead-Fill PCs (of "<<numPCs<<" filling):"<<endl;
+    out<<"\t  "<<left<<setw(20)<<"PC"<<right<<setw(12)<<"Fills"<<setw(12)<<"Dead"<<setw(9)<<"Dead%"
+       <<setw(12)<<"Hits"<<setw(12)<<"Bypasses"<<endl;
+
+    for(UINT32 n=0; n<DIAG_TOP_PCS; n++)
+    {
+        UINT32 top = numPCs;
+
+        // Ties go to the lower PC, so merged copies print the same list
+        for(UINT32 i=0; i<numPCs; i++)
+        {
+            if( shown[i] || pcs[i].deadFills == 0 ) continue;
+
+            if( top == numPCs || pcs[i].deadFills > pcs[ top ].deadFills
+                || (pcs[i].deadFills == pcs[ top ].deadFills && pcs[i].PC < pcs[ top ].PC) ) 
+            {
+                top = i;
+            }
+        }
+
+        if( top == numPCs ) break;
+
+        shown[ top ] = true;
+
+        ostringstream pc;
+
+        pc<<"0x"<<hex<<pcs[ top ].PC;
+
+        out<<"\t  "<<left<<setw(20)<<pc.str()<<right<<setw(12)<<pcs[ top ].fills<<setw(12)<<pcs[ top ].deadFills
+           <<setw(8)<<(pcs[ top ].fills ? (double) pcs[ top ].deadFills / (double) pcs[ top ].fills * 100.0 : 0.0)<<"%"
+           <<setw(12)<<pcs[ top ].hits<<setw(12)<<pcs[ top ].bypasses<<endl;
+    }
+
+    delete [] shown;
+
+    if( duel )
+    {
+        out<<"\tPSEL Flips:       "<<flips<<" (now favouring "<<(lastWinner ? side1 : side0)<<")"<<endl;
+        out<<"\tPSEL Trajectory:  every "<<interval<<" accesses";
+
+        for(UINT32 i=0; i<samples; i++)
+        {
+            if( i % 16 == 0 ) out<<endl<<"\t ";
+            out<<" "<<setw(4)<<trajectory[i];
+        }
+
+        out<<endl;
+    }
+
+    out.flags( flags );
+    out.precision( precision );
+
+    return out;
+}
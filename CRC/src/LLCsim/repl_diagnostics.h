@@ -0,0 +1,202 @@
+#ifndef REPL_DIAGNOSTICS_H
+#define REPL_DIAGNOSTICS_H
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Opt-in diagnostics of a replacement policy: why the lines it keeps do or   //
+// do not pay off. Every line carries a few compact counters from its fill    //
+// to its eviction, and at the eviction they are folded into histograms:      //
+//                                                                            //
+//   - demand hits per fill, with the fills that see none (dead on arrival)   //
+//   - eviction age, in accesses to the line's set since the fill and since   //
+//     the last demand use (the time the line sat dead)                       //
+//   - recency position of a line at each demand hit, 0 = most recently used  //
+//   - per fill PC: fills, dead fills, hits and bypasses, with a top list of  //
+//     the PCs that waste the most fills                                      //
+//                                                                            //
+// For the set-dueling policies it also counts the flips of the side PSEL     //
+// favours and keeps PSEL sampled at a fixed interval; when the samples run   //
+// out every other one is dropped and the interval doubles, so the whole run  //
+// is always covered.                                                         //
+//                                                                            //
+// The counters are kept by CACHE_REPLACEMENT_STATE and printed with its      //
+// statistics; CRC_CACHE only feeds them on an access path of its own, so a   //
+// cache without diagnostics does not pay for them. Every set counts its own  //
+// accesses, so the ages do not depend on how the sets are split over         //
+// worker threads, or on which sets are sampled.                              //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#include <cassert>
+#include "utils.h"
+
+#define DIAG_HIT_BUCKETS    8       // hits per fill: 0, 1, 2, 3, 4+, 8+, 16+, 32+
+#define DIAG_AGE_BUCKETS    33      // 0, then [2^(b-1), 2^b) accesses
+#define DIAG_TOP_PCS        10
+#define DIAG_TRAJECTORY     64      // PSEL samples kept
+
+// Per-line counters, from the fill to the eviction
+typedef struct
+{
+    UINT32         fillTime;    // accesses to the set before the fill
+    UINT32         lastUse;     // ... before the fill or the last demand hit
+    UINT32         pc;          // index of the fill PC
+    unsigned char  hits;        // demand hits, saturating
+    unsigned char  valid;
+} LINE_DIAG;
+
+// What the fills of one PC came to
+typedef struct
+{
+    Addr_t  PC;
+    COUNTER fills;
+    COUNTER deadFills;
+    COUNTER hits;
+    COUNTER bypasses;
+} PC_DIAG;
+
+class REPL_DIAGNOSTICS
+{
+  private:
+
+    UINT32      numsets;
+    UINT32      assoc;
+    LINE_DIAG  *lines;      // set-major, numsets x assoc
+    UINT32     *setTime;    // accesses per set, wrapping
+
+    COUNTER     fills;
+    COUNTER     evictions;
+    COUNTER     deadEvictions;
+    COUNTER     bypasses;
+    COUNTER     demandHits;
+    COUNTER     hitsPerFill[ DIAG_HIT_BUCKETS ];
+    COUNTER     fillAge[ DIAG_AGE_BUCKETS ];
+    COUNTER     idleAge[ DIAG_AGE_BUCKETS ];
+    COUNTER    *hitPosition;    // demand hits per recency position
+
+    // Fill PCs in order of their first fill, found through a map from PC
+    // to index + 1 (0 = empty slot) by open addressing, at most half full
+    PC_DIAG    *pcs;
+    UINT32      numPCs;
+    UINT32      pcCapacity;
+    UINT32     *pcMap;
+    UINT32      mapCapacity;
+
+    // Lines still in the caches merged into this one
+    COUNTER     mergedResident;
+    COUNTER     mergedResidentDead;
+
+    // Set dueling scoreboard
+    bool        duel;
+    COUNTER     flips;
+    UINT32      lastPsel;
+    UINT32      lastWinner;
+    UINT32      trajectory[ DIAG_TRAJECTORY ];
+    UINT32      samples;
+    COUNTER     interval;   // accesses between samples
+
+  public:
+
+    REPL_DIAGNOSTICS( UINT32 _sets, UINT32 _assoc );
+
+    inline void Fill( UINT32 setIndex, INT32 way, Addr_t PC );
+    inline void Hit( UINT32 setIndex, INT32 way, bool demand );
+    inline void Bypass( UINT32 setIndex, Addr_t PC );
+
+    void        StartScoreboard( UINT32 psel, UINT32 winner );
+    void        Scoreboard( UINT32 psel, UINT32 winner, COUNTER now );
+
+    void        Merge( const REPL_DIAGNOSTICS *other );
+    ostream &   Print( ostream &out, const char *side0, const char *side1 );
+
+  private:
+
+    UINT32      PCIndex( Addr_t PC );
+    UINT32      PCMapSlot( Addr_t PC );
+    void        GrowPCs();
+    void        Evict( LINE_DIAG *line, UINT32 now );
+    void        Resident( COUNTER *resident, COUNTER *dead ) const;
+
+    static UINT32 AgeBucket( UINT32 age ) { return age ? CRC_FloorLog2( age ) + 1 : 0; }
+
+    static UINT32 HitBucket( UINT32 hits )
+    {
+        UINT32 bucket = (hits < 4) ? hits : CRC_FloorLog2( hits ) + 2;
+
+        return (bucket < DIAG_HIT_BUCKETS) ? bucket : DIAG_HIT_BUCKETS - 1;
+    }
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// A line is filled into a way, evicting the way's previous line if any.      //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+inline void REPL_DIAGNOSTICS::Fill( UINT32 setIndex, INT32 way, Addr_t PC )
+{
+    LINE_DIAG *line = &lines[ setIndex * assoc + way ];
+    UINT32     now  = setTime[ setIndex ]++;
+
+    if( line->valid )
+    {
+        Evict( line, now );
+    }
+
+    UINT32 pc = PCIndex( PC );
+
+    pcs[ pc ].fills++;
+    fills++;
+
+    line->fillTime = now;
+    line->lastUse  = now;
+    line->pc       = pc;
+    line->hits     = 0;
+    line->valid    = 1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// A hit. Writeback hits only count as accesses to the set; for a demand      //
+// hit the recency position is the number of lines of the set used (filled    //
+// or hit on demand) since this one was.                                      //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+inline void REPL_DIAGNOSTICS::Hit( UINT32 setIndex, INT32 way, bool demand )
+{
+    UINT32 now = setTime[ setIndex ]++;
+
+    if( !demand ) return;
+
+    LINE_DIAG *set  = &lines[ setIndex * assoc ];
+    LINE_DIAG *line = &set[ way ];
+    UINT32     pos  = 0;
+
+    for(UINT32 w=0; w<assoc; w++)
+    {
+        pos += set[w].valid && (INT32) (set[w].lastUse - line->lastUse) > 0;
+    }
+
+    hitPosition[ pos ]++;
+    pcs[ line->pc ].hits++;
+    demandHits++;
+
+    line->lastUse = now;
+
+    if( line->hits < 0xff )
+    {
+        line->hits++;
+    }
+}
+
+// A miss that the policy did not fill
+inline void REPL_DIAGNOSTICS::Bypass( UINT32 setIndex, Addr_t PC )
+{
+    setTime[ setIndex ]++;
+    UINT32 pc = PCIndex( PC );
+
+    pcs[ pc ].bypasses++;
+    bypasses++;
+}
+
+#endif
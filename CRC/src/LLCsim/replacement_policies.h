@@ -0,0 +1,715 @@
+#ifndef REPL_POLICIES_H
+#define REPL_POLICIES_H
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// The per-access half of CACHE_REPLACEMENT_STATE, one type per policy.       //
+//                                                                            //
+// REPL_POLICY<P> maps the two hooks the cache calls on every access, the     //
+// victim search on a miss and the state update after a hit or fill, to the   //
+// functions of policy P, and says whether P also sees writeback hits and     //
+// whether it monitors the tag of every access (MonitorAccess).               //
+// CRC_CACHE instantiates its access path for each P and picks one when it    //
+// is constructed, so the hot path runs a single, inlined policy instead of   //
+// testing replPolicy on every call. The helpers are defined here, inline,    //
+// for the same reason; GetVictimInSet and UpdateReplacementState still       //
+// dispatch on replPolicy at run time for other callers.                      //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#include "replacement_state.h"
+
+template <> struct REPL_POLICY<CRC_REPL_LRU>
+{
+    static const bool updateOnWritebackHit = false;
+    static const bool monitorsAccesses     = false;
+
+    static INT32 Victim( CACHE_REPLACEMENT_STATE *s, UINT32 tid, UINT32 setIndex, Addr_t PC, UINT32 accessType )
+    {
+        return s->Get_LRU_Victim( setIndex );
+    }
+
+    static void  Update( CACHE_REPLACEMENT_STATE *s, UINT32 setIndex, INT32 updateWayID, UINT32 tid, Addr_t PC, 
+                         UINT32 accessType, bool cacheHit )
+    {
+        s->UpdateLRU( setIndex, updateWayID );
+    }
+};
+
+template <> struct REPL_POLICY<CRC_REPL_RANDOM>
+{
+    static const bool updateOnWritebackHit = false;
+    static const bool monitorsAccesses     = false;
+
+    static INT32 Victim( CACHE_REPLACEMENT_STATE *s, UINT32 tid, UINT32 setIndex, Addr_t PC, UINT32 accessType )
+    {
+        return s->Get_Random_Victim( setIndex );
+    }
+
+    // Random replacement requires no replacement state update
+    static void  Update( CACHE_REPLACEMENT_STATE *s, UINT32 setIndex, INT32 updateWayID, UINT32 tid, Addr_t PC, 
+                         UINT32 accessType, bool cacheHit ) {}
+};
+
+template <> struct REPL_POLICY<CRC_REPL_CONTESTANT>
+{
+    static const bool updateOnWritebackHit = false;
+    static const bool monitorsAccesses     = false;
+
+    static INT32 Victim( CACHE_REPLACEMENT_STATE *s, UINT32 tid, UINT32 setIndex, Addr_t PC, UINT32 accessType )
+    {
+        return s->Get_SWITCH_Victim( setIndex );
+    }
+
+    static void  Update( CACHE_REPLACEMENT_STATE *s, UINT32 setIndex, INT32 updateWayID, UINT32 tid, Addr_t PC, 
+                         UINT32 accessType, bool cacheHit )
+    {
+        s->UpdateSWITCH( setIndex, updateWayID, cacheHit );
+    }
+};
+
+// OPT must see every reference, writeback hits included, to keep the next
+// use of the line current
+template <bool BYPASS> struct REPL_OPT_POLICY
+{
+    static const bool updateOnWritebackHit = true;
+    static const bool monitorsAccesses     = false;
+
+    static INT32 Victim( CACHE_REPLACEMENT_STATE *s, UINT32 tid, UINT32 setIndex, Addr_t PC, UINT32 accessType )
+    {
+        return s->Get_OPT_Victim( setIndex, BYPASS );
+    }
+
+    static void  Update( CACHE_REPLACEMENT_STATE *s, UINT32 setIndex, INT32 updateWayID, UINT32 tid, Addr_t PC, 
+                         UINT32 accessType, bool cacheHit )
+    {
+        s->UpdateOPT( setIndex, updateWayID );
+    }
+};
+
+template <> struct REPL_POLICY<CRC_REPL_OPT> : REPL_OPT_POLICY<false> {};
+template <> struct REPL_POLICY<CRC_REPL_OPT_BYPASS> : REPL_OPT_POLICY<true> {};
+
+// SRRIP, BRRIP and DRRIP differ only in how a fill is inserted
+template <UINT32 P> struct REPL_RRIP_POLICY
+{
+    static const bool updateOnWritebackHit = false;
+    static const bool monitorsAccesses     = false;
+
+    static INT32 Victim( CACHE_REPLACEMENT_STATE *s, UINT32 tid, UINT32 setIndex, Addr_t PC, UINT32 accessType )
+    {
+        return s->Get_RRIP_Victim( setIndex );
+    }
+
+    static void  Update( CACHE_REPLACEMENT_STATE *s, UINT32 setIndex, INT32 updateWayID, UINT32 tid, Addr_t PC, 
+                         UINT32 accessType, bool cacheHit )
+    {
+        s->UpdateRRIP( setIndex, updateWayID, cacheHit, P );
+    }
+};
+
+template <> struct REPL_POLICY<CRC_REPL_SRRIP> : REPL_RRIP_POLICY<CRC_REPL_SRRIP> {};
+template <> struct REPL_POLICY<CRC_REPL_BRRIP> : REPL_RRIP_POLICY<CRC_REPL_BRRIP> {};
+template <> struct REPL_POLICY<CRC_REPL_DRRIP> : REPL_RRIP_POLICY<CRC_REPL_DRRIP> {};
+
+template <bool BYPASS> struct REPL_SHIP_POLICY
+{
+    static const bool updateOnWritebackHit = false;
+    static const bool monitorsAccesses     = false;
+
+    static INT32 Victim( CACHE_REPLACEMENT_STATE *s, UINT32 tid, UINT32 setIndex, Addr_t PC, UINT32 accessType )
+    {
+        return s->Get_SHiP_Victim( tid, setIndex, PC, accessType, BYPASS );
+    }
+
+    static void  Update( CACHE_REPLACEMENT_STATE *s, UINT32 setIndex, INT32 updateWayID, UINT32 tid, Addr_t PC, 
+                         UINT32 accessType, bool cacheHit )
+    {
+        s->UpdateSHiP( setIndex, updateWayID, tid, PC, accessType, cacheHit );
+    }
+};
+
+template <> struct REPL_POLICY<CRC_REPL_SHIP> : REPL_SHIP_POLICY<false> {};
+template <> struct REPL_POLICY<CRC_REPL_SHIP_BYPASS> : REPL_SHIP_POLICY<true> {};
+
+// UCP shadows every access in its utility monitors
+template <> struct REPL_POLICY<CRC_REPL_UCP>
+{
+    static const bool updateOnWritebackHit = false;
+    static const bool monitorsAccesses     = true;
+
+    static INT32 Victim( CACHE_REPLACEMENT_STATE *s, UINT32 tid, UINT32 setIndex, Addr_t PC, UINT32 accessType )
+    {
+        return s->Get_UCP_Victim( tid, setIndex );
+    }
+
+    static void  Update( CACHE_REPLACEMENT_STATE *s, UINT32 setIndex, INT32 updateWayID, UINT32 tid, Addr_t PC, 
+                         UINT32 accessType, bool cacheHit )
+    {
+        s->UpdateUCP( setIndex, updateWayID, tid, cacheHit );
+    }
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+//////// HELPER FUNCTIONS FOR REPLACEMENT UPDATE AND VICTIM SELECTION //////////
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// This function finds the LRU victim in the cache set by returning the       //
+// cache block at the bottom of the LRU stack. Top of LRU stack is '0'        //
+// while bottom of LRU stack is 'assoc-1'                                     //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+inline INT32 CACHE_REPLACEMENT_STATE::Get_LRU_Victim( UINT32 setIndex )
+{
+    if( packedLRU ) 
+    {
+        // Find the way at the bottom of the packed stack in one pass
+        return CRC_PackedLRU_Find( lruStack[ setIndex ], assoc-1 );
+    }
+
+    // Get pointer to replacement state of current set
+    LINE_REPLACEMENT_STATE *replSet = GetReplSet( setIndex );
+
+    INT32   lruWay   = 0;
+
+    // Search for victim whose stack position is assoc-1
+    for(UINT32 way=0; way<assoc; way++) 
+    {
+        if( replSet[way].LRUage == (assoc-1) ) 
+        {
+            lruWay = way;
+            break;
+        }
+    }
+
+    // return lru way
+    return lruWay;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// this function implements the victim finding algorithm for LRU              //
+// Though most part of the function is the same as LRU, I duplicate           //
+// the function here to separate out my LRU victim function and original      //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+inline void CACHE_REPLACEMENT_STATE::Get_MyLRU_Victim(UINT32 setIndex,INT32 &line)
+{
+    if( packedLRU ){
+        line = CRC_PackedLRU_Find( lruStack[ setIndex ], assoc-1 );
+        return;
+    }
+
+    // Get pointer to replacement state of current set
+    LINE_REPLACEMENT_STATE *replSet = GetReplSet( setIndex );
+
+    for(UINT32 lineIndx=0; lineIndx<assoc; lineIndx++) 
+    {
+        if( replSet[lineIndx].cacheLineAge == (assoc-1) ) 
+        {
+            line = lineIndx;
+            break;
+        }
+    }
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// this function implements the victim finding algorithm for CLOCK            //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+inline void CACHE_REPLACEMENT_STATE::Get_MyCLOCK_Victim(UINT32 setIndex,INT32 &line)
+{
+    UINT32 start = hand[ setIndex ];
+
+    //rotate the used bits so that the line the hand points to is bit 0,
+    //the first unused line from the hand onwards is then the lowest zero bit
+    BITVECTOR rotated = CRC_RotateWaysRight( usedMask[ setIndex ], start, assoc );
+    UINT32    skipped = CRC_CountTrailingZeros64( ~rotated & wayMask );
+
+    if(skipped >= assoc){
+        //every line is used: the hand sweeps the whole set, resetting all
+        //flags, and comes back to where it started
+        usedMask[ setIndex ] = 0;
+        line = start;
+        return;
+    }
+
+    //reset the used flags of all lines the hand moved past in one go
+    BITVECTOR sweep = CRC_RotateWaysLeft( CRC_WayMask( skipped ), start, assoc );
+    usedMask[ setIndex ] &= ~sweep;
+
+    //the hand stays on the victim
+    line = start + skipped;
+    if(line >= (INT32) assoc){
+        line -= assoc;
+    }
+    hand[ setIndex ] = line;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// This function finds the Belady OPT victim: the line whose next use is      //
+// furthest in the future. With bypass, the current reference is not          //
+// cached (-1) when its own next use is at least that far away.               //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+inline INT32 CACHE_REPLACEMENT_STATE::Get_OPT_Victim( UINT32 setIndex, bool bypass )
+{
+    // OPT only works with the index of the reference stream
+    assert(nextUseIndex);
+
+    const COUNTER *setNextUse = &nextUse[ setIndex * assoc ];
+    INT32          victim     = 0;
+
+    for(UINT32 way=1; way<assoc; way++) 
+    {
+        if( setNextUse[ way ] > setNextUse[ victim ] ) 
+        {
+            victim = way;
+        }
+    }
+
+    if( bypass && currNextUse >= setNextUse[ victim ] ) 
+    {
+        return -1;
+    }
+
+    return victim;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// This function records the next use of the line just referenced for OPT.    //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+inline void CACHE_REPLACEMENT_STATE::UpdateOPT( UINT32 setIndex, INT32 updateWayID )
+{
+    nextUse[ setIndex * assoc + updateWayID ] = currNextUse;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// This function finds a random victim in the cache set                       //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+inline INT32 CACHE_REPLACEMENT_STATE::Get_Random_Victim( UINT32 setIndex )
+{
+    INT32 way = (Rand( setIndex ) % assoc);
+    
+    return way;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// This function finds the SWITCH victim: a leader set uses its own           //
+// policy, a follower set the policy PSEL currently favours                   //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+inline INT32 CACHE_REPLACEMENT_STATE::Get_SWITCH_Victim( UINT32 setIndex )
+{
+    INT32   line=0;//line is passed by reference in the functions below
+    INT32   policy = DuelLeader(setIndex);
+
+    if(policy < 0){
+        //follower set: take the side whose leaders miss less, LRU leaders
+        //push PSEL up
+        policy = DuelWinner();
+        followerVictims[ policy ]++;
+    }
+
+    if(policy == LRU){
+        Get_MyLRU_Victim(setIndex,line);
+    }else{// Famous CLOCK policy
+        Get_MyCLOCK_Victim(setIndex,line);
+    }
+
+    // return victim line
+    return line;
+}
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// This function implements the LRU update routine for the traditional        //
+// LRU replacement policy. The arguments to the function are the physical     //
+// way and set index.                                                         //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+inline void CACHE_REPLACEMENT_STATE::UpdateLRU( UINT32 setIndex, INT32 updateWayID )
+{
+    if( packedLRU ) 
+    {
+        // Age all lines above the current one and make it MRU, branch-free
+        lruStack[ setIndex ] = CRC_PackedLRU_Promote( lruStack[ setIndex ], updateWayID );
+        return;
+    }
+
+    LINE_REPLACEMENT_STATE *replSet = GetReplSet( setIndex );
+
+    // Determine current LRU stack position
+    UINT32 currLRUage = replSet[ updateWayID ].LRUage;
+
+    // Update the stack position of all lines before the current line
+    // Update implies incremeting their stack positions by one
+    for(UINT32 way=0; way<assoc; way++) 
+    {
+        if( replSet[way].LRUage < currLRUage ) 
+        {
+            replSet[way].LRUage++;
+        }
+    }
+
+    // Set the LRU stack position of new line to be zero
+    replSet[ updateWayID ].LRUage = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// This function updates the LRU stack and the CLOCK used bits of the set,    //
+// and on a miss in a leader set moves PSEL towards the other policy. The     //
+// arguments to the function are the physical way and set index.             //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+inline void CACHE_REPLACEMENT_STATE::UpdateSWITCH( UINT32 setIndex, INT32 updateWayID, bool cacheHit )
+{
+    if(cacheHit){ 
+        usedMask[ setIndex ] |= 1ULL << updateWayID;
+    }else{
+        DuelMiss(setIndex);
+    }
+
+    if(packedLRU){
+        //packed stack: promote to MRU without walking the set
+        lruStack[ setIndex ] = CRC_PackedLRU_Promote( lruStack[ setIndex ], updateWayID );
+    }else{
+        LINE_REPLACEMENT_STATE *replSet = GetReplSet( setIndex );
+
+        // Determine current MRU stack position
+        UINT32 currcacheLineAge = replSet[ updateWayID ].cacheLineAge;
+
+        // Update the stack position of all lines before the current line
+        // Update implies incremeting their stack positions by one
+        for(UINT32 lineIndx=0; lineIndx<assoc; lineIndx++) 
+        {
+            if( replSet[lineIndx].cacheLineAge < currcacheLineAge ) 
+            {
+                replSet[lineIndx].cacheLineAge++;
+            }
+        }
+
+        // Set the MRU stack position of new line to be zero
+        replSet[ updateWayID ].cacheLineAge = 0;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// This function counts a miss in a leader set: misses of the first policy    //
+// of the duel (LRU, SRRIP) move PSEL up, misses of the second one (CLOCK,    //
+// BRRIP) move it down. Misses in follower sets do not count.                 //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+inline void CACHE_REPLACEMENT_STATE::DuelMiss( UINT32 setIndex )
+{
+    INT32 leader = DuelLeader(setIndex);
+
+    if(leader < 0) return;
+
+    leaderMisses[ leader ]++;
+
+    if(epochMode){
+        pselDelta += (leader == 0) ? 1 : -1;
+    }else if(leader == 0){
+        if(psel < PSEL_MAX) psel++;
+    }else{
+        if(psel > 0) psel--;
+    }
+
+    if(diag && !epochMode){
+        diag->Scoreboard( psel, DuelWinner(), mytimer );
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// This function finds the RRIP victim: the lowest way predicted to be       //
+// re-referenced furthest in the future (RRPV 3). If no way is at RRPV 3,     //
+// every way of the set is aged until one is, which is done in one step by    //
+// adding the distance from the highest RRPV present to 3 to all ways.        //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+inline INT32 CACHE_REPLACEMENT_STATE::Get_RRIP_Victim( UINT32 setIndex )
+{
+    BITVECTOR hi = rrpvHi[ setIndex ];
+    BITVECTOR lo = rrpvLo[ setIndex ];
+
+    // Ways at the highest RRPV present, and how far that is below 3
+    BITVECTOR top = hi & lo;
+    UINT32    age = 0;
+
+    if( !top ) 
+    {
+        top = hi;
+        age = 1;
+    }
+
+    if( !top ) 
+    {
+        top = lo;
+        age = 2;
+    }
+
+    if( !top ) 
+    {
+        top = wayMask;
+        age = 3;
+    }
+
+    if( age ) 
+    {
+        // Bit-sliced add of age to every way; no way exceeds 3
+        BITVECTOR addLo = (age & 1) ? wayMask : 0;
+        BITVECTOR addHi = (age & 2) ? wayMask : 0;
+
+        rrpvHi[ setIndex ] = hi ^ addHi ^ (lo & addLo);
+        rrpvLo[ setIndex ] = lo ^ addLo;
+    }
+
+    return CRC_CountTrailingZeros64( top );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// This function implements the RRIP update. A hit promotes the line to       //
+// RRPV 0 (near re-reference). A fill is inserted at RRPV 2 by SRRIP, and     //
+// at RRPV 3 by BRRIP except for 1 in RRIP_BIP_EPSILON fills at RRPV 2, so    //
+// a scan larger than the cache cannot flush the lines that are reused.       //
+// DRRIP leader sets always insert like SRRIP or BRRIP and the follower sets  //
+// like the one whose leaders miss less.                                      //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+inline void CACHE_REPLACEMENT_STATE::UpdateRRIP( UINT32 setIndex, INT32 updateWayID, bool cacheHit, UINT32 policy )
+{
+    if( cacheHit ) 
+    {
+        SetRRPV( setIndex, updateWayID, 0 );
+        rripPromotions++;
+        return;
+    }
+
+    INT32 insertion = (policy == CRC_REPL_BRRIP) ? BRRIP : SRRIP;
+
+    if( policy == CRC_REPL_DRRIP ) 
+    {
+        DuelMiss( setIndex );
+
+        insertion = DuelLeader( setIndex );
+
+        if( insertion < 0 ) 
+        {
+            insertion = DuelWinner();
+            followerVictims[ insertion ]++;
+        }
+    }
+
+    UINT32 rrpv = RRIP_MAX_RRPV - 1;
+
+    if( insertion == BRRIP && (Rand( setIndex ) % RRIP_BIP_EPSILON) != 0 ) 
+    {
+        rrpv = RRIP_MAX_RRPV;
+    }
+
+    SetRRPV( setIndex, updateWayID, rrpv );
+    rripInsertions[ rrpv ]++;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// This function finds the SHiP victim. A fill whose signature counter is 0   //
+// is predicted dead; the bypass variant then returns -1 for all but 1 in     //
+// SHIP_BYPASS_EPSILON of them, and those few keep training the counter so    //
+// a signature can come back. Otherwise the RRIP victim is evicted, and if   //
+// it was never hit the signature that filled it counts down.                 //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+inline INT32 CACHE_REPLACEMENT_STATE::Get_SHiP_Victim( UINT32 tid, UINT32 setIndex, Addr_t PC, UINT32 accessType, bool bypass )
+{
+    if( bypass && shct[ ShipSignature( tid, PC, accessType ) ] == 0
+        && (Rand( setIndex ) % SHIP_BYPASS_EPSILON) != 0 ) 
+    {
+        shipBypasses++;
+        return -1;
+    }
+
+    INT32 victim = Get_RRIP_Victim( setIndex );
+
+    if( !((shipReused[ setIndex ] >> victim) & 1) ) 
+    {
+        ShctAdd( shipSig[ setIndex * assoc + victim ], -1 );
+        shipDeadEvictions++;
+    }
+
+    return victim;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// This function implements the SHiP update. A hit promotes the line to      //
+// RRPV 0 and counts up the signature that filled it. A fill records its      //
+// signature and is inserted at RRPV 3 if the signature is predicted dead,    //
+// at RRPV 2 (as SRRIP) otherwise.                                            //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+inline void CACHE_REPLACEMENT_STATE::UpdateSHiP( UINT32 setIndex, INT32 updateWayID, UINT32 tid, Addr_t PC, 
+                                                 UINT32 accessType, bool cacheHit )
+{
+    BITVECTOR bit = 1ULL << updateWayID;
+    UINT16   *sig = &shipSig[ setIndex * assoc + updateWayID ];
+
+    if( cacheHit ) 
+    {
+        SetRRPV( setIndex, updateWayID, 0 );
+        rripPromotions++;
+
+        ShctAdd( *sig, 1 );
+        shipReused[ setIndex ] |= bit;
+        return;
+    }
+
+    *sig = ShipSignature( tid, PC, accessType );
+    shipReused[ setIndex ] &= ~bit;
+
+    UINT32 rrpv = (shct[ *sig ] == 0) ? RRIP_MAX_RRPV : RRIP_MAX_RRPV - 1;
+
+    SetRRPV( setIndex, updateWayID, rrpv );
+    rripInsertions[ rrpv ]++;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// This function feeds the UCP utility monitor of the accessing thread. In a  //
+// monitored set the tag is looked up in the thread's own LRU stack; a hit    //
+// counts at its stack position, and the tag moves to the top either way.     //
+// Writebacks and prefetches are not demand accesses and are left out.        //
+// Outside epoch mode it also runs the allocation every UCP_INTERVAL          //
+// accesses.                                                                  //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+inline void CACHE_REPLACEMENT_STATE::MonitorAccess( UINT32 tid, UINT32 setIndex, Addr_t tag, UINT32 accessType )
+{
+    if( !epochMode && mytimer >= ucpNextAlloc ) 
+    {
+        AllocateWays();
+        ucpNextAlloc += UCP_INTERVAL;
+    }
+
+    if( (setIndex & ((1U << umonShift) - 1)) || accessType > ACCESS_STORE ) return;
+
+    assert( tid < ucpThreads );
+
+    Addr_t *stack = &umonTags[ (tid * umonSets + (setIndex >> umonShift)) * assoc ];
+    UINT32  pos   = 0;
+
+    // Stops at the bottom entry on a miss, which then drops out
+    while( pos < assoc - 1 && stack[ pos ] != tag ) pos++;
+
+    if( stack[ pos ] == tag ) 
+    {
+        umonHits[ tid * assoc + pos ]++;
+    }
+
+    memmove( &stack[1], &stack[0], pos * sizeof(Addr_t) );
+    stack[0] = tag;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// This function finds the UCP victim. A thread holding fewer ways of the     //
+// set than its quota takes the LRU line of the threads holding more than     //
+// theirs, or of all other threads if none does; a thread at its quota        //
+// replaces its own LRU line. With a single thread this is LRU.               //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+inline INT32 CACHE_REPLACEMENT_STATE::Get_UCP_Victim( UINT32 tid, UINT32 setIndex )
+{
+    const BITVECTOR *owned = &ucpOwned[ setIndex * ucpThreads ];
+    BITVECTOR        ways  = owned[ tid ];
+
+    assert( tid < ucpThreads );
+
+    if( (UINT32) CRC_PopCount64( owned[ tid ] ) < ucpQuota[ tid ] ) 
+    {
+        BITVECTOR over = 0;
+
+        for(UINT32 t=0; t<ucpThreads; t++) 
+        {
+            if( t != tid && (UINT32) CRC_PopCount64( owned[t] ) > ucpQuota[t] ) 
+            {
+                over |= owned[t];
+            }
+        }
+
+        ways = over ? over : (wayMask & ~owned[ tid ]);
+    }
+
+    return Get_LRU_Victim_Among( setIndex, ways );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// This function finds the way lowest in the LRU stack among the given ways.  //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+inline INT32 CACHE_REPLACEMENT_STATE::Get_LRU_Victim_Among( UINT32 setIndex, BITVECTOR ways )
+{
+    INT32  victim = CRC_CountTrailingZeros64( ways );
+    UINT32 oldest = 0;
+
+    assert( ways );
+
+    for( ; ways; ways &= ways - 1 ) 
+    {
+        UINT32 way = CRC_CountTrailingZeros64( ways );
+        UINT32 age = packedLRU ? CRC_PackedLRU_Position( lruStack[ setIndex ], way ) 
+                               : GetReplSet( setIndex )[ way ].LRUage;
+
+        if( age >= oldest ) 
+        {
+            oldest = age;
+            victim = way;
+        }
+    }
+
+    return victim;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// This function implements the UCP update: LRU, and a fill moves the way to  //
+// the thread that filled it.                                                 //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+inline void CACHE_REPLACEMENT_STATE::UpdateUCP( UINT32 setIndex, INT32 updateWayID, UINT32 tid, bool cacheHit )
+{
+    UpdateLRU( setIndex, updateWayID );
+
+    if( cacheHit ) return;
+
+    BITVECTOR *owned = &ucpOwned[ setIndex * ucpThreads ];
+    BITVECTOR  bit   = 1ULL << updateWayID;
+
+    for(UINT32 t=0; t<ucpThreads; t++) 
+    {
+        owned[t] &= ~bit;
+    }
+
+    owned[ tid ] |= bit;
+}
+
+#endif
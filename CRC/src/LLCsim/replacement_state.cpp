@@ -1,4 +1,4 @@
-#include "replacement_state.h"
+#include "replacement_policies.h"
 
 ////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////
@@ -38,384 +38,628 @@ CACHE_REPLACEMENT_STATE::CACHE_REPLACEMENT_STATE( UINT32 _sets, UINT32 _assoc, U
     replPolicy = _pol;
 
     mytimer    = 0;
+
+    CRC_SeedRand( &randState, 1 );
+
+    nextUseIndex = NULL;
+    currNextUse  = OPT_NEVER;
     
-    prob.access = 0;
-    prob.miss = 0;
-    currPolicy = CLOCK; //default to CLOCK biased 
-    score.lru = LRU_INIT_SCORE;
-    score.clock = CLOCK_INIT_SCORE; //score board is also CLOCK biased
+    //up to DUEL_LEADER_SETS leaders per policy, one of each per region
+    UINT32 leaders = numsets / 8;   //leave most sets of small caches to follow
+    if(leaders > DUEL_LEADER_SETS) leaders = DUEL_LEADER_SETS;
+    if(leaders == 0) leaders = 1;
+    duelShift = CRC_FloorLog2( numsets / leaders );
+
+    //contestant followers start on CLOCK, DRRIP followers on SRRIP
+    psel = (replPolicy == CRC_REPL_DRRIP) ? PSEL_MAX / 2 : (PSEL_MAX + 1) / 2;
+    leaderMisses[ LRU ] = leaderMisses[ CLOCK ] = 0;
+    followerVictims[ LRU ] = followerVictims[ CLOCK ] = 0;
+
+    epochMode = false;
+    pselDelta = 0;
+    shctDelta = NULL;
+    setDraws  = NULL;
+
+    diag = NULL;
+
+    ucpThreads  = 0;
+    umonShift   = 0;
+    umonSets    = 0;
+    umonTags    = NULL;
+    umonHits    = NULL;
+    ucpOwned    = NULL;
+    ucpQuota    = NULL;
+    ucpQuotaSum = NULL;
+    ucpNextAlloc   = UCP_INTERVAL;
+    ucpAllocations = 0;
 
     InitReplacementState();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 //                                                                            //
-// This function initializes the replacement policy hardware by creating      //
-// storage for the replacement state on a per-line/per-cache basis.           //
+// Sets the number of threads sharing the cache. UCP sizes its monitors and   //
+// way masks by it and starts from an even split of the ways. Must be called  //
+// before the first access.                                                   //
 //                                                                            //
 ////////////////////////////////////////////////////////////////////////////////
-void CACHE_REPLACEMENT_STATE::InitReplacementState()
+void CACHE_REPLACEMENT_STATE::SetThreads( UINT32 _threads )
 {
-    // Create the state for sets, then create the state for the ways
-    repl  = new LINE_REPLACEMENT_STATE* [ numsets ];
+    assert( _threads > 0 );
 
-    // ensure that we were able to create replacement state
-    assert(repl);
+    if( replPolicy != CRC_REPL_UCP ) return;
 
-    // Create the state for the sets
-    for(UINT32 setIndex=0; setIndex<numsets; setIndex++) 
-    {
-        repl[ setIndex ]  = new LINE_REPLACEMENT_STATE[ assoc ];
+    ucpThreads = _threads;
 
-        for(UINT32 line=0; line<assoc; line++) 
-        {
-            // initialize stack position (for true LRU)
-            repl[ setIndex ][ line ].LRUage = line;
-        }
+    // UCP_MONITOR_SETS evenly spaced sets, or every set of a smaller cache
+    umonSets  = (numsets < UCP_MONITOR_SETS) ? numsets : UCP_MONITOR_SETS;
+    umonShift = CRC_FloorLog2( numsets / umonSets );
+
+    umonTags    = (Addr_t *) CRC_AlignedCalloc( ucpThreads * umonSets * assoc, sizeof(Addr_t) );
+    umonHits    = (COUNTER *) CRC_AlignedCalloc( ucpThreads * assoc, sizeof(COUNTER) );
+    ucpOwned    = (BITVECTOR *) CRC_AlignedCalloc( numsets * ucpThreads, sizeof(BITVECTOR) );
+    ucpQuota    = new UINT32[ ucpThreads ];
+    ucpQuotaSum = new COUNTER[ ucpThreads ];
+
+    assert( umonTags && umonHits && ucpOwned );
+
+    for(UINT32 i=0; i<ucpThreads * umonSets * assoc; i++) 
+    {
+        umonTags[i] = UCP_NO_TAG;
     }
 
-    //CLOCK+LRU
-    //when we have more than say 30% miss rate, we switch policy 
-    // Contestants:  ADD INITIALIZATION FOR YOUR HARDWARE HERE
-    myRepl = new LINE_REPLACEMENT_STATE* [ numsets ];
-    hand = new UINT8 [numsets];
-    // ensure that we were able to create replacement state
-    assert(myRepl);
-    
-    // Create the state for the sets
-    for(UINT32 setIndex=0; setIndex<numsets; setIndex++) 
+    // With more threads than ways there is nothing to partition
+    for(UINT32 t=0; t<ucpThreads; t++) 
     {
-        myRepl[ setIndex ]  = new LINE_REPLACEMENT_STATE[ assoc ];
-        hand[ setIndex ] = 0; //initially, hand is pointing at first line in each set
-        
-        for(UINT32 lineIndx=0; lineIndx<assoc; lineIndx++) 
-        {
-            //cacheLineAge is for LRU aging
-            myRepl[ setIndex ][ lineIndx ].cacheLineAge = lineIndx;
-            //used flag is for clock
-            myRepl[ setIndex ][ lineIndx ].used = false;
-        }
+        ucpQuota[t]    = (ucpThreads > assoc) ? assoc : assoc / ucpThreads + (t < assoc % ucpThreads);
+        ucpQuotaSum[t] = 0;
     }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 //                                                                            //
-// This function is called by the cache on every cache miss. The input        //
-// arguments are the thread id, set index, pointers to ways in current set    //
-// and the associativity.  We are also providing the PC, physical address,    //
-// and accesstype should you wish to use them at victim selection time.       //
-// The return value is the physical way index for the line being replaced.    //
-// Return -1 if you wish to bypass LLC.                                       //
-//                                                                            //
-// vicSet is the current set. You can access the contents of the set by       //
-// indexing using the wayID which ranges from 0 to assoc-1 e.g. vicSet[0]     //
-// is the first way and vicSet[4] is the 4th physical way of the cache.       //
-// Elements of LINE_STATE are defined in crc_cache_defs.h                     //
+// UCP's lookahead allocation. Every thread starts from one way; while ways   //
+// are left, the thread whose monitor promises the most hits per way for      //
+// some number of additional ways gets that many (the fewest ways on a tie,   //
+// then the lowest thread). The hit counts are then halved so the next        //
+// allocation weighs recent behaviour more.                                   //
 //                                                                            //
 ////////////////////////////////////////////////////////////////////////////////
-INT32 CACHE_REPLACEMENT_STATE::GetVictimInSet( UINT32 tid, UINT32 setIndex, const LINE_STATE *vicSet, UINT32 assoc,
-                                               Addr_t PC, Addr_t paddr, UINT32 accessType )
+void CACHE_REPLACEMENT_STATE::AllocateWays()
 {
-    // If no invalid lines, then replace based on replacement policy
-    if( replPolicy == CRC_REPL_LRU ) 
+    if( ucpThreads > assoc ) return;
+
+    UINT32 balance = assoc - ucpThreads;
+
+    for(UINT32 t=0; t<ucpThreads; t++) 
     {
-        return Get_LRU_Victim( setIndex );
+        ucpQuota[t] = 1;
     }
-    else if( replPolicy == CRC_REPL_RANDOM )
+
+    while( balance ) 
     {
-        return Get_Random_Victim( setIndex );
+        INT32   best      = -1;
+        COUNTER bestHits  = 0;
+        UINT32  bestWays  = 1;
+
+        for(UINT32 t=0; t<ucpThreads; t++) 
+        {
+            const COUNTER *hits = &umonHits[ t * assoc + ucpQuota[t] ];
+            COUNTER        sum  = 0;
+            COUNTER        maxHits = 0;
+            UINT32         maxWays = 1;
+
+            // The most hits per way over k more ways, the smallest such k
+            for(UINT32 k=1; k<=balance; k++) 
+            {
+                sum += hits[ k-1 ];
+
+                if( sum * maxWays > maxHits * k ) 
+                {
+                    maxHits = sum;
+                    maxWays = k;
+                }
+            }
+
+            if( best < 0 || maxHits * bestWays > bestHits * maxWays 
+                || (maxHits * bestWays == bestHits * maxWays && ucpQuota[t] < ucpQuota[ best ]) ) 
+            {
+                best     = t;
+                bestHits = maxHits;
+                bestWays = maxWays;
+            }
+        }
+
+        ucpQuota[ best ] += bestWays;
+        balance          -= bestWays;
     }
-    else if( replPolicy == CRC_REPL_CONTESTANT )
+
+    for(UINT32 i=0; i<ucpThreads * assoc; i++) 
     {
-        // Contestants:  ADD YOUR VICTIM SELECTION FUNCTION HERE
-        return Get_SWITCH_Victim( setIndex );
+        umonHits[i] /= 2;
     }
 
-    // We should never get here
-    assert(0);
+    for(UINT32 t=0; t<ucpThreads; t++) 
+    {
+        ucpQuotaSum[t] += ucpQuota[t];
+    }
 
-    return -1; // Returning -1 bypasses the LLC
+    ucpAllocations++;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 //                                                                            //
-// This function is called by the cache after every cache hit/miss            //
-// The arguments are: the set index, the physical way of the cache,           //
-// the pointer to the physical line (should contestants need access           //
-// to information of the line filled or hit upon), the thread id              //
-// of the request, the PC of the request, the accesstype, and finall          //
-// whether the line was a cachehit or not (cacheHit=true implies hit)         //
+// Starts collecting the reuse and dead-block diagnostics (see                //
+// repl_diagnostics.h). Must be called before the first access.               //
 //                                                                            //
 ////////////////////////////////////////////////////////////////////////////////
-void CACHE_REPLACEMENT_STATE::UpdateReplacementState( 
-    UINT32 setIndex, INT32 updateWayID, const LINE_STATE *currLine, 
-    UINT32 tid, Addr_t PC, UINT32 accessType, bool cacheHit )
+void CACHE_REPLACEMENT_STATE::EnableDiagnostics()
 {
-    // What replacement policy?
-    if( replPolicy == CRC_REPL_LRU ) 
-    {
-        UpdateLRU( setIndex, updateWayID );
-    }
-    else if( replPolicy == CRC_REPL_RANDOM )
+    diag = new REPL_DIAGNOSTICS( numsets, assoc );
+
+    if( DuelPolicy() ) 
     {
-        // Random replacement requires no replacement state update
+        diag->StartScoreboard( psel, DuelWinner() );
     }
-    else if( replPolicy == CRC_REPL_CONTESTANT )
-    {
-        // Contestants:  ADD YOUR UPDATE REPLACEMENT STATE FUNCTION HERE
-        // Feel free to use any of the input parameters to make
-        // updates to your replacement policy
-        UpdateSWITCH( setIndex, updateWayID, cacheHit );
-    }
-    
-    
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 //                                                                            //
-//////// HELPER FUNCTIONS FOR REPLACEMENT UPDATE AND VICTIM SELECTION //////////
+// Switches the state to epoch mode (see replacement_state.h). Must be        //
+// called before the first access.                                            //
 //                                                                            //
 ////////////////////////////////////////////////////////////////////////////////
+void CACHE_REPLACEMENT_STATE::SetEpochMode()
+{
+    epochMode = true;
+    setDraws  = (UINT32 *) CRC_AlignedCalloc( numsets, sizeof(UINT32) );
+    assert(setDraws);
 
+    if( shct ) 
+    {
+        shctDelta = (INT32 *) CRC_AlignedCalloc( 1 << SHIP_SHCT_BITS, sizeof(INT32) );
+        assert(shctDelta);
+    }
+}
 
 ////////////////////////////////////////////////////////////////////////////////
 //                                                                            //
-// This function finds the LRU victim in the cache set by returning the       //
-// cache block at the bottom of the LRU stack. Top of LRU stack is '0'        //
-// while bottom of LRU stack is 'assoc-1'                                     //
+// Ends an epoch for count copies of the same cache in epoch mode: the sum    //
+// of their PSEL and SHiP counter deltas is applied, saturated, to the        //
+// shared values, which every copy then holds. UCP's monitor counts are       //
+// gathered in the first copy, which allocates the ways once the copies       //
+// together have seen UCP_INTERVAL more accesses. The sums do not depend on   //
+// which copy saw which set.                                                  //
 //                                                                            //
 ////////////////////////////////////////////////////////////////////////////////
-INT32 CACHE_REPLACEMENT_STATE::Get_LRU_Victim( UINT32 setIndex )
+void CACHE_REPLACEMENT_STATE::MergeEpoch( CACHE_REPLACEMENT_STATE **states, UINT32 count )
 {
-    // Get pointer to replacement state of current set
-    LINE_REPLACEMENT_STATE *replSet = repl[ setIndex ];
+    INT32 newPsel = states[0]->psel;
 
-    INT32   lruWay   = 0;
+    for(UINT32 c=0; c<count; c++) 
+    {
+        assert(states[c]->epochMode);
+
+        newPsel += states[c]->pselDelta;
+        states[c]->pselDelta = 0;
+    }
+
+    newPsel = (newPsel < 0) ? 0 : (newPsel > PSEL_MAX) ? PSEL_MAX : newPsel;
+
+    for(UINT32 c=0; c<count; c++) 
+    {
+        states[c]->psel = newPsel;
+    }
+
+    // References of all copies so far
+    COUNTER now = 0;
 
-    // Search for victim whose stack position is assoc-1
-    for(UINT32 way=0; way<assoc; way++) 
+    for(UINT32 c=0; c<count; c++) now += states[c]->mytimer;
+
+    // PSEL only moves here
+    if( states[0]->diag && states[0]->DuelPolicy() ) 
+    {
+        states[0]->diag->Scoreboard( newPsel, states[0]->DuelWinner(), now );
+    }
+
+    if( states[0]->umonHits ) 
     {
-        if( replSet[way].LRUage == (assoc-1) ) 
+        CACHE_REPLACEMENT_STATE *first = states[0];
+        UINT32                   slots = first->ucpThreads * first->assoc;
+
+        for(UINT32 c=1; c<count; c++) 
         {
-            lruWay = way;
-            break;
+            for(UINT32 i=0; i<slots; i++) 
+            {
+                first->umonHits[i] += states[c]->umonHits[i];
+                states[c]->umonHits[i] = 0;
+            }
+        }
+
+        if( now >= first->ucpNextAlloc ) 
+        {
+            first->AllocateWays();
+
+            while( first->ucpNextAlloc <= now ) first->ucpNextAlloc += UCP_INTERVAL;
+
+            for(UINT32 c=1; c<count; c++) 
+            {
+                memcpy( states[c]->ucpQuota, first->ucpQuota, first->ucpThreads * sizeof(UINT32) );
+            }
         }
     }
 
-    // return lru way
-    return lruWay;
+    if( states[0]->shct == NULL ) return;
+
+    for(UINT32 sig=0; sig<(1U << SHIP_SHCT_BITS); sig++) 
+    {
+        INT32 counter = states[0]->shct[ sig ];
+
+        for(UINT32 c=0; c<count; c++) 
+        {
+            counter += states[c]->shctDelta[ sig ];
+            states[c]->shctDelta[ sig ] = 0;
+        }
+
+        counter = (counter < 0) ? 0 : (counter > SHIP_COUNTER_MAX) ? SHIP_COUNTER_MAX : counter;
+
+        for(UINT32 c=0; c<count; c++) 
+        {
+            states[c]->shct[ sig ] = counter;
+        }
+    }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 //                                                                            //
-// this function implements the victim finding algorithm for LRU              //
-// Though most part of the function is the same as LRU, I duplicate           //
-// the function here to separate out my LRU victim function and original      //
+// Adds the statistics of another copy of the cache to this one.              //
 //                                                                            //
 ////////////////////////////////////////////////////////////////////////////////
-void CACHE_REPLACEMENT_STATE::Get_MyLRU_Victim(UINT32 setIndex,INT32 &line)
+void CACHE_REPLACEMENT_STATE::MergeStats( const CACHE_REPLACEMENT_STATE *other )
 {
-    // Get pointer to replacement state of current set
-    LINE_REPLACEMENT_STATE *replSet = myRepl[ setIndex ];
+    for(UINT32 i=0; i<2; i++) 
+    {
+        leaderMisses[i]    += other->leaderMisses[i];
+        followerVictims[i] += other->followerVictims[i];
+    }
 
-    for(UINT32 lineIndx=0; lineIndx<assoc; lineIndx++) 
+    for(UINT32 rrpv=0; rrpv<=RRIP_MAX_RRPV; rrpv++) 
     {
-        if( replSet[lineIndx].cacheLineAge == (assoc-1) ) 
-        {
-            line = lineIndx;
-            break;
-        }
+        rripInsertions[ rrpv ] += other->rripInsertions[ rrpv ];
     }
-}
 
+    rripPromotions    += other->rripPromotions;
+    shipBypasses      += other->shipBypasses;
+    shipDeadEvictions += other->shipDeadEvictions;
+
+    if( diag && other->diag ) 
+    {
+        diag->Merge( other->diag );
+    }
+}
 
 ////////////////////////////////////////////////////////////////////////////////
 //                                                                            //
-// this function implements the victim finding algorithm for CLOCK            //
+// The arrays of the common section of a snapshot, or of the policy section   //
+// if policy. Only the state that the policy keeps is in its section.         //
 //                                                                            //
 ////////////////////////////////////////////////////////////////////////////////
-void CACHE_REPLACEMENT_STATE::Get_MyCLOCK_Victim(UINT32 setIndex,INT32 &line)
+UINT32 CACHE_REPLACEMENT_STATE::SnapshotArrays( CRC_SNAPSHOT_ARRAY *arrays, bool policy )
 {
-    
-    LINE_REPLACEMENT_STATE *replSet = myRepl[ setIndex ];
-    
-    for(;;){
-       //if we find an unused cache line, this is the victim
-       if(!(replSet[ hand[ setIndex ] ].used) ){
-           line = hand[ setIndex ];
-           break;
-       }else{
-           //if the current cache line the hand is pointing to is used, we reset
-           //then the hand points to next cache line 
-           replSet[ hand[ setIndex ] ].used = false;
-  
-           hand[ setIndex ]++;//hand pointing to next cacheline unused
-
-           //We have fixed 16-way assoc
-           //so the hand circles back at the last one
-           if(hand[ setIndex ] > 0xf){
-               hand[ setIndex ] = 0;
-           }
-       }
+    UINT32 count = 0;
+
+    if( !policy ) 
+    {
+        CRC_SNAPSHOT_ARRAY common[] = 
+        {
+            { &mytimer,   sizeof(mytimer) },
+            { &randState, sizeof(randState) },
+            { lruStack,   numsets * sizeof(CRC_LRU_STACK) },
+            { usedMask,   numsets * sizeof(BITVECTOR) },
+            { hand,       numsets * sizeof(UINT8) },
+            { repl,       packedLRU ? 0 : numsets * assoc * sizeof(LINE_REPLACEMENT_STATE) }
+        };
+
+        memcpy( arrays, common, sizeof(common) );
+
+        return sizeof(common) / sizeof(common[0]);
     }
+
+    arrays[ count ].data    = &psel;
+    arrays[ count++ ].bytes = sizeof(psel);
+
+    if( rrpvHi ) 
+    {
+        arrays[ count ].data    = rrpvHi;
+        arrays[ count++ ].bytes = numsets * sizeof(BITVECTOR);
+        arrays[ count ].data    = rrpvLo;
+        arrays[ count++ ].bytes = numsets * sizeof(BITVECTOR);
+    }
+
+    if( shct ) 
+    {
+        arrays[ count ].data    = shct;
+        arrays[ count++ ].bytes = (1 << SHIP_SHCT_BITS) * sizeof(UINT8);
+        arrays[ count ].data    = shipSig;
+        arrays[ count++ ].bytes = numsets * assoc * sizeof(UINT16);
+        arrays[ count ].data    = shipReused;
+        arrays[ count++ ].bytes = numsets * sizeof(BITVECTOR);
+    }
+
+    if( ucpThreads ) 
+    {
+        arrays[ count ].data    = umonTags;
+        arrays[ count++ ].bytes = ucpThreads * umonSets * assoc * sizeof(Addr_t);
+        arrays[ count ].data    = umonHits;
+        arrays[ count++ ].bytes = ucpThreads * assoc * sizeof(COUNTER);
+        arrays[ count ].data    = ucpOwned;
+        arrays[ count++ ].bytes = numsets * ucpThreads * sizeof(BITVECTOR);
+        arrays[ count ].data    = ucpQuota;
+        arrays[ count++ ].bytes = ucpThreads * sizeof(UINT32);
+        arrays[ count ].data    = &ucpNextAlloc;
+        arrays[ count++ ].bytes = sizeof(ucpNextAlloc);
+    }
+
+    assert( count <= CRC_SNAPSHOT_MAX_ARRAYS );
+
+    return count;
+}
+
+COUNTER CACHE_REPLACEMENT_STATE::SnapshotBytes()
+{
+    CRC_SNAPSHOT_ARRAY arrays[ CRC_SNAPSHOT_MAX_ARRAYS ];
+    COUNTER            bytes = CRC_SnapshotBytes( arrays, SnapshotArrays( arrays, false ) );
+
+    return bytes + CRC_SnapshotBytes( arrays, SnapshotArrays( arrays, true ) );
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 //                                                                            //
-// This function finds a random victim in the cache set                       //
+// Writes the common and the policy section of a snapshot. OPT follows its    //
+// next-use index, and copies in epoch mode or with diagnostics keep state    //
+// outside the sections, so none of them take part in snapshots.              //
 //                                                                            //
 ////////////////////////////////////////////////////////////////////////////////
-INT32 CACHE_REPLACEMENT_STATE::Get_Random_Victim( UINT32 setIndex )
+bool CACHE_REPLACEMENT_STATE::SaveSnapshot( FILE *file )
 {
-    INT32 way = (rand() % assoc);
-    
-    return way;
+    CRC_SNAPSHOT_ARRAY arrays[ CRC_SNAPSHOT_MAX_ARRAYS ];
+
+    assert( nextUse == NULL && !epochMode && diag == NULL );
+
+    return CRC_SnapshotArrays( file, arrays, SnapshotArrays( arrays, false ), false )
+           && CRC_SnapshotArrays( file, arrays, SnapshotArrays( arrays, true ), false );
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 //                                                                            //
-// This function finds the SWITCH victim                                      //
+// Reads the common section of a snapshot in place, and the policy section    //
+// if policy (the snapshot is of the same policy). Otherwise the policy's     //
+// state stays as it started, and UCP allocates UCP_INTERVAL accesses on.     //
 //                                                                            //
 ////////////////////////////////////////////////////////////////////////////////
-INT32 CACHE_REPLACEMENT_STATE::Get_SWITCH_Victim( UINT32 setIndex )
+bool CACHE_REPLACEMENT_STATE::LoadSnapshot( FILE *file, bool policy )
 {
-    INT32   line=0;//line is passed by reference in the functions below
-    
-    if(currPolicy == LRU){
-        if(score.lru >= score.clock){
-            //if both the switch and scoreboard are at the LRU side, go with LRU
-            //victim algorithm
-            Get_MyLRU_Victim(setIndex,line);
-        }else{
-            //if there is disagreement between switch and scoreboard
-            //go with scoreboard's decision
-            Get_MyCLOCK_Victim(setIndex,line);
-        }        
-    }else if(currPolicy == CLOCK){// Famous CLOCK policy
-        if(score.clock >= score.lru){
-            //if both the switch and scoreboard are at the CLOCK side, go with CLOCK
-            //victim algorithm
-            Get_MyCLOCK_Victim(setIndex,line);
-        }else{
-            //if there is disagreement between switch and scoreboard
-            //go with scoreboard's decision
-            Get_MyLRU_Victim(setIndex,line);
-        }
+    CRC_SNAPSHOT_ARRAY arrays[ CRC_SNAPSHOT_MAX_ARRAYS ];
+
+    assert( nextUse == NULL && !epochMode && diag == NULL );
+
+    if( !CRC_SnapshotArrays( file, arrays, SnapshotArrays( arrays, false ), true ) ) 
+    {
+        return false;
+    }
+
+    if( policy ) 
+    {
+        return CRC_SnapshotArrays( file, arrays, SnapshotArrays( arrays, true ), true );
     }
 
-    // return mru line
-    return line;
+    ucpNextAlloc = mytimer + UCP_INTERVAL;
+
+    return true;
 }
+
 ////////////////////////////////////////////////////////////////////////////////
 //                                                                            //
-// This function implements the LRU update routine for the traditional        //
-// LRU replacement policy. The arguments to the function are the physical     //
-// way and set index.                                                         //
+// This function initializes the replacement policy hardware by creating      //
+// storage for the replacement state on a per-line/per-cache basis.           //
 //                                                                            //
 ////////////////////////////////////////////////////////////////////////////////
-void CACHE_REPLACEMENT_STATE::UpdateLRU( UINT32 setIndex, INT32 updateWayID )
+void CACHE_REPLACEMENT_STATE::InitReplacementState()
 {
-    // Determine current LRU stack position
-    UINT32 currLRUage = repl[ setIndex ][ updateWayID ].LRUage;
+    // Up to 16 ways keep their LRU stack packed in one word per set
+    packedLRU = (assoc <= CRC_PACKED_LRU_MAX_ASSOC);
+    lruStack  = (CRC_LRU_STACK *) CRC_AlignedCalloc( numsets, sizeof(CRC_LRU_STACK) );
+
+    // Wider caches keep per-line stack positions in one contiguous
+    // set-major block. The contestant's cacheLineAge shares the same
+    // entries as the true LRU state, so one access touches one host line
+    repl  = NULL;
 
-    // Update the stack position of all lines before the current line
-    // Update implies incremeting their stack positions by one
-    for(UINT32 way=0; way<assoc; way++) 
+    if( !packedLRU ) 
     {
-        if( repl[setIndex][way].LRUage < currLRUage ) 
+        repl  = (LINE_REPLACEMENT_STATE *) CRC_AlignedCalloc( numsets * assoc, sizeof(LINE_REPLACEMENT_STATE) );
+    }
+
+    // CLOCK keeps its used bits in one mask per set
+    assert(assoc <= 64);
+    wayMask  = CRC_WayMask( assoc );
+    usedMask = (BITVECTOR *) CRC_AlignedCalloc( numsets, sizeof(BITVECTOR) );
+    hand     = new UINT8 [numsets];
+
+    // OPT keeps the next use of every line
+    nextUse = NULL;
+
+    if( replPolicy == CRC_REPL_OPT || replPolicy == CRC_REPL_OPT_BYPASS ) 
+    {
+        nextUse = (COUNTER *) CRC_AlignedCalloc( numsets * assoc, sizeof(COUNTER) );
+        assert(nextUse);
+    }
+
+    // RRIP (and SHiP on top of it) keeps two RRPV bit planes per set
+    rrpvHi = rrpvLo = NULL;
+    rripPromotions = 0;
+    memset( rripInsertions, 0, sizeof(rripInsertions) );
+
+    if( RRIPPolicy() ) 
+    {
+        rrpvHi = (BITVECTOR *) CRC_AlignedCalloc( numsets, sizeof(BITVECTOR) );
+        rrpvLo = (BITVECTOR *) CRC_AlignedCalloc( numsets, sizeof(BITVECTOR) );
+        assert(rrpvHi && rrpvLo);
+    }
+
+    // SHiP counters start weakly reused, so a signature must lose a line
+    // before its fills are predicted dead
+    shct       = NULL;
+    shipSig    = NULL;
+    shipReused = NULL;
+    shipBypasses = shipDeadEvictions = 0;
+
+    if( replPolicy == CRC_REPL_SHIP || replPolicy == CRC_REPL_SHIP_BYPASS ) 
+    {
+        shct       = new UINT8[ 1 << SHIP_SHCT_BITS ];
+        shipSig    = (UINT16 *) CRC_AlignedCalloc( numsets * assoc, sizeof(UINT16) );
+        shipReused = (BITVECTOR *) CRC_AlignedCalloc( numsets, sizeof(BITVECTOR) );
+        assert(shipSig && shipReused);
+
+        memset( shct, 1, 1 << SHIP_SHCT_BITS );
+    }
+
+    // ensure that we were able to create replacement state
+    assert(lruStack && usedMask && (packedLRU || repl));
+
+    //CLOCK+LRU
+    //every set keeps both LRU and CLOCK state, so a follower set can change
+    //sides whenever PSEL crosses the midpoint
+    // Contestants:  ADD INITIALIZATION FOR YOUR HARDWARE HERE
+    for(UINT32 setIndex=0; setIndex<numsets; setIndex++) 
+    {
+        hand[ setIndex ] = 0; //initially, hand is pointing at first line in each set
+        usedMask[ setIndex ] = 0; //used flags are for clock
+        lruStack[ setIndex ] = CRC_PackedLRU_Init( assoc );
+
+        if( packedLRU ) continue;
+
+        LINE_REPLACEMENT_STATE *replSet = GetReplSet( setIndex );
+
+        for(UINT32 line=0; line<assoc; line++) 
         {
-            repl[setIndex][way].LRUage++;
+            // initialize stack position (for true LRU)
+            replSet[ line ].LRUage = line;
+
+            //cacheLineAge is for LRU aging
+            replSet[ line ].cacheLineAge = line;
         }
     }
-
-    // Set the LRU stack position of new line to be zero
-    repl[ setIndex ][ updateWayID ].LRUage = 0;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 //                                                                            //
-// This function implements the mru update routine for the traditional        //
-// mru replacement policy. The arguments to the function are the physical     //
-// way and set index.                                                         //
+// This function is called by the cache on every cache miss. The input        //
+// arguments are the thread id, set index, pointers to ways in current set    //
+// and the associativity.  We are also providing the PC, physical address,    //
+// and accesstype should you wish to use them at victim selection time.       //
+// The return value is the physical way index for the line being replaced.    //
+// Return -1 if you wish to bypass LLC.                                       //
+//                                                                            //
+// vicSet is the current set. You can access the contents of the set by       //
+// indexing using the wayID which ranges from 0 to assoc-1 e.g. vicSet[0]     //
+// is the first way and vicSet[4] is the 4th physical way of the cache.       //
+// Elements of LINE_STATE are defined in crc_cache_defs.h                     //
 //                                                                            //
 ////////////////////////////////////////////////////////////////////////////////
-void CACHE_REPLACEMENT_STATE::UpdateSWITCH( UINT32 setIndex, INT32 updateWayID, bool cacheHit )
+INT32 CACHE_REPLACEMENT_STATE::GetVictimInSet( UINT32 tid, UINT32 setIndex, const LINE_STATE *vicSet, UINT32 assoc,
+                                               Addr_t PC, Addr_t paddr, UINT32 accessType )
 {
-    // Determine current MRU stack position
-    UINT32 currcacheLineAge = myRepl[ setIndex ][ updateWayID ].cacheLineAge;
-    
-    probMissRate(cacheHit);
-    
-    if(currPolicy == LRU){
-        // Update the stack position of all lines before the current line
-        // Update implies incremeting their stack positions by one
-        for(UINT32 lineIndx=0; lineIndx<assoc; lineIndx++) 
-        {
-            if( myRepl[setIndex][lineIndx].cacheLineAge < currcacheLineAge ) 
-            {
-                myRepl[setIndex][lineIndx].cacheLineAge++;
-            }
-        }
-
-        // Set the MRU stack position of new line to be zero
-        myRepl[ setIndex ][ updateWayID ].cacheLineAge = 0;
-    }else{
-        if(cacheHit){ 
-            myRepl[ setIndex ][ updateWayID ].used = true;
-        }
+    // CRC_CACHE calls the policy's hook directly (see replacement_policies.h)
+    switch( replPolicy ) 
+    {
+      case CRC_REPL_LRU:
+        return REPL_POLICY<CRC_REPL_LRU>::Victim( this, tid, setIndex, PC, accessType );
+      case CRC_REPL_RANDOM:
+        return REPL_POLICY<CRC_REPL_RANDOM>::Victim( this, tid, setIndex, PC, accessType );
+      case CRC_REPL_CONTESTANT:
+        // Contestants:  ADD YOUR VICTIM SELECTION FUNCTION HERE
+        return REPL_POLICY<CRC_REPL_CONTESTANT>::Victim( this, tid, setIndex, PC, accessType );
+      case CRC_REPL_OPT:
+        return REPL_POLICY<CRC_REPL_OPT>::Victim( this, tid, setIndex, PC, accessType );
+      case CRC_REPL_OPT_BYPASS:
+        return REPL_POLICY<CRC_REPL_OPT_BYPASS>::Victim( this, tid, setIndex, PC, accessType );
+      case CRC_REPL_SRRIP:
+        return REPL_POLICY<CRC_REPL_SRRIP>::Victim( this, tid, setIndex, PC, accessType );
+      case CRC_REPL_BRRIP:
+        return REPL_POLICY<CRC_REPL_BRRIP>::Victim( this, tid, setIndex, PC, accessType );
+      case CRC_REPL_DRRIP:
+        return REPL_POLICY<CRC_REPL_DRRIP>::Victim( this, tid, setIndex, PC, accessType );
+      case CRC_REPL_SHIP:
+        return REPL_POLICY<CRC_REPL_SHIP>::Victim( this, tid, setIndex, PC, accessType );
+      case CRC_REPL_SHIP_BYPASS:
+        return REPL_POLICY<CRC_REPL_SHIP_BYPASS>::Victim( this, tid, setIndex, PC, accessType );
+      case CRC_REPL_UCP:
+        return REPL_POLICY<CRC_REPL_UCP>::Victim( this, tid, setIndex, PC, accessType );
     }
+
+    // We should never get here
+    assert(0);
+
+    return -1; // Returning -1 bypasses the LLC
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 //                                                                            //
-// This functon switchs the policy when misses hit threshold                  //
-// return true to switch policy, falsue to not switch                         //
+// This function is called by the cache after every cache hit/miss            //
+// The arguments are: the set index, the physical way of the cache,           //
+// the pointer to the physical line (should contestants need access           //
+// to information of the line filled or hit upon), the thread id              //
+// of the request, the PC of the request, the accesstype, and finall          //
+// whether the line was a cachehit or not (cacheHit=true implies hit)         //
 //                                                                            //
 ////////////////////////////////////////////////////////////////////////////////
-void CACHE_REPLACEMENT_STATE::probMissRate(bool cacheHit){
-    
-    //count the total access 
-    prob.access++;
-
-    //count the miss
-    if(!cacheHit){
-       prob.miss++;
-    }
-  
-    //check if we want to switch on every SWITCH_MARGIN access 
-    
-    //prob.access >= SWITCH_MARGIN 
-    //Meaning we have reached probe period, 1 probe period = SWITCH_MARGIN accesses 
-    //SWITCH_MARGIN is constant defined in .h file
-    if(prob.access >= SWITCH_MARGIN){ 
-        //we switch if the misses are more than 1/SWITCH_THRES of the accesses %
-        if((prob.miss * SWITCH_THRES) > prob.access){
-            if(currPolicy == LRU){
-                currPolicy = CLOCK;
-            }else if(currPolicy == CLOCK){
-                currPolicy = LRU;
-            }
-        //if current switch can keep the miss rate low, we give it a point
-        }else{
-            if(currPolicy == LRU){
-                score.lru++;
-            }else if(currPolicy == CLOCK){
-                score.clock++;
-            }
-        }
-        
-        //reset prob for next cycle (next SWITCH_MARGIN accesses)
-        prob.access = 0;
-        prob.miss = 0;
-        
-        //if lru AND clock have finished this round of competition, reset their score
-        //for next round
-        if((score.lru+score.clock)>SCORE_CHECK_ROUND){
-            score.lru = LRU_INIT_SCORE;
-            score.clock = CLOCK_INIT_SCORE;
-        }
+void CACHE_REPLACEMENT_STATE::UpdateReplacementState( 
+    UINT32 setIndex, INT32 updateWayID, const LINE_STATE *currLine, 
+    UINT32 tid, Addr_t PC, UINT32 accessType, bool cacheHit )
+{
+    // What replacement policy?
+    switch( replPolicy ) 
+    {
+      case CRC_REPL_LRU:
+        REPL_POLICY<CRC_REPL_LRU>::Update( this, setIndex, updateWayID, tid, PC, accessType, cacheHit );
+        break;
+      case CRC_REPL_RANDOM:
+        REPL_POLICY<CRC_REPL_RANDOM>::Update( this, setIndex, updateWayID, tid, PC, accessType, cacheHit );
+        break;
+      case CRC_REPL_CONTESTANT:
+        // Contestants:  ADD YOUR UPDATE REPLACEMENT STATE FUNCTION HERE
+        // Feel free to use any of the input parameters to make
+        // updates to your replacement policy
+        REPL_POLICY<CRC_REPL_CONTESTANT>::Update( this, setIndex, updateWayID, tid, PC, accessType, cacheHit );
+        break;
+      case CRC_REPL_OPT:
+        REPL_POLICY<CRC_REPL_OPT>::Update( this, setIndex, updateWayID, tid, PC, accessType, cacheHit );
+        break;
+      case CRC_REPL_OPT_BYPASS:
+        REPL_POLICY<CRC_REPL_OPT_BYPASS>::Update( this, setIndex, updateWayID, tid, PC, accessType, cacheHit );
+        break;
+      case CRC_REPL_SRRIP:
+        REPL_POLICY<CRC_REPL_SRRIP>::Update( this, setIndex, updateWayID, tid, PC, accessType, cacheHit );
+        break;
+      case CRC_REPL_BRRIP:
+        REPL_POLICY<CRC_REPL_BRRIP>::Update( this, setIndex, updateWayID, tid, PC, accessType, cacheHit );
+        break;
+      case CRC_REPL_DRRIP:
+        REPL_POLICY<CRC_REPL_DRRIP>::Update( this, setIndex, updateWayID, tid, PC, accessType, cacheHit );
+        break;
+      case CRC_REPL_SHIP:
+        REPL_POLICY<CRC_REPL_SHIP>::Update( this, setIndex, updateWayID, tid, PC, accessType, cacheHit );
+        break;
+      case CRC_REPL_SHIP_BYPASS:
+        REPL_POLICY<CRC_REPL_SHIP_BYPASS>::Update( this, setIndex, updateWayID, tid, PC, accessType, cacheHit );
+        break;
+      case CRC_REPL_UCP:
+        REPL_POLICY<CRC_REPL_UCP>::Update( this, setIndex, updateWayID, tid, PC, accessType, cacheHit );
+        break;
     }
 }
+
 ////////////////////////////////////////////////////////////////////////////////
 //                                                                            //
 // The function prints the statistics for the cache                           //
@@ -433,8 +677,62 @@ ostream & CACHE_REPLACEMENT_STATE::PrintStats(ostream &out)
         out<<"LRU"<<endl;
     }else if(replPolicy == CRC_REPL_RANDOM){
         out<<"RANDOM"<<endl;
+    }else if(replPolicy == CRC_REPL_OPT){
+        out<<"OPT"<<endl;
+    }else if(replPolicy == CRC_REPL_OPT_BYPASS){
+        out<<"OPT (bypass)"<<endl;
+    }else if(replPolicy == CRC_REPL_UCP){
+        out<<"UCP"<<endl;
+        out<<"\tMonitored Sets:   "<<umonSets<<" of "<<numsets<<" per thread"<<endl;
+        out<<"\tAllocations:      "<<ucpAllocations<<endl;
+
+        for(UINT32 t=0; t<ucpThreads; t++){
+            out<<"\tThread "<<t<<" Ways:    "<<ucpQuota[t]<<" of "<<assoc;
+
+            if(ucpAllocations){
+                out<<", "<<(double) ucpQuotaSum[t] / ucpAllocations<<" on average";
+            }
+            out<<endl;
+        }
+    }else if(RRIPPolicy()){
+        const char *names[] = { "SRRIP", "BRRIP", "DRRIP", "SHiP", "SHiP (bypass)" };
+        out<<names[ replPolicy - CRC_REPL_SRRIP ]<<endl;
+        out<<"\tInsertions:       "<<rripInsertions[ RRIP_MAX_RRPV - 1 ]<<" at RRPV "<<(RRIP_MAX_RRPV - 1)
+           <<", "<<rripInsertions[ RRIP_MAX_RRPV ]<<" at RRPV "<<RRIP_MAX_RRPV<<endl;
+        out<<"\tPromotions:       "<<rripPromotions<<endl;
+
+        if(replPolicy == CRC_REPL_DRRIP){
+            out<<"\tLeader Sets:      "<<(numsets >> duelShift)<<" SRRIP, "<<(numsets >> duelShift)<<" BRRIP"<<endl;
+            out<<"\tLeader Misses:    "<<leaderMisses[ SRRIP ]<<" SRRIP, "<<leaderMisses[ BRRIP ]<<" BRRIP"<<endl;
+            out<<"\tFollower Fills:   "<<followerVictims[ SRRIP ]<<" SRRIP, "<<followerVictims[ BRRIP ]<<" BRRIP"<<endl;
+            out<<"\tPSEL:             "<<psel<<" of "<<PSEL_MAX<<endl;
+        }
+
+        if(shct){
+            UINT32 deadSigs = 0;
+            for(UINT32 i=0; i<(1U << SHIP_SHCT_BITS); i++) deadSigs += (shct[i] == 0);
+
+            out<<"\tDead Evictions:   "<<shipDeadEvictions<<endl;
+            out<<"\tBypasses:         "<<shipBypasses<<endl;
+            out<<"\tDead Signatures:  "<<deadSigs<<" of "<<(1U << SHIP_SHCT_BITS)<<endl;
+        }
     }else{
         out<<"leon"<<endl;
+        out<<"\tLeader Sets:      "<<(numsets >> duelShift)<<" LRU, "<<(numsets >> duelShift)<<" CLOCK"<<endl;
+        out<<"\tLeader Misses:    "<<leaderMisses[ LRU ]<<" LRU, "<<leaderMisses[ CLOCK ]<<" CLOCK"<<endl;
+        out<<"\tFollower Victims: "<<followerVictims[ LRU ]<<" LRU, "<<followerVictims[ CLOCK ]<<" CLOCK"<<endl;
+        out<<"\tPSEL:             "<<psel<<" of "<<PSEL_MAX<<endl;
+    }
+
+    if(diag){
+        //close the PSEL trajectory at the last access
+        diag->Scoreboard( psel, DuelWinner(), mytimer );
+
+        if(replPolicy == CRC_REPL_DRRIP){
+            diag->Print( out, "SRRIP", "BRRIP" );
+        }else{
+            diag->Print( out, "LRU", "CLOCK" );
+        }
     }
     return out;
     
@@ -20,20 +20,41 @@
 #include <cassert>
 #include "utils.h"
 #include "crc_cache_defs.h"
+#include "opt_index.h"
+#include "repl_diagnostics.h"
+#include "crc_snapshot.h"
 
 #define UINT8       unsigned char
+#define UINT16      unsigned short
 
-#define SWITCH_THRES 4
-#define SWITCH_MARGIN 100
-#define SCORE_CHECK_ROUND 5
-#define LRU_INIT_SCORE 0
-#define CLOCK_INIT_SCORE 0
+#define DUEL_LEADER_SETS 32     // leader sets per policy (at most 1/8 of the sets)
+#define PSEL_BITS 10
+#define PSEL_MAX ((1 << PSEL_BITS) - 1)
+
+#define RRIP_MAX_RRPV 3         // 2-bit re-reference prediction values
+#define RRIP_BIP_EPSILON 32     // BRRIP inserts 1 in 32 fills at RRPV 2
+
+#define SHIP_SHCT_BITS 14       // 16K signature history counters
+#define SHIP_COUNTER_MAX 7      // 3-bit saturating counters
+#define SHIP_BYPASS_EPSILON 32  // 1 in 32 predicted-dead fills still cached
+
+#define UCP_MONITOR_SETS 32     // sets shadowed by the utility monitor of every thread
+#define UCP_INTERVAL (1 << 15)  // accesses between way allocations
+#define UCP_NO_TAG (~0ULL)      // empty monitor entry, above every line tag
 // Replacement Policies Supported
 typedef enum 
 {
     CRC_REPL_LRU        = 0,
     CRC_REPL_RANDOM     = 1,
-    CRC_REPL_CONTESTANT = 2
+    CRC_REPL_CONTESTANT = 2,
+    CRC_REPL_OPT        = 3,    // Belady OPT, needs a next-use index
+    CRC_REPL_OPT_BYPASS = 4,    // OPT that bypasses lines used after all others
+    CRC_REPL_SRRIP      = 5,    // static RRIP, fills at RRPV 2
+    CRC_REPL_BRRIP      = 6,    // bimodal RRIP, fills mostly at RRPV 3
+    CRC_REPL_DRRIP      = 7,    // SRRIP and BRRIP set dueling
+    CRC_REPL_SHIP       = 8,    // SRRIP with PC-signature insertion
+    CRC_REPL_SHIP_BYPASS = 9,   // SHiP that bypasses predicted-dead fills
+    CRC_REPL_UCP        = 10    // LRU with utility-based way partitioning across threads
 } ReplacemntPolicy;
 
 //switchable policy supported
@@ -43,48 +64,126 @@ typedef enum
     CLOCK = 1
 }SWITCHABLE_POLICY;
 
-// Replacement State Per Cache Line
+//the two sides of the DRRIP duel, in the places of LRU and CLOCK
+typedef enum
+{
+    SRRIP = 0,
+    BRRIP = 1
+}RRIP_INSERTION;
+
+// Replacement State Per Cache Line (only kept for caches wider than the
+// packed LRU stacks; CLOCK used bits live in a per-set mask)
 typedef struct
 {
     UINT32  LRUage;
 
     // CONTESTANTS: Add extra state per cache line here
     UINT32  cacheLineAge;
-    bool    used;
 } LINE_REPLACEMENT_STATE;
 
-//set miss threshold
-typedef struct
-{
-    UINT32 access;
-    UINT32 miss;
-} MISS_PROPOTION;
+// The per-access hooks of each policy, specialised in replacement_policies.h
+template <UINT32 POLICY> struct REPL_POLICY;
 
-//scoreboard for each policy
-typedef struct
-{
-    COUNTER lru;
-    COUNTER clock;
-}SCORE_BOARD;
 // The implementation for the cache replacement policy
 class CACHE_REPLACEMENT_STATE
 {
+    template <UINT32 POLICY> friend struct REPL_POLICY;
+    template <bool BYPASS> friend struct REPL_OPT_POLICY;
+    template <UINT32 POLICY> friend struct REPL_RRIP_POLICY;
+    template <bool BYPASS> friend struct REPL_SHIP_POLICY;
 
   private:
     UINT32 numsets;
     UINT32 assoc;
     UINT32 replPolicy;
+    BITVECTOR wayMask;
     
-    LINE_REPLACEMENT_STATE   **repl;
+    // Per-line state for all sets, set-major (numsets x assoc), one block
+    LINE_REPLACEMENT_STATE   *repl;
+
+    // Packed LRU stacks, one 64-bit word per set with a 4-bit stack position
+    // per way. Used instead of LRUage/cacheLineAge when assoc <= 16; the true
+    // LRU policy and the contestant's LRU side share the same word
+    bool                      packedLRU;
+    CRC_LRU_STACK            *lruStack;
 
     COUNTER mytimer;  // tracks # of references to the cache
 
+    // Private rand() stream of this cache (seed 1, the default of rand()),
+    // so caches simulated side by side draw the same victims as alone
+    CRC_RAND_STATE randState;
+
+    // Belady OPT: next use (in mytimer references) of every line, set-major,
+    // and of the current reference, read from the next-use index as the
+    // timer advances
+    OPT_INDEX_READER *nextUseIndex;
+    COUNTER          *nextUse;
+    COUNTER           currNextUse;
+
+    // RRIP: the 2-bit RRPV of every way as two bit planes per set (bit w of
+    // rrpvHi/rrpvLo is the high/low bit of way w), so a victim search and
+    // the aging of a whole set are a few mask operations
+    BITVECTOR        *rrpvHi;
+    BITVECTOR        *rrpvLo;
+    COUNTER           rripInsertions[ RRIP_MAX_RRPV + 1 ];  // fills per RRPV
+    COUNTER           rripPromotions;                       // hits
+
+    // SHiP: saturating counters indexed by the signature (hashed PC, thread,
+    // writeback and prefetch bits) of the fill, counting up on hits to lines
+    // it filled and down when such a line is evicted without a hit. Every
+    // line keeps the signature that filled it, and every set a mask of its
+    // reused lines
+    UINT8            *shct;
+    UINT16           *shipSig;
+    BITVECTOR        *shipReused;
+    COUNTER           shipBypasses;
+    COUNTER           shipDeadEvictions;
+
+    // Epoch mode, for a cache whose sets are split over worker threads that
+    // each run a copy of it: the state shared by all sets (PSEL and the SHiP
+    // counters) stays fixed during an epoch while every copy collects its
+    // changes as deltas, MergeEpoch applies their sum to all copies, and the
+    // random draws come from a stream per set. The results then do not
+    // depend on how the sets are split
+    bool              epochMode;
+    INT32             pselDelta;
+    INT32            *shctDelta;
+    UINT32           *setDraws;    // draws so far per set
+
+    // UCP: the utility monitor (UMON) of every thread is an LRU tag directory
+    // for 1 of every 2^umonShift sets, as if the thread had the cache to
+    // itself, and counts the thread's hits per stack position. Every
+    // UCP_INTERVAL accesses the lookahead allocation turns the counts into a
+    // way quota per thread and halves them. A thread that misses below its
+    // quota evicts a line of a thread above its own, otherwise one of its
+    // own lines, LRU first. Every set keeps a mask of the ways each thread
+    // filled (set-major, numsets x ucpThreads)
+    UINT32            ucpThreads;
+    UINT32            umonShift;
+    UINT32            umonSets;
+    Addr_t           *umonTags;     // per thread and monitored set, MRU first
+    COUNTER          *umonHits;     // per thread and stack position
+    BITVECTOR        *ucpOwned;
+    UINT32           *ucpQuota;
+    COUNTER           ucpNextAlloc;
+    COUNTER           ucpAllocations;
+    COUNTER          *ucpQuotaSum;  // quotas summed over the allocations
+
+    // Reuse and dead-block diagnostics, NULL unless enabled
+    REPL_DIAGNOSTICS *diag;
+
     // CONTESTANTS:  Add extra state for cache here
-    LINE_REPLACEMENT_STATE  **myRepl;   //separate my Replacement policy from default
-    MISS_PROPOTION  prob;   //a probe for miss proportion
-    SCORE_BOARD     score;  //a score board for the CLOCK vs LRU
-    SWITCHABLE_POLICY    currPolicy;    //indicate current policy
-    UINT8   *hand;  //a hand for CLOCK, only use 4 bit per set (16-way assoc)
+    //set dueling: in every region of 2^duelShift sets one leader set always
+    //runs LRU and one always runs CLOCK, a PSEL_BITS saturating counter goes
+    //up on LRU leader misses and down on CLOCK leader misses, and the other
+    //(follower) sets run the policy that is missing less. DRRIP duels SRRIP
+    //against BRRIP the same way
+    UINT32  duelShift;
+    UINT32  psel;
+    COUNTER leaderMisses[2];    //per SWITCHABLE_POLICY or RRIP_INSERTION
+    COUNTER followerVictims[2]; //per SWITCHABLE_POLICY or RRIP_INSERTION
+    UINT8   *hand;  //a hand for CLOCK, only use 6 bit per set (up to 64-way assoc)
+    BITVECTOR *usedMask;    //CLOCK used bits, bit w for way w of the set
   public:
 
     // The constructor CAN NOT be changed
@@ -95,7 +194,46 @@ class CACHE_REPLACEMENT_STATE
 
     void   SetReplacementPolicy( UINT32 _pol ) { replPolicy = _pol; } 
     
-    void   IncrementTimer() { mytimer++; } 
+    void   IncrementTimer() 
+    { 
+        mytimer++; 
+
+        if( nextUseIndex ) 
+        {
+            UINT32 distance = nextUseIndex->Next();
+            currNextUse = distance ? mytimer + distance : OPT_NEVER;
+        }
+    } 
+
+    void   SetNextUseIndex( OPT_INDEX_READER *_index ) { nextUseIndex = _index; }
+
+    // The threads sharing the cache, for the policies that tell them apart
+    void   SetThreads( UINT32 _threads );
+
+    // Every access to the cache, hit or miss, for UCP's utility monitors
+    inline void MonitorAccess( UINT32 tid, UINT32 setIndex, Addr_t tag, UINT32 accessType );
+
+    void   SetEpochMode();
+    static void MergeEpoch( CACHE_REPLACEMENT_STATE **states, UINT32 count );
+    void   MergeStats( const CACHE_REPLACEMENT_STATE *other );
+
+    // Warm-cache snapshots (see crc_snapshot.h): the common and the policy
+    // section. A state of another policy loads only the common section
+    COUNTER SnapshotBytes();
+    bool   SaveSnapshot( FILE *file );
+    bool   LoadSnapshot( FILE *file, bool policy );
+
+    // The set-dueling scoreboard of CONTESTANT and DRRIP: PSEL, the side
+    // (SWITCHABLE_POLICY or RRIP_INSERTION) the follower sets run and the
+    // misses of each side's leader sets
+    bool    Dueling() { return DuelPolicy(); }
+    UINT32  Psel() { return psel; }
+    UINT32  FollowerSide() { return DuelWinner(); }
+    COUNTER LeaderMisses( UINT32 side ) { return leaderMisses[ side ]; }
+
+    // Diagnostics, fed by CRC_CACHE on the access path it keeps for them
+    void   EnableDiagnostics();
+    REPL_DIAGNOSTICS *Diagnostics() { return diag; }
 
     void   UpdateReplacementState( UINT32 setIndex, INT32 updateWayID, const LINE_STATE *currLine, 
                                    UINT32 tid, Addr_t PC, UINT32 accessType, bool cacheHit );
@@ -105,15 +243,88 @@ class CACHE_REPLACEMENT_STATE
   private:
     
     void   InitReplacementState();
+    LINE_REPLACEMENT_STATE *GetReplSet( UINT32 setIndex ) { return &repl[ setIndex * assoc ]; }
     INT32  Get_Random_Victim( UINT32 setIndex );
 
     INT32  Get_LRU_Victim( UINT32 setIndex );
+    INT32  Get_OPT_Victim( UINT32 setIndex, bool bypass );
+    void   UpdateOPT( UINT32 setIndex, INT32 updateWayID );
     INT32   Get_SWITCH_Victim( UINT32 setIndex );
     void    Get_MyLRU_Victim(UINT32 setIndex, INT32 &line);
     void    Get_MyCLOCK_Victim(UINT32 setIndex, INT32 &line);
     void   UpdateLRU( UINT32 setIndex, INT32 updateWayID );
     void    UpdateSWITCH( UINT32 setIndex, INT32 updateWayID, bool cacheHit);
-    void    probMissRate(bool cacheHit);
+    INT32   Get_RRIP_Victim( UINT32 setIndex );
+    void    UpdateRRIP( UINT32 setIndex, INT32 updateWayID, bool cacheHit, UINT32 policy );
+    void    DuelMiss( UINT32 setIndex );
+    INT32   Get_SHiP_Victim( UINT32 tid, UINT32 setIndex, Addr_t PC, UINT32 accessType, bool bypass );
+    void    UpdateSHiP( UINT32 setIndex, INT32 updateWayID, UINT32 tid, Addr_t PC, UINT32 accessType, bool cacheHit );
+    INT32   Get_UCP_Victim( UINT32 tid, UINT32 setIndex );
+    INT32   Get_LRU_Victim_Among( UINT32 setIndex, BITVECTOR ways );
+    void    UpdateUCP( UINT32 setIndex, INT32 updateWayID, UINT32 tid, bool cacheHit );
+    void    AllocateWays();
+    UINT32  SnapshotArrays( CRC_SNAPSHOT_ARRAY *arrays, bool policy );
+
+    bool    DuelPolicy() { return replPolicy == CRC_REPL_CONTESTANT || replPolicy == CRC_REPL_DRRIP; }
+
+    bool    RRIPPolicy()
+    {
+        return replPolicy == CRC_REPL_SRRIP || replPolicy == CRC_REPL_BRRIP || replPolicy == CRC_REPL_DRRIP
+               || replPolicy == CRC_REPL_SHIP || replPolicy == CRC_REPL_SHIP_BYPASS;
+    }
+
+    UINT32  ShipSignature( UINT32 tid, Addr_t PC, UINT32 accessType )
+    {
+        Addr_t key = (PC << 5) | (tid << 1) | (accessType == ACCESS_WRITEBACK);
+
+        // Prefetches learn apart from the demand fills of the same PC
+        key ^= (Addr_t) (accessType == ACCESS_PREFETCH) << 63;
+
+        return CRC_Mix64( key ) >> (64 - SHIP_SHCT_BITS);
+    }
+
+    //the side PSEL currently favours for follower sets
+    UINT32  DuelWinner() { return (psel > PSEL_MAX / 2) ? 1 : 0; }
+
+    UINT32  Rand( UINT32 setIndex )
+    {
+        if( !epochMode ) return CRC_Rand( &randState );
+
+        return CRC_Mix64( ((Addr_t) setIndex << 32) | setDraws[ setIndex ]++ ) >> 33;
+    }
+
+    void    ShctAdd( UINT32 sig, INT32 delta )
+    {
+        if( epochMode ) 
+        {
+            shctDelta[ sig ] += delta;
+        }
+        else if( (delta > 0) ? (shct[ sig ] < SHIP_COUNTER_MAX) : (shct[ sig ] > 0) ) 
+        {
+            shct[ sig ] += delta;
+        }
+    }
+
+    void    SetRRPV( UINT32 setIndex, INT32 way, UINT32 rrpv )
+    {
+        BITVECTOR bit = 1ULL << way;
+
+        rrpvHi[ setIndex ] = (rrpvHi[ setIndex ] & ~bit) | ((rrpv & 2) ? bit : 0);
+        rrpvLo[ setIndex ] = (rrpvLo[ setIndex ] & ~bit) | ((rrpv & 1) ? bit : 0);
+    }
+
+    //the policy a leader set is dedicated to, -1 for follower sets
+    INT32   DuelLeader( UINT32 setIndex )
+    {
+        UINT32 regionSize = 1 << duelShift;
+        UINT32 region     = setIndex >> duelShift;
+        UINT32 offset     = setIndex & (regionSize - 1);
+
+        //complement-select: LRU at the region number, CLOCK half a region away
+        if(offset == (region & (regionSize - 1))) return LRU;
+        if(offset == ((region + regionSize / 2) & (regionSize - 1))) return CLOCK;
+        return -1;
+    }
 };
 
 
@@ -25,6 +25,8 @@
 
 #include <string>
 #include <iostream>
+#include <cstdlib>
+#include <cstring>
 using namespace std;
 
 #ifdef CRC_KIT 
@@ -66,5 +68,184 @@ static inline INT32 CRC_CeilLog2(UINT32 n)
     return CRC_FloorLog2(n - 1) + 1;
 }
 
+// Index of the least significant set bit.
+// @returns 64 if n == 0.
+static inline INT32 CRC_CountTrailingZeros64(unsigned long long n)
+{
+    return n ? __builtin_ctzll(n) : 64;
+}
+
+// Number of set bits.
+static inline INT32 CRC_PopCount64(unsigned long long n)
+{
+    return __builtin_popcountll(n);
+}
+
+// Mask with one bit per way of a set (ways must not exceed 64).
+static inline unsigned long long CRC_WayMask(UINT32 assoc)
+{
+    return (assoc >= 64) ? ~0ULL : ((1ULL << assoc) - 1);
+}
+
+// Rotates the low 'ways' bits of n right by r (0 <= r < ways <= 64), so that
+// bit r moves to bit 0.
+static inline unsigned long long CRC_RotateWaysRight(unsigned long long n, UINT32 r, UINT32 ways)
+{
+    if (r == 0) return n;
+
+    return ((n >> r) | (n << (ways - r))) & CRC_WayMask(ways);
+}
+
+// Inverse of CRC_RotateWaysRight: bit 0 moves to bit r.
+static inline unsigned long long CRC_RotateWaysLeft(unsigned long long n, UINT32 r, UINT32 ways)
+{
+    if (r == 0) return n;
+
+    return ((n << r) | (n >> (ways - r))) & CRC_WayMask(ways);
+}
+
+// Packed LRU stack: a 4-bit stack position per way, up to 16 ways in one
+// 64-bit word (way w in bits 4w..4w+3). Position 0 is MRU and assoc-1 is LRU.
+// Nibbles of ways beyond assoc hold 15 and never take part in an update.
+typedef unsigned long long CRC_LRU_STACK;
+
+#define CRC_PACKED_LRU_MAX_ASSOC 16
+
+#define CRC_SWAR_LOW_NIBBLES 0x0F0F0F0F0F0F0F0FULL
+#define CRC_SWAR_BYTE_ONES   0x0101010101010101ULL
+#define CRC_SWAR_BYTE_HIGHS  0x8080808080808080ULL
+
+// Initial stack: way w at position w.
+static inline CRC_LRU_STACK CRC_PackedLRU_Init(UINT32 assoc)
+{
+    CRC_LRU_STACK stack = 0;
+
+    for (UINT32 way = 0; way < CRC_PACKED_LRU_MAX_ASSOC; way++)
+    {
+        stack |= (CRC_LRU_STACK) (way < assoc ? way : 0xf) << (4 * way);
+    }
+
+    return stack;
+}
+
+static inline UINT32 CRC_PackedLRU_Position(CRC_LRU_STACK stack, UINT32 way)
+{
+    return (UINT32) (stack >> (4 * way)) & 0xf;
+}
+
+// Moves way to the MRU position and ages every way that was above it.
+// Nibbles are split into even/odd byte lanes so each lane has a spare high
+// bit: (x | 0x80) - pos keeps bit 7 set exactly when x >= pos.
+static inline CRC_LRU_STACK CRC_PackedLRU_Promote(CRC_LRU_STACK stack, UINT32 way)
+{
+    CRC_LRU_STACK pos  = ((stack >> (4 * way)) & 0xf) * CRC_SWAR_BYTE_ONES;
+    CRC_LRU_STACK even = stack & CRC_SWAR_LOW_NIBBLES;
+    CRC_LRU_STACK odd  = (stack >> 4) & CRC_SWAR_LOW_NIBBLES;
+
+    even += (~((even | CRC_SWAR_BYTE_HIGHS) - pos) & CRC_SWAR_BYTE_HIGHS) >> 7;
+    odd  += (~((odd  | CRC_SWAR_BYTE_HIGHS) - pos) & CRC_SWAR_BYTE_HIGHS) >> 7;
+
+    return (even | (odd << 4)) & ~(0xfULL << (4 * way));
+}
+
+// Returns the lowest way whose stack position equals pos.
+// @returns 16 if no way holds pos.
+static inline INT32 CRC_PackedLRU_Find(CRC_LRU_STACK stack, UINT32 pos)
+{
+    CRC_LRU_STACK key  = pos * CRC_SWAR_BYTE_ONES;
+    CRC_LRU_STACK even = (stack & CRC_SWAR_LOW_NIBBLES) ^ key;
+    CRC_LRU_STACK odd  = ((stack >> 4) & CRC_SWAR_LOW_NIBBLES) ^ key;
+
+    // A lane is zero exactly when (y | 0x80) - 1 clears bit 7
+    even = ~((even | CRC_SWAR_BYTE_HIGHS) - CRC_SWAR_BYTE_ONES) & CRC_SWAR_BYTE_HIGHS;
+    odd  = ~((odd  | CRC_SWAR_BYTE_HIGHS) - CRC_SWAR_BYTE_ONES) & CRC_SWAR_BYTE_HIGHS;
+
+    return CRC_CountTrailingZeros64((even >> 7) | (odd >> 3)) >> 2;
+}
+
+// Host cache line size used to align the simulator's set-major arrays.
+#define CRC_HOST_LINE_SIZE 64
+
+// Allocates zeroed storage aligned to a host cache line so that a set of the
+// simulated cache never straddles more host lines than its size requires.
+// @returns NULL if the allocation failed.
+static inline void *CRC_AlignedCalloc(size_t count, size_t size)
+{
+    void   *ptr   = NULL;
+    size_t  bytes = count * size;
+
+    // Round up so the allocation covers whole host lines
+    bytes = (bytes + CRC_HOST_LINE_SIZE - 1) & ~((size_t) CRC_HOST_LINE_SIZE - 1);
+
+    if (posix_memalign(&ptr, CRC_HOST_LINE_SIZE, bytes)) return NULL;
+
+    return memset(ptr, 0, bytes);
+}
+
+// Private pseudo-random stream that reproduces the sequence of glibc's
+// rand() after srand(seed), so several caches can each draw their own
+// stream in one process. The additive generator keeps its last 32 words in
+// a ring: r[i] = r[i-31] + r[i-3], output r[i] >> 1.
+typedef struct
+{
+    UINT32  r[32];
+    UINT32  i;
+} CRC_RAND_STATE;
+
+static inline UINT32 CRC_Rand(CRC_RAND_STATE *state)
+{
+    UINT32 i = state->i++;
+    UINT32 v = state->r[(i + 1) & 31] + state->r[(i + 29) & 31];
+
+    state->r[i & 31] = v;
+
+    return v >> 1;
+}
+
+static inline void CRC_SeedRand(CRC_RAND_STATE *state, UINT32 seed)
+{
+    INT32 word = seed ? (INT32) seed : 1;
+
+    state->r[0] = word;
+
+    // Lehmer seeding of the first 31 words, as srandom() does
+    for (UINT32 i = 1; i < 31; i++)
+    {
+        INT32 hi = word / 127773;
+        INT32 lo = word % 127773;
+
+        word = 16807 * lo - 2836 * hi;
+        if (word < 0) word += 2147483647;
+
+        state->r[i] = word;
+    }
+
+    for (UINT32 i = 31; i < 34; i++)
+    {
+        state->r[i & 31] = state->r[(i + 1) & 31];
+    }
+
+    // Discard the first 310 outputs
+    state->i = 34;
+
+    for (UINT32 i = 34; i < 344; i++)
+    {
+        CRC_Rand(state);
+    }
+}
+
+// 64-bit finalizer of MurmurHash3. Spreads every bit of a line address
+// over the whole word, for hashing and hash-based sampling of lines.
+static inline unsigned long long CRC_Mix64(unsigned long long x)
+{
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+
+    return x;
+}
+
 #endif
 